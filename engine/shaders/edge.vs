@@ -1,7 +1,7 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#include "include/vertex_normal.glsl"
 
 layout (std140) uniform Matrices
 {
@@ -11,7 +11,11 @@ layout (std140) uniform Matrices
 
 uniform mat4 model;
 
+#include "include/skinning.glsl"
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos + 0.01 * aNormal, 1.0);
+    mat4 skin = skinMatrix();
+    vec3 normal = normalize(mat3(skin) * decodeNormal());
+    gl_Position = projection * view * model * (skin * vec4(aPos, 1.0) + vec4(0.01 * normal, 0.0));
 }
\ No newline at end of file
@@ -2,13 +2,19 @@
 out vec4 FragColor;
 
 in vec2 TexCoords;
+in vec3 Normal;
 
 uniform sampler2D floor_texture;
+uniform vec3 lightDirection;
+
+#include "include/ambient_sh.glsl"
 
 void main()
 {
     vec4 texColor = texture(floor_texture, TexCoords);
     if(texColor.a < 0.1)
         discard;
-    FragColor = texColor;
+    vec3  normal  = normalize(Normal);
+    float diffuse = dot(normal, -normalize(lightDirection)) * 0.5 + 0.5;
+    FragColor = vec4(texColor.rgb * (0.6 * evalAmbient(normal) + 0.7 * diffuse), texColor.a);
 }
\ No newline at end of file
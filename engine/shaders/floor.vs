@@ -3,6 +3,7 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
+out vec3 Normal;
 
 layout (std140) uniform Matrices
 {
@@ -15,5 +16,7 @@ uniform mat4 model;
 void main()
 {
     TexCoords = aTexCoords;
+    // the plane faces +y
+    Normal = mat3(model) * vec3(0.0, 1.0, 0.0);
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
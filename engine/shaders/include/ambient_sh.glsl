@@ -0,0 +1,14 @@
+// skybox ambient light as 9 SH coefficients, scaled so evaluating the polynomials is all that is left (see EnvironmentLighting)
+layout (std140) uniform AmbientSH
+{
+    vec4 sh[9];
+};
+
+vec3 evalAmbient(vec3 n)
+{
+    vec3 ambient = sh[0].rgb +
+                   sh[1].rgb * n.y + sh[2].rgb * n.z + sh[3].rgb * n.x +
+                   sh[4].rgb * (n.x * n.y) + sh[5].rgb * (n.y * n.z) + sh[6].rgb * (3.0 * n.z * n.z - 1.0) +
+                   sh[7].rgb * (n.x * n.z) + sh[8].rgb * (n.x * n.x - n.y * n.y);
+    return max(ambient, vec3(0.0));
+}
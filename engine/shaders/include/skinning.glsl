@@ -0,0 +1,29 @@
+// bone attributes and palette of skinned layouts (see VertexLayout), compiled with HD2D_SKINNED
+#if defined(HD2D_SKINNED)
+#if defined(HD2D_OCT_NORMAL) || defined(HD2D_QTANGENT)
+layout (location = 5) in uvec4 aBoneIDs;
+#else
+layout (location = 5) in ivec4 aBoneIDs;
+#endif
+layout (location = 6) in vec4 aWeights;
+
+// bone palette of the skeleton instance being drawn, MAX_SKELETON_BONES matrices (see Animator)
+layout (std140) uniform BonePalette
+{
+    mat4 bones[256];
+};
+
+// static meshes of a skinned model carry no weights and stay where they are
+mat4 skinMatrix()
+{
+    if (aWeights.x + aWeights.y + aWeights.z + aWeights.w <= 0.0)
+        return mat4(1.0);
+    return bones[int(aBoneIDs.x)] * aWeights.x + bones[int(aBoneIDs.y)] * aWeights.y +
+           bones[int(aBoneIDs.z)] * aWeights.z + bones[int(aBoneIDs.w)] * aWeights.w;
+}
+#else
+mat4 skinMatrix()
+{
+    return mat4(1.0);
+}
+#endif
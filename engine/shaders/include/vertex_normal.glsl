@@ -0,0 +1,27 @@
+// normal attribute of every vertex layout (see VertexLayout), compact layouts store it encoded
+#if defined(HD2D_OCT_NORMAL)
+layout (location = 1) in vec2 aNormal;
+#elif defined(HD2D_QTANGENT)
+layout (location = 3) in vec4 aTangentFrame;
+#else
+layout (location = 1) in vec3 aNormal;
+#endif
+
+// object space normal of the vertex
+vec3 decodeNormal()
+{
+#if defined(HD2D_OCT_NORMAL)
+    vec3 n = vec3(aNormal, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+#elif defined(HD2D_QTANGENT)
+    // +z rotated by the tangent frame quaternion
+    vec4 q = normalize(aTangentFrame);
+    return vec3(2.0 * (q.x * q.z + q.w * q.y), 
+                2.0 * (q.y * q.z - q.w * q.x), 
+                1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+#else
+    return aNormal;
+#endif
+}
@@ -2,10 +2,18 @@
 out vec4 FragColor;
 
 in vec2 TexCoords;
+in vec3 Normal;
 
 uniform sampler2D texture_diffuse1;
+uniform vec3 lightDirection;
+
+#include "include/ambient_sh.glsl"
 
 void main()
 {    
-    FragColor = texture(texture_diffuse1, TexCoords);
+    // skybox ambient and a wrapped sun, the same light the background characters get
+    vec3  normal  = normalize(Normal);
+    float diffuse = dot(normal, -normalize(lightDirection)) * 0.5 + 0.5;
+    vec4  color   = texture(texture_diffuse1, TexCoords);
+    FragColor = vec4(color.rgb * (0.6 * evalAmbient(normal) + 0.7 * diffuse), color.a);
 }
\ No newline at end of file
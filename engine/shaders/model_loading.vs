@@ -1,9 +1,10 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#include "include/vertex_normal.glsl"
 
 out vec2 TexCoords;
+out vec3 Normal;
 
 layout (std140) uniform Matrices
 {
@@ -12,9 +13,15 @@ layout (std140) uniform Matrices
 };
 
 uniform mat4 model;
+// inverse transpose of model, computed on the CPU (see SceneGraph)
+uniform mat3 normalMatrix;
+
+#include "include/skinning.glsl"
 
 void main()
 {
+    mat4 skin = skinMatrix();
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Normal = normalMatrix * mat3(skin) * decodeNormal();
+    gl_Position = projection * view * model * skin * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#include "include/vertex_normal.glsl"
 
 out VS_OUT {
     vec3 normal;
@@ -14,10 +14,15 @@ layout (std140) uniform Matrices
 };
 
 uniform mat4 model;
+// inverse transpose of model, computed on the CPU (see SceneGraph)
+uniform mat3 normalMatrix;
+
+#include "include/skinning.glsl"
 
 void main()
 {
-    mat3 normalMatrix = mat3(transpose(inverse(view * model)));
-    vs_out.normal = vec3(vec4(normalMatrix * aNormal, 0.0));
-    gl_Position = view * model * vec4(aPos, 1.0); 
+    mat4 skin = skinMatrix();
+    // the view matrix is rigid, it is its own inverse transpose
+    vs_out.normal = mat3(view) * normalMatrix * mat3(skin) * decodeNormal();
+    gl_Position = view * model * skin * vec4(aPos, 1.0); 
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 lightDirection;
+
+#include "include/ambient_sh.glsl"
+
+void main()
+{
+    // wrapped diffuse, background characters only need to read as lit
+    vec3  normal  = normalize(Normal);
+    float diffuse = dot(normal, -normalize(lightDirection)) * 0.5 + 0.5;
+    vec4  color   = texture(texture_diffuse1, TexCoords);
+    FragColor = vec4(color.rgb * (0.6 * evalAmbient(normal) + 0.7 * diffuse), color.a);
+}
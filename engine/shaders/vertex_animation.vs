@@ -0,0 +1,52 @@
+#version 330 core
+// positions and normals come from the vertex animation textures, only the uvs are read from the mesh
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 7) in mat4 aInstanceMatrix;
+layout (location = 11) in vec2 aInstanceTime; // offset in seconds, speed
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+layout (std140) uniform Matrices
+{
+    mat4 projection;
+    mat4 view;
+};
+
+// see VertexAnimationTexture
+uniform sampler2D vatPositions;
+uniform sampler2D vatNormals;
+uniform int   vatFirstVertex;
+uniform int   vatVertexCount;
+uniform int   vatFrameCount;
+uniform float vatFrameRate;
+uniform float time;
+
+// frames are stored one after another, wrapping across texture rows
+ivec2 vatTexel(int frame, int vertex)
+{
+    int texel = frame * vatVertexCount + vertex;
+    int width = textureSize(vatPositions, 0).x;
+    return ivec2(texel % width, texel / width);
+}
+
+void main()
+{
+    // gl_VertexID includes the base vertex, so it indexes the whole geometry buffer
+    int vertex = gl_VertexID - vatFirstVertex;
+
+    // clips loop, the last frame blends back into the first
+    float frame  = mod((time * aInstanceTime.y + aInstanceTime.x) * vatFrameRate, float(vatFrameCount));
+    int   frame0 = min(int(frame), vatFrameCount - 1);
+    int   frame1 = (frame0 + 1) % vatFrameCount;
+    float blend  = frame - float(frame0);
+
+    vec3 position = mix(texelFetch(vatPositions, vatTexel(frame0, vertex), 0).xyz,
+                        texelFetch(vatPositions, vatTexel(frame1, vertex), 0).xyz, blend);
+    vec3 normal   = mix(texelFetch(vatNormals, vatTexel(frame0, vertex), 0).xyz,
+                        texelFetch(vatNormals, vatTexel(frame1, vertex), 0).xyz, blend);
+
+    TexCoords   = aTexCoords;
+    Normal      = mat3(aInstanceMatrix) * normal;
+    gl_Position = projection * view * aInstanceMatrix * vec4(position, 1.0);
+}
@@ -0,0 +1,124 @@
+#ifndef _ANIMATION_H__
+#define _ANIMATION_H__
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Hd2d {
+    struct ModelNode;
+
+    // bone ids are 8 bit in the compact skin stream, and 256 std140 matrices are the 16KB every GL 3.3 UBO can hold
+    constexpr unsigned int MAX_SKELETON_BONES    = 256;
+    // uniform block binding of BonePalette, Matrices uses 0
+    constexpr unsigned int BONE_PALETTE_BINDING = 1;
+
+    // node hierarchy of a model plus the nodes vertices are skinned to, parents come before their children
+    struct Skeleton {
+        std::vector<int>       parents_;
+        std::vector<glm::mat4> bind_transforms_;  // local transform of every node at rest
+        std::vector<uint32_t>  bone_nodes_;       // node driving each bone
+        std::vector<glm::mat4> bone_offsets_;     // mesh space to bone space at rest
+
+        static std::shared_ptr<Skeleton> create(const std::vector<ModelNode>& nodes, std::vector<uint32_t> bone_nodes,
+                                                std::vector<glm::mat4> bone_offsets);
+
+        // resolve the hierarchy, local_transforms holds one transform per node
+        void computeGlobalTransforms(const std::vector<glm::mat4>& local_transforms, std::vector<glm::mat4>& global_transforms) const;
+
+        size_t getNodeCount() const noexcept { return parents_.size(); }
+        size_t getBoneCount() const noexcept { return bone_nodes_.size(); }
+    };
+
+    // one quantized key, 8 bytes for every track type.
+    // positions and scales are unorm16 inside their track's range, rotations smallest-three quaternions in 48 bits
+    struct AnimationKey {
+        uint16_t time_;     // unorm16 of the clip duration
+        uint16_t value_[3];
+    };
+
+    // contiguous run of a clip's keys, min_ and extent_ dequantize position and scale values
+    struct AnimationTrack {
+        glm::vec3 min_;
+        glm::vec3 extent_;
+        uint32_t  first_key_;
+        uint32_t  key_count_;
+    };
+
+    // the three tracks of one animated node, their keys are adjacent so sampling a node stays in a few cache lines
+    struct AnimationChannel {
+        uint32_t       node_;
+        uint32_t       reserved_[3];
+        AnimationTrack position_;
+        AnimationTrack rotation_;
+        AnimationTrack scale_;
+    };
+
+    // compressed clip, see compressAnimationClip
+    struct AnimationClip {
+        std::string                   name_;
+        float                         duration_ = 0.0f;
+        std::vector<AnimationChannel> channels_;
+        std::vector<AnimationKey>     keys_;
+
+        // overwrite the local transforms of the animated nodes, the others are left as they are.
+        // only the two keys around time are decoded per track
+        void sample(float time, std::vector<glm::mat4>& local_transforms) const;
+        size_t getByteSize() const noexcept;
+    };
+
+    // plays clips on many skeleton instances at once and keeps their bone palettes in one uniform buffer
+    class Animator {
+    public:
+        explicit Animator() = default;
+        ~Animator();
+
+        Animator(const Animator&) = delete;
+        Animator& operator=(const Animator&) = delete;
+
+        // a new instance holds the bind pose until a clip is played on it
+        size_t addInstance(std::shared_ptr<const Skeleton> skeleton, std::shared_ptr<const AnimationClip> clip = nullptr);
+        void   play(size_t instance, std::shared_ptr<const AnimationClip> clip, float start_time = 0.0f, bool loop = true);
+        void   setSpeed(size_t instance, float speed) { instances_[instance].speed_ = speed; }
+
+        size_t getInstanceCount() const noexcept { return instances_.size(); }
+        // model space skinning matrices of an instance, getBoneCount() of them
+        const glm::mat4* getPalette(size_t instance) const noexcept { return &palettes_[instance * MAX_SKELETON_BONES]; }
+
+        // advance and pose every instance, spread over the thread pool
+        void update(float delta_time);
+        // GL side: copy the palettes posed by update into the uniform buffer
+        void upload();
+        // make instance's palette the BonePalette block seen by the next draws
+        void bind(size_t instance) const;
+
+        void deleteBuffer();
+
+    private:
+        struct Instance {
+            std::shared_ptr<const Skeleton>      skeleton_;
+            std::shared_ptr<const AnimationClip> clip_;
+            float                                time_  = 0.0f;
+            float                                speed_ = 1.0f;
+            bool                                 loop_  = true;
+            // scratch reused every update
+            std::vector<glm::mat4>               local_transforms_;
+            std::vector<glm::mat4>               global_transforms_;
+        };
+
+        std::vector<Instance>  instances_;
+        // MAX_SKELETON_BONES matrices per instance, so every palette starts on a UBO offset alignment boundary
+        std::vector<glm::mat4> palettes_;
+        unsigned int           UBO = 0;
+        size_t                 ubo_instance_capacity_ = 0;
+
+        static void poseInstance(Instance& instance, float delta_time, glm::mat4* palette);
+    };
+}
+
+#endif // _ANIMATION_H__
@@ -0,0 +1,45 @@
+#ifndef _ANIMATION_COMPRESSION_H__
+#define _ANIMATION_COMPRESSION_H__
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "editor/include/animation.h"
+
+namespace Hd2d {
+    // keys of one animated node as imported, times in seconds
+    struct RawAnimationChannel {
+        uint32_t               node_ = 0;
+        std::vector<float>     position_times_;
+        std::vector<glm::vec3> positions_;
+        std::vector<float>     rotation_times_;
+        std::vector<glm::quat> rotations_;
+        std::vector<float>     scale_times_;
+        std::vector<glm::vec3> scales_;
+    };
+
+    // how far a reconstructed key may drift from the imported one before it has to be kept
+    struct AnimationCompressionSettings {
+        float position_error_ = 1e-3f; // model units
+        float rotation_error_ = 1e-3f; // radians
+        float scale_error_    = 1e-4f;
+    };
+
+    // drop keys that linear interpolation reproduces within settings, then quantize the rest into AnimationKeys
+    std::shared_ptr<AnimationClip> compressAnimationClip(std::string name, float duration,
+                                                         const std::vector<RawAnimationChannel>& channels,
+                                                         const AnimationCompressionSettings& settings = {});
+    // bytes the channels take as fp32 keys, for import reports
+    size_t getRawByteSize(const std::vector<RawAnimationChannel>& channels) noexcept;
+
+    // smallest three: index of the dropped largest component in 2 bits, the other three as 15-bit snorm of 1/sqrt(2)
+    void      packQuaternion(const glm::quat& rotation, uint16_t packed[3]) noexcept;
+    glm::quat unpackQuaternion(const uint16_t packed[3]) noexcept;
+}
+
+#endif // _ANIMATION_COMPRESSION_H__
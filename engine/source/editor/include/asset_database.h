@@ -0,0 +1,87 @@
+#ifndef _ASSET_DATABASE_H__
+#define _ASSET_DATABASE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Hd2d {
+    constexpr std::string_view ASSET_INDEX_FILE_NAME = "asset_index.hd2ddb";
+
+    // one derived file to bring up to date, see AssetDatabase::cookOutdated
+    struct AssetCookJob {
+        std::string              artifact_path_;
+        std::vector<std::string> dependencies_;       // every file the cook reads, the main source first
+        uint32_t                 cooker_version_ = 0;
+        uint64_t                 settings_hash_  = 0; // 0 when the cooker has no settings
+        std::function<bool()>    cook_;               // writes artifact_path_, false on failure
+    };
+
+    // process wide record of derived files (cooked textures, cooked models): which sources at which content hash,
+    // cooker version and settings made them. sources are only re-hashed when their size or write time moved,
+    // so checking an unchanged tree costs the index read plus a stat per file. paths are kept relative to the
+    // index so a copied tree keeps its records. safe from any thread
+    class AssetDatabase {
+    public:
+        static AssetDatabase& getInstance();
+
+        // read the index with one file read, a missing or outdated index starts empty. until opened nothing persists
+        bool open(const std::filesystem::path& index_path);
+        // write the index if anything changed since open or the last save
+        bool save();
+
+        // FNV-1a of the file content, 0 if it can't be read
+        uint64_t getSourceHash(std::string_view source_path);
+
+        bool isRecorded(std::string_view artifact_path);
+        // the artifact exists and every dependency it was recorded with still has the same content,
+        // for loaders that take whatever settings the artifact was cooked with
+        bool isUpToDate(std::string_view artifact_path, uint32_t cooker_version);
+        // and it was cooked from exactly these dependencies with these settings, for cookers
+        bool isUpToDate(std::string_view artifact_path, const std::vector<std::string>& dependencies,
+                        uint32_t cooker_version, uint64_t settings_hash);
+        // remember a successful cook, dependencies are hashed as they are now
+        void record(std::string_view artifact_path, const std::vector<std::string>& dependencies,
+                    uint32_t cooker_version, uint64_t settings_hash);
+
+        // check every job and cook the outdated ones on the thread pool, records what succeeded.
+        // returns the number of jobs cooked, failed ones are counted in failed
+        size_t cookOutdated(const std::vector<AssetCookJob>& jobs, size_t& failed);
+
+    private:
+        struct SourceState {
+            uint64_t size_         = 0;
+            int64_t  write_time_   = 0;
+            uint64_t content_hash_ = 0;
+        };
+
+        struct ArtifactState {
+            uint32_t                                   cooker_version_ = 0;
+            uint64_t                                   settings_hash_  = 0;
+            std::vector<std::pair<std::string, uint64_t>> dependencies_; // key and content hash at cook time
+        };
+
+        std::mutex                                     mutex_;
+        std::filesystem::path                          index_path_;
+        std::filesystem::path                          root_;
+        std::unordered_map<std::string, SourceState>   sources_;
+        std::unordered_map<std::string, ArtifactState> artifacts_;
+        bool                                           dirty_ = false;
+
+        AssetDatabase() = default;
+
+        // path relative to the index directory, the map key of sources_ and artifacts_
+        std::string getKey(std::string_view path);
+        std::filesystem::path getPath(const std::string& key);
+        uint64_t getKeyHash(const std::string& key);
+    };
+}
+
+#endif // _ASSET_DATABASE_H__
@@ -0,0 +1,22 @@
+#ifndef _BC_ENCODER_H__
+#define _BC_ENCODER_H__
+
+#include <cstdint>
+
+namespace Hd2d {
+    // every encoder takes one 4x4 block of RGBA8 texels in row order and writes one compressed block.
+    // touches no GL state, safe on any thread
+
+    // rgb, alpha ignored, 8 bytes
+    void encodeBc1Block(const uint8_t rgba[64], uint8_t block[8]) noexcept;
+    // rgb plus interpolated alpha, 16 bytes
+    void encodeBc3Block(const uint8_t rgba[64], uint8_t block[16]) noexcept;
+    // red only, 8 bytes
+    void encodeBc4Block(const uint8_t rgba[64], uint8_t block[8]) noexcept;
+    // red and green, 16 bytes
+    void encodeBc5Block(const uint8_t rgba[64], uint8_t block[16]) noexcept;
+    // rgba with BC7 mode 6 (one subset, 7777.1 endpoints, 4 bit indices), 16 bytes
+    void encodeBc7Block(const uint8_t rgba[64], uint8_t block[16]) noexcept;
+}
+
+#endif // _BC_ENCODER_H__
@@ -0,0 +1,46 @@
+#ifndef _BOUNDS_H__
+#define _BOUNDS_H__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <limits>
+
+namespace Hd2d {
+    struct VertexStreamView;
+
+    // axis aligned box, empty while min_ > max_
+    struct Aabb {
+        glm::vec3 min_ = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max_ = glm::vec3(std::numeric_limits<float>::lowest());
+
+        bool      isEmpty() const noexcept { return min_.x > max_.x; }
+        glm::vec3 getCenter() const noexcept { return (min_ + max_) * 0.5f; }
+        glm::vec3 getExtent() const noexcept { return (max_ - min_) * 0.5f; }
+        void      merge(const Aabb& other) noexcept { min_ = glm::min(min_, other.min_); max_ = glm::max(max_, other.max_); }
+    };
+
+    struct BoundingSphere {
+        glm::vec3 center_ = glm::vec3(0.0f);
+        float     radius_ = 0.0f;
+    };
+
+    // what import records for every mesh and model, in their local space
+    struct MeshBounds {
+        Aabb           box_;
+        BoundingSphere sphere_;
+    };
+
+    // box of count fp32 positions stride bytes apart, SSE when available
+    Aabb computeAabb(const void* positions, size_t stride, size_t count) noexcept;
+    // sphere around the box center reaching the farthest position
+    BoundingSphere computeBoundingSphere(const void* positions, size_t stride, size_t count, const Aabb& box) noexcept;
+    // both of the above for a vertex stream, every layout starts with an fp32 position
+    MeshBounds computeMeshBounds(const VertexStreamView& vertex_streams) noexcept;
+
+    // boxes[i] and spheres[i] through transforms[i], boxes stay tight to the transformed box (Arvo)
+    void transformAabbs(const Aabb* boxes, const glm::mat4* transforms, Aabb* transformed, size_t count) noexcept;
+    void transformSpheres(const BoundingSphere* spheres, const glm::mat4* transforms, BoundingSphere* transformed, size_t count) noexcept;
+}
+
+#endif // _BOUNDS_H__
@@ -12,12 +12,17 @@ namespace Hd2d {
         const std::filesystem::path& getTexturePath() const;
         const std::filesystem::path& getShaderPath() const;
         const std::filesystem::path& getModelPath() const;
+        const std::filesystem::path& getAssetIndexPath() const;
+        // load the animated character crowd into the demo scene, off unless the ini asks for it
+        bool isDemoCrowdEnabled() const;
 
     private:
         std::filesystem::path root_folder_;
         std::filesystem::path texture_path_;
         std::filesystem::path shader_path_;
         std::filesystem::path model_path_;
+        std::filesystem::path asset_index_path_;
+        bool                  demo_crowd_ = false;
     };
 }
 
@@ -0,0 +1,137 @@
+#ifndef _COOKED_MODEL_H__
+#define _COOKED_MODEL_H__
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "editor/include/animation.h"
+#include "editor/include/mapped_file.h"
+#include "editor/include/mesh.h"
+
+namespace Hd2d {
+    // bump whenever the layout below or the import pipeline output changes
+    constexpr uint32_t COOKED_MODEL_VERSION    = 9;
+    constexpr uint32_t COOKED_MODEL_ENDIAN_TAG = 0x01020304;
+    constexpr uint64_t COOKED_MODEL_ALIGNMENT  = 16;
+
+    // .hd2dmesh layout, every section starts on a COOKED_MODEL_ALIGNMENT boundary:
+    // header | meshes | texture refs | nodes | bones | clips | strings | vertex and index streams | animation keys
+    struct CookedModelHeader {
+        char     magic_[8];
+        uint32_t version_;
+        uint32_t endian_tag_;
+        uint64_t source_hash_;
+        uint32_t vertex_layout_;
+        uint32_t vertex_stride_;
+        uint32_t mesh_count_;
+        uint32_t texture_ref_count_;
+        uint32_t node_count_;
+        uint32_t lod_ratios_hash_; // cooked levels are only valid for the ratios they were made with
+        uint64_t meshes_offset_;
+        uint64_t texture_refs_offset_;
+        uint64_t nodes_offset_;
+        uint64_t strings_offset_;
+        uint64_t strings_size_;
+        uint32_t bone_count_;
+        uint32_t clip_count_;
+        uint64_t bones_offset_;
+        uint64_t clips_offset_;
+    };
+
+    struct CookedMesh {
+        uint64_t vertex_offset_;
+        uint64_t skin_offset_;   // 0 when the mesh has no skin stream
+        uint64_t index_offset_;
+        uint64_t meshlet_offset_;
+        uint64_t lod_offset_;
+        uint32_t vertex_count_;
+        uint32_t index_count_;
+        uint32_t first_texture_ref_;
+        uint32_t texture_ref_count_;
+        uint32_t index_type_;     // IndexType
+        uint32_t meshlet_count_;
+        uint32_t lod_count_;
+        uint32_t reserved_;
+        MeshBounds bounds_;       // import bounds of the vertices, in the mesh's node space
+    };
+
+    struct CookedString {
+        uint32_t offset_;
+        uint32_t length_;
+    };
+
+    struct CookedTextureRef {
+        CookedString type_;
+        CookedString path_;
+    };
+
+    struct CookedNode {
+        float        transform_[16];
+        CookedString name_;
+        int32_t      parent_;
+        uint32_t     first_mesh_;
+        uint32_t     mesh_count_;
+    };
+
+    struct CookedBone {
+        float    offset_[16];
+        uint32_t node_;
+        uint32_t reserved_[3];
+    };
+
+    // a compressed clip, see AnimationClip. channel tracks index the clip's keys
+    struct CookedClip {
+        CookedString name_;
+        float        duration_;
+        uint32_t     channel_count_;
+        uint32_t     key_count_;
+        uint32_t     reserved_;
+        uint64_t     channels_offset_;
+        uint64_t     keys_offset_;
+    };
+
+    // one mesh pointing straight into the mapped file
+    struct CookedMeshView {
+        VertexStreamView        vertex_streams_;
+        IndexStreamView         index_stream_;
+        std::vector<Meshlet>    meshlets_;
+        std::vector<MeshLod>    lods_;
+        std::vector<TextureRef> textures_;
+        MeshBounds              bounds_;
+    };
+
+    class CookedModel {
+    public:
+        explicit CookedModel() = default;
+
+        // nullptr if the file is missing, malformed, from another version or cooked from other source content
+        static std::shared_ptr<CookedModel> open(std::string_view cooked_file_path, uint64_t source_hash, VertexLayout layout,
+                                                 const std::vector<float>& lod_ratios);
+        static bool write(std::string_view cooked_file_path, uint64_t source_hash, VertexLayout layout,
+                          const std::vector<float>& lod_ratios, const std::vector<MeshData>& meshes, 
+                          const std::vector<ModelNode>& nodes, const Skeleton* skeleton,
+                          const std::vector<std::shared_ptr<AnimationClip>>& clips);
+        static uint64_t hashSourceFile(std::string_view source_file_path);
+
+        size_t getMeshCount() const noexcept { return header_->mesh_count_; }
+        CookedMeshView getMesh(size_t index) const;
+        std::vector<ModelNode> getNodes() const;
+        // nullptr for static models
+        std::shared_ptr<Skeleton> getSkeleton() const;
+        std::vector<std::shared_ptr<AnimationClip>> getClips() const;
+
+    private:
+        std::shared_ptr<MappedFile> file_;
+        const CookedModelHeader*    header_ = nullptr;
+
+        bool validate(uint64_t source_hash, VertexLayout layout, const std::vector<float>& lod_ratios) const;
+        static uint32_t hashLodRatios(const std::vector<float>& lod_ratios);
+        std::string_view getString(const CookedString& cooked_string) const;
+        template<typename T>
+        const T* at(uint64_t offset) const { return reinterpret_cast<const T*>(file_->getData() + offset); }
+    };
+}
+
+#endif // _COOKED_MODEL_H__
@@ -0,0 +1,88 @@
+#ifndef _CPT_FORMAT_H__
+#define _CPT_FORMAT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Hd2d {
+    // bumped whenever CptFileHead or CptMipLevel change, older files are re-cooked
+    constexpr uint8_t  CPT_VERSION    = 3;
+    // reads back byte swapped when a file is loaded on a machine of the other endianness
+    constexpr uint32_t CPT_ENDIAN_TAG = 0x01020304;
+
+    // block compressed layouts a .cpt can hold, values are stored in files
+    enum class CptFormat : uint8_t {
+        Unknown = 0, // pick from the source channels when cooking
+        BC1     = 1, // rgb, 8 bytes per block
+        BC3     = 2, // rgba, 16 bytes per block
+        BC4     = 3, // r, 8 bytes per block
+        BC5     = 4, // rg, 16 bytes per block
+        BC7     = 5, // rgba, 16 bytes per block
+    };
+
+    enum CptFlags : uint8_t {
+        CPT_FLAG_SRGB = 1 << 0, // mips were filtered in linear light, texels are sRGB encoded
+    };
+
+    // .cpt layout: CptFileHead, mip_count_ CptMipLevel, then the blocks of every level, largest first
+    struct CptFileHead
+    {
+        char     type_[3];
+        uint8_t  version_;
+        uint32_t endian_tag_;
+        uint8_t  format_;
+        uint8_t  flags_;
+        uint16_t mip_count_;
+        uint32_t width_;
+        uint32_t height_;
+        uint32_t reserved_;
+        uint64_t data_size_; // block bytes of all levels
+
+        // diff if the file head is cpt
+        static bool isCptFile(const char* file_head) {
+            return std::memcmp(file_head, "cpt", 3) == 0;
+        }
+    };
+
+    struct CptMipLevel
+    {
+        uint32_t width_;
+        uint32_t height_;
+        uint64_t offset_; // from the start of the file
+        uint64_t size_;
+    };
+
+    static_assert(sizeof(CptFileHead) == 32, "CptFileHead is written to disk as is");
+    static_assert(sizeof(CptMipLevel) == 24, "CptMipLevel is written to disk as is");
+
+    // magic, version and endianness, all that can be checked from the head bytes alone
+    bool isCptHeadValid(const CptFileHead& head) noexcept;
+    // head and level table of a whole .cpt in memory, nullptr if it is truncated, from another version
+    // or endianness, or a level's blocks fall outside of size bytes
+    const CptFileHead* validateCptFile(const unsigned char* bytes, size_t size) noexcept;
+    inline const CptMipLevel* getCptLevels(const CptFileHead* head) noexcept {
+        return reinterpret_cast<const CptMipLevel*>(head + 1);
+    }
+
+    // BC4 and BC5 hold data, their mips are never filtered in linear light
+    constexpr bool isCptColorFormat(CptFormat format) noexcept {
+        return format == CptFormat::BC1 || format == CptFormat::BC3 || format == CptFormat::BC7;
+    }
+
+    // if the mips were filtered the way a map sampled as color (srgb) or as data needs
+    constexpr bool isCptColorSpace(const CptFileHead& head, bool srgb) noexcept {
+        const bool srgb_filtered = srgb && isCptColorFormat(static_cast<CptFormat>(head.format_));
+        return ((head.flags_ & CPT_FLAG_SRGB) != 0) == srgb_filtered;
+    }
+
+    constexpr uint32_t getCptBlockBytes(CptFormat format) noexcept {
+        return format == CptFormat::BC1 || format == CptFormat::BC4 ? 8 : 16;
+    }
+
+    constexpr uint64_t getCptLevelSize(CptFormat format, uint32_t width, uint32_t height) noexcept {
+        return uint64_t((width + 3) / 4) * ((height + 3) / 4) * getCptBlockBytes(format);
+    }
+}
+
+#endif // _CPT_FORMAT_H__
@@ -0,0 +1,37 @@
+#ifndef _CULLING_H__
+#define _CULLING_H__
+
+#include <glm/glm.hpp>
+
+#include "editor/include/bounds.h"
+
+namespace Hd2d {
+    // six normalized planes, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all of them
+    struct Frustum {
+        glm::vec4 planes_[6];
+
+        // planes of clip space pulled back through matrix, e.g. projection * view * model gives model space planes
+        static Frustum fromMatrix(const glm::mat4& matrix) noexcept;
+
+        bool isSphereVisible(const glm::vec3& center, float radius) const noexcept;
+        // false only when the box lies completely outside one plane
+        bool isBoxVisible(const Aabb& box) const noexcept;
+    };
+
+    // everything a draw needs to cull meshlets, expressed in the mesh's model space
+    struct CullView {
+        Frustum   frustum_;
+        glm::vec3 camera_position_;
+        // normal cone culling is only valid while GL_CULL_FACE drops back faces
+        bool      backface_culling_ = true;
+
+        static CullView fromMatrices(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) noexcept;
+        // the same view seen from a child space, e.g. a scene graph node, without another inverse
+        CullView toLocalSpace(const glm::mat4& transform, const glm::mat3& normal_matrix) const noexcept;
+
+        // conservative: false only when the whole sphere is outside or every triangle in the cone faces away
+        bool isClusterVisible(const glm::vec3& center, float radius, const glm::vec3& cone_axis, float cone_cutoff) const noexcept;
+    };
+}
+
+#endif // _CULLING_H__
@@ -0,0 +1,75 @@
+#ifndef _ENVIRONMENT_BAKE_H__
+#define _ENVIRONMENT_BAKE_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Hd2d {
+    // bump whenever the baked output changes for the same faces and settings, so the asset database bakes again
+    constexpr uint32_t         ENVIRONMENT_BAKE_VERSION    = 1;
+    constexpr std::string_view ENVIRONMENT_EXTENSION       = ".hd2dibl";
+    constexpr char             ENVIRONMENT_MAGIC[8]        = {'H', 'D', '2', 'D', 'I', 'B', 'L', '\0'};
+    constexpr uint32_t         ENVIRONMENT_FILE_VERSION    = 1;
+    constexpr uint32_t         ENVIRONMENT_ENDIAN_TAG      = 0x01020304;
+    constexpr uint32_t         ENVIRONMENT_SH_COEFFICIENTS = 9;
+
+    // one decoded skybox face, square, 3 or 4 channels of 8 bit
+    struct EnvironmentFace {
+        const unsigned char* pixels_   = nullptr;
+        int                  width_    = 0;
+        int                  height_   = 0;
+        int                  channels_ = 0;
+    };
+
+    struct EnvironmentBakeSettings {
+        uint32_t face_size_    = 128; // level 0 of the specular cube, smaller skyboxes keep their size
+        uint32_t mip_count_    = 6;   // roughness goes from 0 at level 0 to 1 at the last level
+        uint32_t sample_count_ = 256; // GGX samples per specular texel
+    };
+
+    // .hd2dibl layout: EnvironmentFileHeader | mip_count_ levels, each the six faces +x -x +y -y +z -z of
+    // max(1, face_size_ >> level) squared RGB16F texels
+    struct EnvironmentFileHeader {
+        char     magic_[8];
+        uint32_t version_;
+        uint32_t endian_tag_;
+        uint32_t face_size_;
+        uint32_t mip_count_;
+        uint32_t sample_count_;
+        uint32_t reserved_;
+        // irradiance / pi as 9 SH coefficients (rgb, w unused), already scaled by the band convolution and the
+        // basis constants, so a shader only evaluates the polynomials. the layout of a std140 vec4[9] block
+        float    sh_[ENVIRONMENT_SH_COEFFICIENTS][4];
+    };
+
+    static_assert(sizeof(EnvironmentFileHeader) == 176, "EnvironmentFileHeader is written to disk as is");
+
+    // a .hd2dibl in memory
+    struct BakedEnvironment {
+        EnvironmentFileHeader header_{};
+        std::vector<uint16_t> data_; // half floats, see EnvironmentFileHeader
+
+        bool isValid() const noexcept { return !data_.empty(); }
+    };
+
+    // the faces are taken as the renderer samples them (value / 255, no sRGB decode), so ambient light comes out in
+    // the same space as the skybox on screen. runs on the thread pool, no GL involved. invalid if the faces are
+    // missing or not all square and the same size
+    BakedEnvironment bakeEnvironment(const std::array<EnvironmentFace, 6>& faces, const EnvironmentBakeSettings& settings);
+    bool writeEnvironmentFile(std::string_view environment_path, const BakedEnvironment& environment);
+
+    // what the asset database compares to tell bakes with different settings apart
+    uint64_t hashEnvironmentBakeSettings(const EnvironmentBakeSettings& settings) noexcept;
+    // bytes of texel data following the header
+    size_t getEnvironmentDataSize(uint32_t face_size, uint32_t mip_count) noexcept;
+    // header of a whole file in memory, nullptr if it is truncated, from another version or endianness
+    const EnvironmentFileHeader* validateEnvironmentFile(const unsigned char* bytes, size_t size) noexcept;
+    // where the bake of a skybox lives: next to its faces, named after their directory
+    std::string getEnvironmentPath(std::string_view face_path);
+}
+
+#endif // _ENVIRONMENT_BAKE_H__
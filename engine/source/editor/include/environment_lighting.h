@@ -0,0 +1,49 @@
+#ifndef _ENVIRONMENT_LIGHTING_H__
+#define _ENVIRONMENT_LIGHTING_H__
+
+#include <glad/glad.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "editor/include/environment_bake.h"
+
+namespace Hd2d {
+    // uniform block binding of AmbientSH, Matrices uses 0 and BonePalette 1
+    constexpr unsigned int AMBIENT_SH_BINDING = 2;
+    // the vertex animation textures take 14 and 15
+    constexpr unsigned int ENVIRONMENT_SPECULAR_TEXTURE_UNIT = 13;
+
+    // image based lighting of a skybox: SH ambient in a uniform buffer and the GGX prefiltered specular cube.
+    // the bake is cached next to the skybox and only redone when a face or the bake settings change
+    class EnvironmentLighting {
+    public:
+        explicit EnvironmentLighting() = default;
+        ~EnvironmentLighting();
+
+        EnvironmentLighting(const EnvironmentLighting&) = delete;
+        EnvironmentLighting& operator=(const EnvironmentLighting&) = delete;
+
+        // faces in the order of Texture2D::loadCubemap, nullptr if they can't be baked
+        static std::shared_ptr<EnvironmentLighting> load(const std::vector<std::string>& faces,
+                                                         const EnvironmentBakeSettings& settings = EnvironmentBakeSettings{});
+
+        // AmbientSH at AMBIENT_SH_BINDING and the specular cube at texture_unit
+        void bind(GLenum texture_unit = ENVIRONMENT_SPECULAR_TEXTURE_UNIT) const;
+        GLuint getSpecularTextureId() const noexcept { return specular_texture_id_; }
+        // the level roughness 1 reads from
+        float getSpecularMaxLod() const noexcept { return static_cast<float>(mip_count_ - 1); }
+
+        void deleteBuffer();
+
+    private:
+        GLuint   UBO                  = 0;
+        GLuint   specular_texture_id_ = 0;
+        uint32_t mip_count_           = 1;
+
+        void upload(const EnvironmentFileHeader& header, const uint16_t* texels);
+    };
+}
+
+#endif // _ENVIRONMENT_LIGHTING_H__
@@ -0,0 +1,72 @@
+#ifndef _GEOMETRY_BUFFER_H__
+#define _GEOMETRY_BUFFER_H__
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Hd2d {
+    enum class VertexLayout : uint32_t;
+    enum class IndexType : uint32_t;
+    struct VertexStreamView;
+    struct IndexStreamView;
+    struct SkinVertex;
+
+    // where a submesh lives inside a GeometryBuffer
+    struct GeometryRange {
+        GLint     base_vertex_       = 0;
+        size_t    vertex_count_      = 0;
+        size_t    index_byte_offset_ = 0;
+        size_t    index_count_       = 0;
+        IndexType index_type_{};
+    };
+
+    // vertex, skin and index buffers shared by many submeshes of one vertex layout behind a single VAO,
+    // submeshes are drawn with glDrawElementsBaseVertex so their indices stay local.
+    // buffers grow on demand, the GL objects are deleted with the last reference
+    class GeometryBuffer {
+    public:
+        explicit GeometryBuffer(VertexLayout layout);
+        ~GeometryBuffer();
+
+        GeometryBuffer(const GeometryBuffer&) = delete;
+        GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+        static std::shared_ptr<GeometryBuffer> create(VertexLayout layout);
+
+        VertexLayout getLayout() const noexcept { return layout_; }
+        size_t getVertexCount() const noexcept { return vertex_count_; }
+        size_t getIndexBytes() const noexcept { return index_bytes_; }
+
+        // grow once ahead of a batch of allocations instead of once per allocation
+        void reserve(size_t vertex_count, size_t index_bytes);
+        // copy a submesh in, the streams must be in this buffer's layout
+        GeometryRange allocate(const VertexStreamView& vertex_streams, const IndexStreamView& index_stream);
+
+        // copy a submesh's vertex streams back from the GPU, for offline work on models that didn't keep a CPU copy.
+        // skin stays empty for the Full layout and buffers without skinned submeshes
+        void read(const GeometryRange& range, std::vector<unsigned char>& vertices, std::vector<SkinVertex>& skin) const;
+
+        void bind() const;
+        void deleteBuffer();
+
+    private:
+        VertexLayout layout_;
+        unsigned int VAO = 0, VBO = 0, EBO = 0;
+        unsigned int SkinVBO = 0;
+        size_t       vertex_capacity_ = 0;
+        size_t       vertex_count_    = 0;
+        size_t       index_capacity_  = 0; // bytes, the buffer mixes 16 and 32-bit ranges
+        size_t       index_bytes_     = 0;
+
+        void growVertices(size_t vertex_capacity);
+        void growIndices(size_t index_capacity);
+        void createSkinBuffer();
+        void setupAttributes();
+    };
+}
+
+#endif // _GEOMETRY_BUFFER_H__
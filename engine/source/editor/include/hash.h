@@ -0,0 +1,34 @@
+#ifndef _HASH_H__
+#define _HASH_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Hd2d {
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV_PRIME        = 0x100000001b3ull;
+
+    // 64 bit FNV-1a, usable at compile time for names
+    constexpr uint64_t fnv1a64(std::string_view text, uint64_t seed = FNV_OFFSET_BASIS) noexcept {
+        uint64_t hash = seed;
+        for (char c : text) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // 64 bit FNV-1a over raw bytes, used for content hashes of asset files
+    inline uint64_t fnv1a64(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS) noexcept {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+}
+
+#endif // _HASH_H__
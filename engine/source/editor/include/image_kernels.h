@@ -0,0 +1,24 @@
+#ifndef _IMAGE_KERNELS_H__
+#define _IMAGE_KERNELS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Hd2d {
+    // 8 bit pixel kernels shared by the texture loader and the cooker, no GL involved.
+    // SSE2/SSSE3 or NEON when the build targets them, scalar otherwise
+
+    // RGB8 to RGBA8 with opaque alpha, rgba holds texel_count * 4 bytes
+    void expandRgbToRgba(const uint8_t* rgb, uint8_t* rgba, size_t texel_count) noexcept;
+    // color channels times alpha in place, rounded like c * a / 255. done on the stored values, sRGB or not
+    void premultiplyAlpha(uint8_t* rgba, size_t texel_count) noexcept;
+
+    // the next mip: a 2x2 box, max(1, size / 2) texels a side, an odd last row or column is dropped like GL does.
+    // with srgb the color channels are averaged in linear light, alpha (the last of 2 or 4 channels) never is
+    void downsampleBox(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, bool srgb, uint8_t* target) noexcept;
+    // levels 1 and coarser down to 1x1, level 0 stays with the caller
+    std::vector<std::vector<uint8_t>> buildMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, bool srgb);
+}
+
+#endif // _IMAGE_KERNELS_H__
@@ -0,0 +1,32 @@
+#ifndef _LOD_SELECTOR_H__
+#define _LOD_SELECTOR_H__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace Hd2d {
+    struct MeshLod;
+
+    // picks the coarsest level whose error projects below a pixel threshold, in the mesh's model space
+    struct LodSelector {
+        glm::vec3 camera_position_  = glm::vec3(0.0f);
+        // pixels covered by one unit at distance one: viewport height / (2 tan(fovy / 2))
+        float     projection_scale_ = 1.0f;
+        float     threshold_pixels_ = 1.0f;
+        // a level is only left once its error is this fraction past the threshold, so it doesn't flicker
+        float     hysteresis_       = 0.25f;
+
+        // zoom is the camera's vertical field of view in degrees, viewport_height the pixels actually rendered
+        static LodSelector fromCamera(const glm::mat4& model, const glm::mat4& view, float zoom, float viewport_height,
+                                      float threshold_pixels = 1.0f) noexcept;
+        // the same camera seen from a child space, errors and distances scale together so only the position moves
+        LodSelector toLocalSpace(const glm::mat4& transform, const glm::mat3& normal_matrix) const noexcept;
+
+        float getProjectedError(float error, const glm::vec3& center, float radius) const noexcept;
+        size_t select(const std::vector<MeshLod>& lods, const glm::vec3& center, float radius, size_t current_lod) const noexcept;
+    };
+}
+
+#endif // _LOD_SELECTOR_H__
@@ -0,0 +1,31 @@
+#ifndef _MAPPED_FILE_H__
+#define _MAPPED_FILE_H__
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace Hd2d {
+    // read only memory mapping of a whole file, unmapped on destruction
+    class MappedFile {
+    public:
+        explicit MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // nullptr if the file does not exist or cannot be mapped
+        static std::shared_ptr<MappedFile> open(std::string_view file_path);
+
+        const unsigned char* getData() const noexcept { return data_; }
+        size_t               getSize() const noexcept { return size_; }
+
+    private:
+        const unsigned char* data_    = nullptr;
+        size_t               size_    = 0;
+        void*                mapping_ = nullptr; // platform mapping handle, only used on windows
+    };
+}
+
+#endif // _MAPPED_FILE_H__
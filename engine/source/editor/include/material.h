@@ -0,0 +1,48 @@
+#ifndef _MATERIAL_H__
+#define _MATERIAL_H__
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "editor/include/shader.h"
+#include "editor/include/texture2d.h"
+
+namespace Hd2d {
+    // the textures of a mesh resolved once at load: texture i goes to unit i and to the sampler named after its
+    // type and count (texture_diffuse1, texture_specular1, ...). sampler locations are looked up once per program,
+    // so binding is a few integer calls, and binding the material that is already bound does nothing.
+    // GL thread only
+    class Material {
+    public:
+        explicit Material() = default;
+
+        Material(const Material&) = delete;
+        Material& operator=(const Material&) = delete;
+
+        // meshes with the same textures share one material, which is what lets their draws skip the binds
+        static std::shared_ptr<const Material> create(const std::vector<Texture2D>& textures);
+
+        // textures on their units and the program's samplers pointed at them
+        void bind(const ShaderProgram& shader_program) const;
+        // forget what is bound, for code that binds textures of its own between material draws
+        static void invalidateBinding() noexcept;
+
+        size_t getTextureCount() const noexcept { return texture_ids_.size(); }
+
+    private:
+        uint64_t                 id_ = 0;  // never reused, unlike addresses and GL names
+        std::vector<GLuint>      texture_ids_;
+        std::vector<std::string> samplers_;
+        // program id and the location of every sampler in it, -1 for samplers it doesn't use
+        mutable std::vector<std::pair<unsigned int, std::vector<GLint>>> program_locations_;
+
+        const std::vector<GLint>& getLocations(const ShaderProgram& shader_program) const;
+    };
+}
+
+#endif // _MATERIAL_H__
@@ -3,9 +3,16 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <string>
 
+#include "editor/include/bounds.h"
+#include "editor/include/culling.h"
+#include "editor/include/geometry_buffer.h"
+#include "editor/include/lod_selector.h"
+#include "editor/include/material.h"
 #include "editor/include/shader.h"
 #include "editor/include/texture2d.h"
 
@@ -29,33 +36,236 @@ namespace Hd2d {
         float weights_[MAX_BONE_INFLUENCE];
     };
 
+    // GPU vertex formats a mesh can be uploaded with
+    enum class VertexLayout : uint32_t {
+        // Vertex as is, 88 bytes
+        Full,
+        // fp32 position, octahedral snorm16 normal, half uv: 20 bytes (+ 8 byte skin stream)
+        Compact,
+        // fp32 position, snorm16 tangent frame quaternion, half uv: 24 bytes (+ 8 byte skin stream)
+        CompactTangentFrame
+    };
+
+    struct CompactVertex {
+        glm::vec3 position_;
+        uint32_t  normal_;     // octahedral, 2 x snorm16
+        uint32_t  texCoords_;  // 2 x half
+    };
+
+    struct CompactTangentFrameVertex {
+        glm::vec3 position_;
+        uint32_t  tangentFrame_[2]; // quaternion, 4 x snorm16, sign of w is the bitangent handedness
+        uint32_t  texCoords_;    // 2 x half
+    };
+
+    // second stream of compact layouts, only present for skinned meshes
+    struct SkinVertex {
+        uint8_t boneIDs_[MAX_BONE_INFLUENCE];
+        uint8_t weights_[MAX_BONE_INFLUENCE]; // unorm8
+    };
+
+    // raw vertex streams in one VertexLayout, exactly as they are uploaded
+    struct VertexStreamView {
+        VertexLayout layout_       = VertexLayout::Full;
+        size_t       vertex_count_ = 0;
+        const void*  vertices_     = nullptr;
+        const void*  skin_         = nullptr; // nullptr for Full layout and static meshes
+    };
+
+    // element type of an index buffer, UInt16 whenever every vertex can be addressed with it
+    enum class IndexType : uint32_t {
+        UInt16,
+        UInt32
+    };
+
+    // raw index stream, exactly as it is uploaded
+    struct IndexStreamView {
+        IndexType   type_        = IndexType::UInt32;
+        size_t      index_count_ = 0;
+        const void* indices_     = nullptr;
+    };
+
+    constexpr unsigned int MESHLET_MAX_VERTICES  = 64;
+    constexpr unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+    // contiguous range of a mesh's index buffer touching at most MESHLET_MAX_VERTICES vertices
+    struct Meshlet {
+        glm::vec3 center_;        // bounding sphere
+        float     radius_;
+        glm::vec3 cone_axis_;     // average facing of the triangles
+        float     cone_cutoff_;   // sine of the cone half angle, 1 when the cluster can't be back face culled
+        uint32_t  index_offset_;
+        uint32_t  index_count_;
+    };
+
+    // one level of detail, a range of the shared index buffer
+    struct MeshLod {
+        uint32_t index_offset_;
+        uint32_t index_count_;
+        float    error_;         // bound of the distance to the full mesh surface, in model space
+    };
+
+    // what a Mesh keeps on the CPU once its buffers are uploaded
+    enum class MeshResidency : uint32_t {
+        // vertices and indices as imported
+        Keep,
+        // nothing, the GPU buffers are the only copy
+        DiscardAfterUpload,
+        // 16-bit quantized positions and the index buffer, enough for picking and physics
+        KeepCompressed
+    };
+
+    // positions quantized inside the mesh bounds, position = bounds_min_ + q * bounds_scale_
+    struct CompressedMeshCopy {
+        glm::vec3                  bounds_min_   = glm::vec3(0.0f);
+        glm::vec3                  bounds_scale_ = glm::vec3(0.0f);
+        std::vector<uint16_t>      positions_;  // 3 per vertex
+        IndexType                  index_type_ = IndexType::UInt32;
+        std::vector<unsigned char> indices_;
+
+        size_t       getVertexCount() const noexcept { return positions_.size() / 3; }
+        size_t       getIndexCount() const noexcept;
+        glm::vec3    getPosition(size_t vertex) const noexcept;
+        unsigned int getIndex(size_t index) const noexcept;
+        size_t       getByteSize() const noexcept { return positions_.capacity() * sizeof(uint16_t) + indices_.capacity(); }
+    };
+
+    // texture a mesh refers to, resolved to a Texture2D once decoded and uploaded
+    struct TextureRef {
+        std::string type_;
+        std::string path_;
+    };
+
+    struct VertexCacheStatistics {
+        float acmr_ = 0.0f; // average cache miss ratio: transformed vertices per triangle, 0.5 at best
+        float atvr_ = 0.0f; // average transform to vertex ratio: transformed vertices per vertex, 1.0 at best
+    };
+
+    // what the import pipeline did to a mesh, kept by the model for the caller to log (see Model::getImportReports)
+    struct MeshImportReport {
+        VertexCacheStatistics cache_before_;
+        VertexCacheStatistics cache_after_;
+        size_t                vertices_removed_ = 0; // duplicates merged by welding
+        size_t                bytes_saved_      = 0; // vertex and index bytes no longer uploaded
+    };
+
+    // result of the CPU import phase, built on worker threads without touching GL
+    struct MeshData {
+        std::vector<Vertex>        vertices_;
+        std::vector<unsigned int>  indices_ ;
+        std::vector<TextureRef>    textures_;
+        std::vector<Meshlet>       meshlets_;  // level 0 only
+        std::vector<MeshLod>       lods_;      // level 0 first, empty for meshes that weren't optimized
+        MeshBounds                 bounds_;    // filled by computeMeshBounds once the vertices are final
+        // compact layouts only, filled by packVertexStreams
+        VertexLayout               layout_ = VertexLayout::Full;
+        std::vector<unsigned char> packed_vertices_;
+        std::vector<SkinVertex>    skin_;
+        // filled by packIndexStream, packed_indices_ is only used for UInt16
+        IndexType                  index_type_ = IndexType::UInt32;
+        std::vector<uint16_t>      packed_indices_;
+        MeshImportReport           report_;
+
+        VertexStreamView getVertexStreams() const;
+        IndexStreamView  getIndexStream() const;
+    };
+
+    // node of the imported hierarchy, owning a contiguous range of the model's meshes
+    struct ModelNode {
+        std::string  name_;
+        glm::mat4    transform_;
+        int          parent_;
+        unsigned int first_mesh_;
+        unsigned int mesh_count_;
+    };
+
     class Mesh {
     public:
         explicit Mesh(std::vector<Vertex>       vertices ,
                       std::vector<unsigned int> indices  ,
                       std::vector<Texture2D>    textures);
+        // take over an imported mesh, nothing is copied and only what residency asks for outlives the upload.
+        // with a geometry buffer the mesh becomes a range of it, otherwise it gets a buffer of its own
+        explicit Mesh(MeshData&&                      mesh_data ,
+                      std::vector<Texture2D>          textures  ,
+                      MeshResidency                   residency ,
+                      std::shared_ptr<GeometryBuffer> geometry  = nullptr);
+        // upload straight from external memory (e.g. a mapped cooked file),
+        // Keep can only be honoured for the Full layout, compact streams fall back to KeepCompressed
+        explicit Mesh(const VertexStreamView& vertex_streams,
+                      const IndexStreamView&  index_stream  ,
+                      std::vector<Texture2D>  textures      ,
+                      MeshResidency           residency = MeshResidency::DiscardAfterUpload,
+                      std::vector<Meshlet>    meshlets  = {},
+                      std::vector<MeshLod>    lods      = {},
+                      std::shared_ptr<GeometryBuffer> geometry = nullptr,
+                      const MeshBounds*       bounds    = nullptr);
 
-        ~Mesh() {
-
-        }
+        // GL objects have a single owner
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+        Mesh(Mesh&&) noexcept = default;
+        Mesh& operator=(Mesh&&) noexcept = default;
 
         constexpr std::vector<Vertex>&       getVertices() {return vertices_;}
         constexpr std::vector<unsigned int>& getIndices () {return indices_ ;}
         constexpr std::vector<Texture2D>&    getTextures() {return textures_;}
+        const std::vector<Texture2D>&        getTextures() const noexcept { return textures_; }
+        const std::shared_ptr<const Material>& getMaterial() const noexcept { return material_; }
+        const CompressedMeshCopy& getCompressedCopy() const noexcept { return compressed_; }
+        // CPU bytes held for vertex and index data
+        size_t getCpuBytes() const noexcept;
+
+        // with a cull_view only the visible meshlets are drawn, with a lod_selector a coarser level may be drawn instead
+        void draw(ShaderProgram& shader_program, const CullView* cull_view = nullptr, const LodSelector* lod_selector = nullptr);
+        // same as draw with getGeometry() already bound, lets meshes sharing a buffer skip the VAO switches
+        void drawBound(ShaderProgram& shader_program, const CullView* cull_view = nullptr, const LodSelector* lod_selector = nullptr);
+
+        // one whole level drawn instance_count times with getGeometry() bound, neither culled nor LOD selected
+        void drawInstanced(ShaderProgram& shader_program, GLsizei instance_count, size_t lod = 0);
+
+        const std::shared_ptr<GeometryBuffer>& getGeometry() const noexcept { return geometry_; }
+        const GeometryRange& getGeometryRange() const noexcept { return range_; }
+
+        // local bounds, see Model::getWorldBounds for them in world space
+        const MeshBounds& getBounds() const noexcept { return bounds_; }
+
+        // skinned meshes are posed by a bone palette, their bounds and meshlets only hold at rest
+        bool isSkinned() const noexcept { return skinned_; }
 
-        void draw(ShaderProgram& shader_program);
+        size_t getLodCount() const noexcept { return lods_.empty() ? 1 : lods_.size(); }
+        size_t getCurrentLod() const noexcept { return current_lod_; }
 
         void deleteBuffer();
 
     private:
-        unsigned int VAO, VBO, EBO;
+        std::shared_ptr<GeometryBuffer> geometry_;
+        GeometryRange                   range_;
 
         // mesh data
         std::vector<Vertex>       vertices_;
         std::vector<unsigned int> indices_ ;
         std::vector<Texture2D>    textures_;
+        // built from textures_ once they are final
+        std::shared_ptr<const Material> material_;
+        CompressedMeshCopy        compressed_;
+        std::vector<Meshlet>      meshlets_;
+        std::vector<MeshLod>      lods_;
+        size_t                    current_lod_ = 0;
+        bool                      skinned_     = false;
+        // around level 0, the sphere is where LOD selection measures the distance from
+        MeshBounds                bounds_;
+        // glMultiDrawElementsBaseVertex arguments, reused every draw
+        std::vector<GLsizei>      draw_counts_;
+        std::vector<const void*>  draw_offsets_;
+        std::vector<GLint>        draw_base_vertices_;
 
-        void setupMesh();
+        // bounds are computed from vertex_streams when not given
+        void setupMesh(const VertexStreamView& vertex_streams, const IndexStreamView& index_stream,
+                       std::shared_ptr<GeometryBuffer> geometry, const MeshBounds* bounds = nullptr);
+        void drawElements(const CullView* cull_view);
+        // index range of level 0, what residency keeps on the CPU
+        IndexStreamView getBaseIndexStream(const IndexStreamView& index_stream) const;
 
     };    
 
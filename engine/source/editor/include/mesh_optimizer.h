@@ -0,0 +1,37 @@
+#ifndef _MESH_OPTIMIZER_H__
+#define _MESH_OPTIMIZER_H__
+
+#include <cstddef>
+#include <vector>
+
+#include "editor/include/mesh.h"
+#include "editor/include/mesh_simplifier.h"
+
+namespace Hd2d {
+    // FIFO size used to report statistics, close to the post-transform cache of current desktop GPUs
+    constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertex_count,
+                                             unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+    // merge vertices whose attributes are equal, exactly or once snapped to an epsilon grid,
+    // returns how many vertices were removed
+    size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float epsilon = 0.0f);
+
+    // reorder triangles for the post-transform cache (Forsyth)
+    void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertex_count);
+    // reorder cache-friendly clusters of triangles so outward facing ones are drawn first,
+    // never letting ACMR grow beyond threshold times its input value
+    void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+    // reorder vertices in first use order and drop unreferenced ones
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // group triangles into meshlets with bounding spheres and normal cones,
+    // reordering indices so every meshlet is a contiguous range
+    std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // the full import pass: weld, cache, overdraw, meshlets, LODs then fetch, recording what it did in mesh_data.report_
+    void optimizeMesh(MeshData& mesh_data, const std::vector<float>& lod_ratios = DEFAULT_LOD_RATIOS, float weld_epsilon = 0.0f);
+}
+
+#endif // _MESH_OPTIMIZER_H__
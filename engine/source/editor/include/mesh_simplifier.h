@@ -0,0 +1,24 @@
+#ifndef _MESH_SIMPLIFIER_H__
+#define _MESH_SIMPLIFIER_H__
+
+#include <cstddef>
+#include <vector>
+
+#include "editor/include/mesh.h"
+
+namespace Hd2d {
+    // fraction of the full triangle count of every level, the first one is the mesh itself
+    inline const std::vector<float> DEFAULT_LOD_RATIOS = {1.0f, 0.5f, 0.25f, 0.1f};
+
+    // quadric error metric edge collapse onto existing vertices, so every level shares the vertex buffer.
+    // border and attribute seam vertices are never moved. returns the new index buffer and stores the
+    // largest collapse error, as a model space distance, in result_error
+    std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                           size_t target_index_count, float& result_error);
+
+    // append a simplified level to mesh_data.indices_ for every ratio and fill mesh_data.lods_,
+    // stops early once a level can't get meaningfully smaller than the previous one
+    void generateLods(MeshData& mesh_data, const std::vector<float>& lod_ratios);
+}
+
+#endif // _MESH_SIMPLIFIER_H__
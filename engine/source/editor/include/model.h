@@ -4,36 +4,130 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <future>
+#include <utility>
+#include <string_view>
+#include <unordered_map>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "editor/include/animation.h"
 #include "editor/include/shader.h"
 #include "editor/include/texture2d.h"
 #include "editor/include/mesh.h"
+#include "editor/include/mesh_simplifier.h"
+#include "editor/include/cooked_model.h"
+#include "editor/include/scene_graph.h"
 
 namespace Hd2d {
+    constexpr std::string_view COOKED_MODEL_EXTENSION = ".hd2dmesh";
+
     class Model {
     public:
-        Model(std::string_view path);
+        // all meshes are packed into one geometry buffer, pass one in to share it with other models of the same layout
+        Model(std::string_view path, VertexLayout layout = VertexLayout::Full, 
+              MeshResidency residency = MeshResidency::DiscardAfterUpload,
+              std::vector<float> lod_ratios = DEFAULT_LOD_RATIOS,
+              std::shared_ptr<GeometryBuffer> geometry = nullptr);
+
+        // defines the vertex shaders drawing this model need for its vertex layout, and HD2D_SKINNED when it has bones
+        std::vector<std::string> getShaderDefines() const;
+
+        // nullptr for static models
+        const std::shared_ptr<Skeleton>& getSkeleton() const noexcept { return skeleton_; }
+        const std::vector<std::shared_ptr<AnimationClip>>& getClips() const noexcept { return clips_; }
+
+        const std::shared_ptr<GeometryBuffer>& getGeometry() const noexcept { return geometry_; }
+        const std::vector<Mesh>&      getMeshes() const noexcept { return meshes_; }
+        const std::vector<ModelNode>& getNodes() const noexcept { return nodes_; }
+        // what the import pipeline did to each mesh, empty when the model was loaded from its cooked file
+        const std::vector<MeshImportReport>& getImportReports() const noexcept { return import_reports_; }
+
+        // every mesh at rest in the space the model is attached to, from the import bounds of its meshes
+        const MeshBounds& getBounds() const noexcept { return bounds_; }
+        // world boxes of every mesh of the instance attached at root_node, transformed in one batch.
+        // skinned meshes are boxed at rest
+        void getWorldBounds(const SceneGraph& scene, size_t root_node, std::vector<Aabb>& mesh_boxes) const;
+        Aabb getWorldBounds(const SceneGraph& scene, size_t root_node) const;
 
-        void draw(ShaderProgram& shader_program);
+        // report how many pixels across every mesh of the instance at root_node covers to the TextureStreamer,
+        // lod_selector and cull_view in world space. meshes outside cull_view ask for nothing
+        void requestTextures(const SceneGraph& scene, size_t root_node, const LodSelector& lod_selector,
+                             const CullView* cull_view = nullptr) const;
+
+        // CPU bytes this model holds for its meshes and hierarchy, GPU data excluded
+        size_t getCpuBytes() const noexcept;
+
+        // add a copy of the model's node hierarchy below parent, returns the scene node of its root.
+        // a model can be attached several times to place several instances
+        size_t attachTo(SceneGraph& scene, int parent);
+
+        // draw the instance attached at root_node, every node with its "model" and "normalMatrix" uniforms taken from the scene.
+        // skinned meshes are drawn in the space root_node is attached to, with the BonePalette bound by the caller (see Animator).
+        // cull_view and lod_selector are in world space, with them invisible meshlets are skipped 
+        // and distant meshes drawn at a coarser level
+        void draw(ShaderProgram& shader_program, const SceneGraph& scene, size_t root_node,
+                  const CullView* cull_view = nullptr, const LodSelector* lod_selector = nullptr);
+
+        // every mesh at level lod, instance_count times. transforms and poses come from per-instance attributes
+        // the caller has added to getGeometry(), see VertexAnimationCrowd
+        void drawInstanced(ShaderProgram& shader_program, GLsizei instance_count, size_t lod = 0);
 
         void deleteBuffer();
 
     private:
         // model data
-        std::vector<Texture2D> textures_loaded_;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+        // textures referenced by this model's meshes, keyed by their path in the model file.
+        // holds references into the TextureCache so textures shared between models are loaded once
+        std::unordered_map<std::string, std::shared_ptr<Texture2D>> textures_loaded_;
         std::vector<Mesh>      meshes_;
-        std::string_view       directory_;
+        std::shared_ptr<GeometryBuffer> geometry_;
+        std::vector<ModelNode> nodes_;
+        std::vector<MeshImportReport> import_reports_;
+        MeshBounds             bounds_;
+        std::shared_ptr<Skeleton>                   skeleton_;
+        std::vector<std::shared_ptr<AnimationClip>> clips_;
+        std::string            directory_;
+        VertexLayout           layout_;
+        MeshResidency          residency_;
+        std::vector<float>     lod_ratios_;
         bool                   gammaCorrection_;
 
+        // result of the worker side of a texture load: either a cache hit or decoded pixels to upload
+        struct TextureLoad {
+            std::string                normalized_path_;
+            uint64_t                   content_hash_ = 0;
+            std::shared_ptr<Texture2D> cached_;
+            std::string                cooked_path_; // a cooked copy sits next to the file, it's streamed instead
+            Image                      image_;
+            bool                       srgb_ = true;
+        };
+        // texture path paired with its in-flight load
+        using TextureDecodes = std::unordered_map<std::string, std::future<TextureLoad>>;
+
         void loadModel(std::string_view path);
+        void loadCookedModel(const CookedModel& cooked_model);
+        void importModel(std::string_view path, const std::string& cooked_path, uint64_t source_hash);
 
-        void processNode(aiNode *node, const aiScene *scene);
-        std::shared_ptr<Mesh> processMesh(aiMesh *mesh, const aiScene *scene);
-        std::shared_ptr<std::vector<Texture2D>> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+        void processNode(const aiNode *node, const aiScene *scene, int parent, std::vector<const aiMesh*>& scene_meshes);
+        // CPU import phase, safe to run on worker threads
+        static void processMesh(const aiMesh *mesh, const std::vector<int>& bone_ids, MeshData& mesh_data);
+        // skeleton over nodes_ from every mesh's bones, bone_ids maps each mesh's bones to skeleton bones (-1 when dropped)
+        void processSkeleton(const std::vector<const aiMesh*>& scene_meshes, std::vector<std::vector<int>>& bone_ids);
+        void processAnimations(const aiScene *scene);
+        static void processMaterial(const aiMaterial *material, std::vector<TextureRef>& textures);
+        static void loadMaterialTextures(const aiMaterial *mat, aiTextureType type, std::string typeName, std::vector<TextureRef>& textures);
+        void startTextureDecodes(const std::vector<TextureRef>& texture_refs, TextureDecodes& decodes) const;
+        // hash and decode the source file of load, unless the cache already holds its content
+        static void decodeTextureSource(TextureLoad& load);
+        // GL upload phase, runs on the thread owning the context
+        void uploadTextures(TextureDecodes& decodes);
+        std::vector<Texture2D> resolveTextures(const std::vector<TextureRef>& texture_refs);
+        void computeBounds();
+        // grow the geometry buffer once for a whole batch of meshes
+        void reserveGeometry(const std::vector<VertexStreamView>& vertex_streams, const std::vector<IndexStreamView>& index_streams);
     };
 }
 
@@ -0,0 +1,49 @@
+#ifndef _SCENE_GRAPH_H__
+#define _SCENE_GRAPH_H__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Hd2d {
+    // transform hierarchy stored as parallel arrays with every parent before its children,
+    // so one linear pass resolves world transforms and only subtrees below a changed node are recomputed
+    class SceneGraph {
+    public:
+        static constexpr int NO_PARENT = -1;
+
+        // parent has to be added already, that is what keeps the arrays in parent-before-child order
+        size_t addNode(int parent, const glm::mat4& local_transform = glm::mat4(1.0f), std::string_view name = {});
+        void   setLocalTransform(size_t node, const glm::mat4& local_transform);
+
+        size_t             getNodeCount() const noexcept { return parents_.size(); }
+        int                getParent(size_t node) const noexcept { return parents_[node]; }
+        const std::string& getName(size_t node) const noexcept { return names_[node]; }
+        const glm::mat4&   getLocalTransform(size_t node) const noexcept { return local_transforms_[node]; }
+        const glm::mat4&   getWorldTransform(size_t node) const noexcept { return world_transforms_[node]; }
+        // inverse transpose of the world transform's upper 3x3, what normals are transformed with
+        const glm::mat3&   getNormalMatrix(size_t node) const noexcept { return normal_matrices_[node]; }
+        // world transform was recomputed by the last update
+        bool               isChanged(size_t node) const noexcept { return changed_[node] != 0; }
+        // first node with that name, NO_PARENT when there is none
+        int                findNode(std::string_view name) const noexcept;
+
+        // recompute dirty nodes and everything below them, returns how many were recomputed
+        size_t update();
+
+    private:
+        std::vector<int>         parents_;
+        std::vector<glm::mat4>   local_transforms_;
+        std::vector<glm::mat4>   world_transforms_;
+        std::vector<glm::mat3>   normal_matrices_;
+        std::vector<uint8_t>     dirty_;   // local transform set since the last update
+        std::vector<uint8_t>     changed_; // world transform recomputed by the last update
+        std::vector<std::string> names_;
+    };
+}
+
+#endif // _SCENE_GRAPH_H__
@@ -1,12 +1,19 @@
 #ifndef _SHADER_H__
 #define _SHADER_H__
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <glm/mat3x3.hpp>
 #include <glm/mat4x4.hpp>
 
+#include "editor/include/hash.h"
+
 class Shader {
 public:
-    explicit Shader(std::string_view file_path);
+    // defines are inserted as "#define NAME" lines right after the #version line
+    explicit Shader(std::string_view file_path, const std::vector<std::string>& defines = {});
     // Shader(const Shader&) = delete;
     // Shader& operator=(const Shader&) = delete;
 
@@ -24,44 +31,82 @@ protected:
 
 class VertexShader : public Shader {
 public:
-    explicit VertexShader(std::string_view file_path);
+    explicit VertexShader(std::string_view file_path, const std::vector<std::string>& defines = {});
 };
 
 class FragmentShader : public Shader {
 public:
-    explicit FragmentShader(std::string_view file_path);
+    explicit FragmentShader(std::string_view file_path, const std::vector<std::string>& defines = {});
 };
 
 class GeometryShader : public Shader {
 public:
-    explicit GeometryShader(std::string_view file_path);
+    explicit GeometryShader(std::string_view file_path, const std::vector<std::string>& defines = {});
+};
+
+// uniform name hashed at compile time, hot paths keep one around so setting a uniform does no string work:
+//     static constexpr UniformId MODEL_UNIFORM{"model"};
+// array uniforms answer to their plain name as well as to every "name[i]"
+struct UniformId {
+    uint64_t hash_;
+
+    constexpr explicit UniformId(std::string_view name) noexcept : hash_ { Hd2d::fnv1a64(name) } {}
 };
 
 class ShaderProgram {
 public:
     ShaderProgram(std::string_view vertex_shader, 
-                  std::string_view fragment_shader);
+                  std::string_view fragment_shader,
+                  const std::vector<std::string>& defines = {});
     ShaderProgram(std::string_view vertex_shader, 
                   std::string_view geometry_shader,
-                  std::string_view fragment_shader);
+                  std::string_view fragment_shader,
+                  const std::vector<std::string>& defines = {});
 
     ~ShaderProgram();
 
     void use() const noexcept;
+    unsigned getId() const noexcept { return id_; }
 
+    // location of an active uniform, -1 (which glUniform* ignores) for names the program doesn't use
+    int getUniformLocation(UniformId uniform) const noexcept;
+
+    void setUniform(UniformId uniform, bool value) const noexcept;
+    void setUniform(UniformId uniform, int value) const noexcept;
+    void setUniform(UniformId uniform, unsigned int value) const noexcept;
+    void setUniform(UniformId uniform, float value) const noexcept;
+    void setUniform(UniformId uniform, const glm::vec3& value) const noexcept;
+    void setUniform(UniformId uniform, const glm::mat3& value) const noexcept;
+    void setUniform(UniformId uniform, const glm::mat4& value) const noexcept;
+
+    // hashes name, for setup code and cold paths
     void setUniform(const std::string_view name, bool value) const noexcept;
     void setUniform(const std::string_view name, int value) const noexcept;
     void setUniform(const std::string_view name, unsigned int value) const noexcept;
     void setUniform(const std::string_view name, float value) const noexcept;
     void setUniform(const std::string_view name, const glm::vec3& value) const noexcept;
+    void setUniform(const std::string_view name, const glm::mat3& value) const noexcept;
     void setUniform(const std::string_view name, const glm::mat4& value) const noexcept;
 
+    void setTexture(UniformId uniform, int value) const noexcept;
     void setTexture(std::string_view name, int value) const noexcept;
 
     void setUniformBlock(std::string_view name, int value) const noexcept;
 
 private:
-    unsigned id_;
+    // one slot of the open addressed location table, location_ -1 marks a free slot
+    struct UniformSlot {
+        uint64_t hash_     = 0;
+        int      location_ = -1;
+    };
+
+    unsigned                 id_;
+    std::vector<UniformSlot> uniform_slots_; // power of two sized, at most half full
+    uint64_t                 uniform_mask_ = 0;
+
+    // enumerate the active uniforms once the program is linked
+    void cacheUniformLocations();
+    void insertUniformLocation(uint64_t hash, int location);
 };
 
 
@@ -0,0 +1,43 @@
+#ifndef _SPRITE_ATLAS_H__
+#define _SPRITE_ATLAS_H__
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "editor/include/mapped_file.h"
+#include "editor/include/sprite_atlas_format.h"
+#include "editor/include/texture2d.h"
+
+namespace Hd2d {
+    // a cooked .hd2datlas: its sprite table stays in the mapping, its pages are uploaded once.
+    // sprites are indexed by position in the table, find turns a frame name into that index
+    class SpriteAtlas {
+    public:
+        explicit SpriteAtlas() = default;
+
+        // nullptr if the table or any page can't be loaded
+        static std::shared_ptr<SpriteAtlas> load(std::string_view atlas_path);
+
+        size_t getSpriteCount() const noexcept { return header_->sprite_count_; }
+        const SpriteAtlasSprite& getSprite(size_t index) const noexcept { return sprites_[index]; }
+        // index of the frame cooked from name (its file stem), -1 when there is none
+        int find(std::string_view name) const noexcept;
+
+        size_t getPageCount() const noexcept { return pages_.size(); }
+        const std::shared_ptr<Texture2D>& getPage(size_t page) const noexcept { return pages_[page]; }
+        // bind the page holding sprite index, sprites sorted by page need one bind per page
+        void bindPage(size_t index, GLenum texture_unit = 0) const;
+
+    private:
+        std::shared_ptr<MappedFile>             file_;
+        const SpriteAtlasHeader*                header_  = nullptr;
+        const SpriteAtlasSprite*                sprites_ = nullptr;
+        std::vector<std::shared_ptr<Texture2D>> pages_;
+    };
+}
+
+#endif // _SPRITE_ATLAS_H__
@@ -0,0 +1,46 @@
+#ifndef _SPRITE_ATLAS_COOK_H__
+#define _SPRITE_ATLAS_COOK_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "editor/include/sprite_atlas_format.h"
+#include "editor/include/texture_cook.h"
+
+namespace Hd2d {
+    // one decoded frame handed to the atlas cook, pixels are borrowed
+    struct SpriteFrame {
+        std::string          name_;
+        uint32_t             width_    = 0;
+        uint32_t             height_   = 0;
+        const unsigned char* rgba_     = nullptr; // width_ * height_ RGBA8 texels
+        float                pivot_[2] = {0.5f, 0.5f}; // in the untrimmed frame, 0..1 from its top left
+    };
+
+    struct SpriteAtlasCookSettings {
+        uint32_t max_page_size_ = 2048;
+        uint32_t padding_       = 2;    // texels around every rect, filled with its extruded edges so filtering doesn't bleed
+        bool     trim_          = true; // drop fully transparent rows and columns
+        bool     dedupe_        = true; // frames with the same trimmed texels share one rect
+    };
+
+    // pages are RGBA8 until written, then cooked like any other texture
+    struct CookedSpriteAtlas {
+        std::vector<SpriteAtlasPage>      pages_;
+        std::vector<SpriteAtlasSprite>    sprites_;
+        std::vector<std::vector<uint8_t>> page_pixels_;
+        size_t                            unique_frames_ = 0;
+
+        bool isValid() const noexcept { return !pages_.empty(); }
+    };
+
+    // trim, dedupe and MaxRects pack frames into as few pages as max_page_size_ allows, no GL involved
+    CookedSpriteAtlas cookSpriteAtlas(const std::vector<SpriteFrame>& frames, const SpriteAtlasCookSettings& settings);
+    // the table to atlas_path, each page to getSpriteAtlasPagePath cooked with page_settings
+    bool writeSpriteAtlas(std::string_view atlas_path, const CookedSpriteAtlas& atlas, const TextureCookSettings& page_settings);
+}
+
+#endif // _SPRITE_ATLAS_COOK_H__
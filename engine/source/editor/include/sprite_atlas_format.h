@@ -0,0 +1,57 @@
+#ifndef _SPRITE_ATLAS_FORMAT_H__
+#define _SPRITE_ATLAS_FORMAT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Hd2d {
+    constexpr std::string_view SPRITE_ATLAS_EXTENSION  = ".hd2datlas";
+    constexpr char             SPRITE_ATLAS_MAGIC[8]   = {'H', 'D', '2', 'D', 'A', 'T', 'L', 'S'};
+    constexpr uint32_t         SPRITE_ATLAS_VERSION    = 1;
+    constexpr uint32_t         SPRITE_ATLAS_ENDIAN_TAG = 0x01020304;
+
+    // .hd2datlas layout: SpriteAtlasHeader | page_count_ SpriteAtlasPage | sprite_count_ SpriteAtlasSprite sorted by name_hash_.
+    // page i is a .cpt next to the atlas, see getSpriteAtlasPagePath
+    struct SpriteAtlasHeader {
+        char     magic_[8];
+        uint32_t version_;
+        uint32_t endian_tag_;
+        uint32_t page_count_;
+        uint32_t sprite_count_;
+    };
+
+    struct SpriteAtlasPage {
+        uint32_t width_;
+        uint32_t height_;
+    };
+
+    // one frame, trimmed to its opaque texels. identical frames share a rect
+    struct SpriteAtlasSprite {
+        uint64_t name_hash_;  // fnv1a64 of the frame name, the source file stem
+        float    uv_min_[2];  // trimmed rect in page UVs, v grows downwards like the image rows
+        float    uv_max_[2];
+        float    pivot_[2];   // pivot in the trimmed rect, 0..1 spans it and values outside lie in the trimmed away border
+        uint16_t page_;
+        uint16_t x_;          // trimmed rect in page texels
+        uint16_t y_;
+        uint16_t width_;
+        uint16_t height_;
+        uint16_t source_width_; // frame size before trimming
+        uint16_t source_height_;
+        uint16_t reserved_;
+    };
+
+    static_assert(sizeof(SpriteAtlasHeader) == 24, "SpriteAtlasHeader is written to disk as is");
+    static_assert(sizeof(SpriteAtlasPage) == 8, "SpriteAtlasPage is written to disk as is");
+    static_assert(sizeof(SpriteAtlasSprite) == 48, "SpriteAtlasSprite is written to disk as is");
+
+    // header of a whole atlas file in memory, nullptr if it is truncated, from another version or endianness,
+    // or a sprite points outside its page
+    const SpriteAtlasHeader* validateSpriteAtlas(const unsigned char* bytes, size_t size) noexcept;
+    // atlas path without its extension, then _<page>.cpt
+    std::string getSpriteAtlasPagePath(std::string_view atlas_path, size_t page);
+}
+
+#endif // _SPRITE_ATLAS_FORMAT_H__
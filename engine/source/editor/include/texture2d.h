@@ -3,26 +3,26 @@
 
 #include <string>
 #include <glad/glad.h>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <vector>
 
+#include "editor/include/cpt_format.h"
+
 namespace Hd2d {
-    struct CptFileHead
-    {
-        char type_[3];
-        int mipmap_level_;
-        int width_;
-        int height_;
-        int gl_texture_format_;
-        int compress_size_;
+    // decoded pixels living on the CPU, safe to produce on any thread
+    struct Image {
+        int width_    = 0;
+        int height_   = 0;
+        int channels_ = 0;
+        std::shared_ptr<unsigned char> pixels_;
+        // filled by Texture2D::prepareImage: levels 1 and coarser with the same channels as pixels_
+        std::vector<std::vector<uint8_t>> mips_;
+        bool prepared_ = false;
+        bool opaque_   = false; // the alpha channel was added by prepareImage
 
-        // diff if the file head is cpt
-        static bool isCptFile(char* file_head) {
-            return strlen(file_head) ==  3  &&
-                        file_head[0] == 'c' && 
-                        file_head[1] == 'p' &&
-                        file_head[2] == 't' ;
-        }
+        bool isValid() const noexcept { return pixels_ != nullptr; }
     };
 
     class Texture2D
@@ -30,17 +30,37 @@ namespace Hd2d {
     public:
         explicit Texture2D() = default;
 
-        constexpr GLuint getTextureId() {return gl_texture_id_;}
+        constexpr GLuint getTextureId() const {return gl_texture_id_;}
+        GLenum getTextureFormat() const noexcept { return gl_texture_format_; }
+        int    getWidth() const noexcept { return width_; }
+        int    getHeight() const noexcept { return height_; }
 
         std::string& getTextureType() { return texture_type_;}
+        const std::string& getTextureType() const noexcept { return texture_type_; }
         void setTextureType(std::string type) { texture_type_ = type;}
         std::string& getPath() { return path_;}
         void setPath(std::string path) { path_ = path;}
 
         static bool isCptFileExist(std::string_view image_file_path);
-        static std::shared_ptr<Texture2D> loadFromFile(std::string_view image_file_path);
+        // and its mips were filtered for sampling as color (srgb) or as data
+        static bool isCptFileExist(std::string_view image_file_path, bool srgb);
+        // GL thread, RGTC is core but the S3TC and BPTC formats are extensions a context may lack
+        static bool isCptFormatSupported(CptFormat format);
+        static Image decodeImage(std::string_view image_file_path);
+        static Image decodeImage(const unsigned char* encoded, size_t encoded_size);
+        // RGB widened to RGBA and the mip chain built on the CPU, safe on worker threads.
+        // srgb filters the color channels in linear light, pass false for normal and other data maps
+        static void prepareImage(Image& image, bool srgb = true);
+        // prepares the image itself if no worker did
+        static std::shared_ptr<Texture2D> uploadImage(const Image& image);
+        static std::shared_ptr<Texture2D> loadFromFile(std::string_view image_file_path, bool srgb = true);
+        // decode on the thread pool, upload on the calling thread as each decode completes
+        static std::vector<std::future<Image>> decodeImages(const std::vector<std::string>& image_file_paths, bool prepare = false);
+        static std::vector<std::shared_ptr<Texture2D>> loadFromFiles(const std::vector<std::string>& image_file_paths);
         static std::shared_ptr<Texture2D> loadFromCptFile(std::string_view image_file_path);
-        static void compressImageFile(std::string_view image_file_path, std::string_view save_image_file_path);
+        // levels first_level and coarser of a validated .cpt in memory, see TextureStreamer for the finer ones
+        static std::shared_ptr<Texture2D> uploadCpt(const CptFileHead* cpt_file_head, uint16_t first_level = 0);
+        static bool compressImageFile(std::string_view image_file_path, std::string_view save_image_file_path);
         static std::shared_ptr<Texture2D> loadTexture(std::string_view png_path, std::string_view cpt_path);
         static std::shared_ptr<Texture2D> loadCubemap(std::vector<std::string>& faces);
         static void configTexture();
@@ -48,13 +68,13 @@ namespace Hd2d {
         static void configClampWrapper();
 
     private:
-        int mipmap_level_;
-        int width_;
-        int height_;
+        int mipmap_level_ = 0;
+        int width_        = 0;
+        int height_       = 0;
 
-        GLenum gl_texture_format_;
-        GLenum image_data_format_;
-        GLuint gl_texture_id_;
+        GLenum gl_texture_format_ = 0;
+        GLenum image_data_format_ = 0;
+        GLuint gl_texture_id_     = 0;
 
         std::string texture_type_;
         std::string path_;
@@ -0,0 +1,53 @@
+#ifndef _TEXTURE_CACHE_H__
+#define _TEXTURE_CACHE_H__
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "editor/include/texture2d.h"
+
+namespace Hd2d {
+    // process wide cache of uploaded textures, keyed by normalized path and by content hash.
+    // entries are weak: a texture lives as long as some Model holds it and its GL texture is deleted
+    // when the last reference goes away, which has to happen on the thread owning the GL context.
+    // lookups are safe from any thread.
+    class TextureCache {
+    public:
+        static TextureCache& getInstance();
+
+        static std::string normalizePath(std::string_view texture_path);
+
+        std::shared_ptr<Texture2D> findByPath(const std::string& normalized_path);
+        std::shared_ptr<Texture2D> findByHash(uint64_t content_hash);
+        // register a freshly uploaded texture under both keys, takes ownership of its GL texture.
+        // if another texture with the same content got in first that one is returned instead
+        std::shared_ptr<Texture2D> insert(const std::string& normalized_path, uint64_t content_hash,
+                                          std::shared_ptr<Texture2D> texture);
+        // make normalized_path resolve to an already cached texture
+        void alias(const std::string& normalized_path, const std::shared_ptr<Texture2D>& texture);
+
+    private:
+        static constexpr size_t SHARD_COUNT = 16;
+
+        template<typename Key>
+        struct Shard {
+            std::mutex                                          mutex_;
+            std::unordered_map<Key, std::weak_ptr<Texture2D>>   entries_;
+        };
+
+        std::array<Shard<std::string>, SHARD_COUNT> path_shards_;
+        std::array<Shard<uint64_t>,    SHARD_COUNT> hash_shards_;
+
+        TextureCache() = default;
+
+        Shard<std::string>& getShard(const std::string& normalized_path);
+        Shard<uint64_t>&    getShard(uint64_t content_hash);
+    };
+}
+
+#endif // _TEXTURE_CACHE_H__
@@ -0,0 +1,46 @@
+#ifndef _TEXTURE_COOK_H__
+#define _TEXTURE_COOK_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "editor/include/cpt_format.h"
+
+namespace Hd2d {
+    // bump whenever cooked output changes for the same input and settings, e.g. a new encoder or mip filter,
+    // so the asset database cooks every texture again
+    constexpr uint32_t TEXTURE_COOKER_VERSION = 1;
+
+    struct TextureCookSettings {
+        CptFormat format_            = CptFormat::Unknown; // Unknown picks with chooseCptFormat
+        bool      srgb_              = true;  // filter color formats in linear light, BC4/BC5 hold data and never are
+        bool      mip_chain_         = true;  // every level down to 1x1, else level 0 only
+        bool      premultiply_alpha_ = false; // color times alpha before filtering, for sprites blended with GL_ONE
+    };
+
+    // a .cpt in memory, levels_ offsets are file offsets so data_ starts at levels_[0].offset_
+    struct CookedTexture {
+        CptFileHead                head_{};
+        std::vector<CptMipLevel>   levels_;
+        std::vector<unsigned char> data_;
+
+        bool isValid() const noexcept { return !levels_.empty(); }
+    };
+
+    // what the asset database compares to tell cooks with different settings apart
+    uint64_t hashTextureCookSettings(const TextureCookSettings& settings) noexcept;
+
+    // BC4 for 1 channel, BC5 for 2, BC1 for 3 or opaque 4, BC7 when alpha is used
+    CptFormat chooseCptFormat(const unsigned char* pixels, int width, int height, int channels) noexcept;
+
+    // build the mip chain on the CPU and block compress every level on the thread pool, no GL involved
+    CookedTexture cookTexture(const unsigned char* pixels, int width, int height, int channels, const TextureCookSettings& settings);
+    bool writeCptFile(std::string_view cpt_path, const CookedTexture& texture);
+
+    // where the cooked copy of an image lives: the image path with its extension replaced by .cpt
+    std::string getCookedTexturePath(std::string_view image_path);
+}
+
+#endif // _TEXTURE_COOK_H__
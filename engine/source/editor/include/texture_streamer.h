@@ -0,0 +1,77 @@
+#ifndef _TEXTURE_STREAMER_H__
+#define _TEXTURE_STREAMER_H__
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "editor/include/cpt_format.h"
+#include "editor/include/mapped_file.h"
+#include "editor/include/texture2d.h"
+
+namespace Hd2d {
+    // levels this size and smaller are uploaded with the texture and never evicted
+    constexpr uint32_t STREAMING_RESIDENT_SIZE = 64;
+
+    // cooked textures whose finer mips come and go with the screen space demand reported each frame.
+    // levels are uploaded into and freed from the same GL texture, so Texture2D copies held by meshes stay valid.
+    // everything here runs on the thread owning the GL context
+    class TextureStreamer {
+    public:
+        static TextureStreamer& getInstance();
+
+        // GPU bytes all streamed textures may hold together, the always resident levels included
+        void   setBudget(size_t bytes) noexcept { budget_ = bytes; }
+        size_t getBudget() const noexcept { return budget_; }
+        size_t getResidentBytes() const noexcept { return resident_bytes_; }
+        // bytes one update may upload, spreads a camera cut over several frames instead of stalling one
+        void   setUploadLimit(size_t bytes) noexcept { upload_limit_ = bytes; }
+
+        // map a .cpt and upload its resident levels, nullptr if it isn't a loadable cpt.
+        // the same file loaded twice is the same texture, its GL texture is deleted with the last reference
+        std::shared_ptr<Texture2D> load(std::string_view cpt_path);
+
+        // the texture is drawn screen_pixels across this frame, the largest request of a frame wins
+        void request(GLuint texture_id, float screen_pixels) noexcept;
+
+        // once per frame: upload wanted levels coarse to fine, evicting the least recently needed ones over budget
+        void update();
+
+    private:
+        struct Entry {
+            std::weak_ptr<Texture2D>    texture_;
+            std::shared_ptr<MappedFile> file_;
+            const CptFileHead*          head_              = nullptr;
+            GLenum                      gl_format_         = 0;
+            uint16_t                    resident_level_    = 0; // finest level in GL
+            uint16_t                    floor_level_       = 0; // finest level that is never evicted
+            uint16_t                    wanted_level_      = 0;
+            float                       demand_pixels_     = 0.0f;
+            uint64_t                    last_needed_frame_ = 0;
+            size_t                      resident_bytes_    = 0;
+        };
+
+        std::unordered_map<GLuint, Entry>                         entries_;
+        std::unordered_map<std::string, std::weak_ptr<Texture2D>> paths_;
+        size_t   budget_         = size_t(256) << 20;
+        size_t   upload_limit_   = size_t(8) << 20;
+        size_t   resident_bytes_ = 0;
+        uint64_t frame_          = 1; // requests of the frame being drawn carry this, 0 means never needed
+
+        TextureStreamer() = default;
+
+        static uint16_t getWantedLevel(const Entry& entry);
+        static size_t getLevelSize(const Entry& entry, uint16_t level);
+        void uploadLevel(GLuint texture_id, Entry& entry);
+        void evictLevel(GLuint texture_id, Entry& entry);
+        // free levels of textures not needed this frame, least recently needed first, until bytes more fit
+        bool makeRoom(size_t bytes);
+    };
+}
+
+#endif // _TEXTURE_STREAMER_H__
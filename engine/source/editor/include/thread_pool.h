@@ -0,0 +1,86 @@
+#ifndef _THREAD_POOL_H__
+#define _THREAD_POOL_H__
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Hd2d {
+    class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned int thread_count);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // process wide pool, sized to the cores left over by the main (GL) thread
+        static ThreadPool& getInstance();
+
+        size_t getThreadCount() const noexcept { return workers_.size(); }
+
+        template<typename F>
+        auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+            using Result = std::invoke_result_t<std::decay_t<F>>;
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+            std::future<Result> future = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.emplace([packaged]() { (*packaged)(); });
+            }
+            condition_.notify_one();
+            return future;
+        }
+
+        // run body(i) for i in [0, count), the calling thread takes part in the work.
+        // the first exception body throws, on any thread, stops the loop and is rethrown here once every helper is done
+        void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+        // block until future is ready, running queued tasks meanwhile so nested waits can't starve the pool
+        template<typename T>
+        void wait(std::future<T>& future) {
+            while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                if (!runPendingTask())
+                    future.wait_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        // block until one of the still valid futures is ready, running queued tasks meanwhile.
+        // returns its index, or futures.size() once every future has been consumed with get()
+        template<typename T>
+        size_t waitAny(std::vector<std::future<T>>& futures) {
+            while (true) {
+                bool pending = false;
+                for (size_t i = 0; i < futures.size(); i++) {
+                    if (!futures[i].valid())
+                        continue;
+                    if (futures[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        return i;
+                    pending = true;
+                }
+                if (!pending)
+                    return futures.size();
+                if (!runPendingTask())
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+
+    private:
+        std::vector<std::thread>          workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex                        mutex_;
+        std::condition_variable           condition_;
+        bool                              stopping_;
+
+        void workerLoop();
+        bool runPendingTask();
+    };
+}
+
+#endif // _THREAD_POOL_H__
@@ -0,0 +1,105 @@
+#ifndef _VERTEX_ANIMATION_H__
+#define _VERTEX_ANIMATION_H__
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "editor/include/animation.h"
+#include "editor/include/model.h"
+#include "editor/include/shader.h"
+
+namespace Hd2d {
+    // texels per row of a vertex animation texture, frames wrap across rows
+    constexpr uint32_t VAT_TEXTURE_WIDTH        = 2048;
+    // units above anything a mesh binds its material textures to
+    constexpr GLenum   VAT_POSITION_TEXTURE_UNIT = 14;
+    constexpr GLenum   VAT_NORMAL_TEXTURE_UNIT   = 15;
+    // first vertex attribute of the per-instance stream, after the skin stream's 5 and 6
+    constexpr GLuint   VAT_INSTANCE_ATTRIBUTE    = 7;
+
+    // skinned positions and normals of one looping clip sampled at a fixed rate.
+    // texel frame * vertex_count_ + vertex holds a vertex of the model's geometry range, rows wrap at width_
+    struct VertexAnimationBake {
+        uint32_t               first_vertex_ = 0; // base vertex of the model inside its geometry buffer
+        uint32_t               vertex_count_ = 0;
+        uint32_t               frame_count_  = 0;
+        float                  frame_rate_   = 0.0f; // frames per second, frame_count_ frames span the clip exactly
+        uint32_t               width_        = 0;
+        uint32_t               height_       = 0;
+        std::vector<glm::vec3> positions_;
+        std::vector<glm::vec3> normals_;
+
+        bool isValid() const noexcept { return frame_count_ > 0 && vertex_count_ > 0; }
+    };
+
+    // pose every vertex of model for every frame of clip, in the space Model::draw puts skinned meshes in.
+    // reads the vertices back from the model's geometry buffer, so it works whatever the mesh residency
+    VertexAnimationBake bakeVertexAnimation(const Model& model, const AnimationClip& clip, float frame_rate = 30.0f);
+
+    // a bake uploaded as two float textures
+    class VertexAnimationTexture {
+    public:
+        explicit VertexAnimationTexture() = default;
+        ~VertexAnimationTexture();
+
+        VertexAnimationTexture(const VertexAnimationTexture&) = delete;
+        VertexAnimationTexture& operator=(const VertexAnimationTexture&) = delete;
+
+        // nullptr when the bake is empty or doesn't fit the GL texture size limit
+        static std::shared_ptr<VertexAnimationTexture> create(const VertexAnimationBake& bake);
+
+        // bind both textures and set the vat* uniforms of vertex_animation.vs
+        void bind(ShaderProgram& shader_program) const;
+        float getDuration() const noexcept { return frame_rate_ > 0.0f ? frame_count_ / frame_rate_ : 0.0f; }
+
+        void deleteTexture();
+
+    private:
+        GLuint   position_texture_id_ = 0;
+        GLuint   normal_texture_id_   = 0;
+        uint32_t first_vertex_        = 0;
+        uint32_t vertex_count_        = 0;
+        uint32_t frame_count_         = 0;
+        float    frame_rate_          = 0.0f;
+    };
+
+    // many copies of one model playing baked clips, drawn with one instanced draw per mesh and no CPU posing.
+    // per-instance attributes: world transform and (time offset, speed), like the grass instances
+    class VertexAnimationCrowd {
+    public:
+        explicit VertexAnimationCrowd() = default;
+        ~VertexAnimationCrowd();
+
+        VertexAnimationCrowd(const VertexAnimationCrowd&) = delete;
+        VertexAnimationCrowd& operator=(const VertexAnimationCrowd&) = delete;
+
+        size_t addInstance(const glm::mat4& transform, float time_offset = 0.0f, float speed = 1.0f);
+        void   setTransform(size_t instance, const glm::mat4& transform);
+        size_t getInstanceCount() const noexcept { return instances_.size(); }
+
+        // draw every instance at time seconds, shader_program being vertex_animation with the vat texture bound
+        void draw(ShaderProgram& shader_program, Model& model, float time, size_t lod = 0);
+
+        void deleteBuffer();
+
+    private:
+        struct Instance {
+            glm::mat4 transform_;
+            glm::vec2 time_; // offset in seconds, speed
+        };
+
+        std::vector<Instance> instances_;
+        unsigned int          InstanceVBO = 0;
+        size_t                vbo_capacity_ = 0;
+        bool                  dirty_        = true;
+
+        void upload();
+    };
+}
+
+#endif // _VERTEX_ANIMATION_H__
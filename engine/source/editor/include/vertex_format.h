@@ -0,0 +1,35 @@
+#ifndef _VERTEX_FORMAT_H__
+#define _VERTEX_FORMAT_H__
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "editor/include/mesh.h"
+
+namespace Hd2d {
+    // bytes per vertex of the main stream
+    size_t getVertexStride(VertexLayout layout) noexcept;
+    size_t getIndexSize(IndexType type) noexcept;
+    // smallest index type able to address vertex_count vertices
+    IndexType selectIndexType(size_t vertex_count) noexcept;
+    // defines a vertex shader needs to decode the layout, see edge.vs
+    std::vector<std::string> getShaderDefines(VertexLayout layout);
+
+    uint32_t packOctNormal(const glm::vec3& normal) noexcept;
+    uint64_t packTangentFrame(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent) noexcept;
+    glm::vec3 unpackOctNormal(uint32_t packed) noexcept;
+    // normal of a tangent frame, the third basis vector of its quaternion
+    glm::vec3 unpackTangentFrameNormal(uint64_t packed) noexcept;
+
+    // fill mesh_data's packed streams from its vertices, skin stream is dropped for static meshes
+    void packVertexStreams(MeshData& mesh_data, VertexLayout layout);
+    // pick mesh_data's index type and fill packed_indices_ when it is narrower than 32 bits
+    void packIndexStream(MeshData& mesh_data);
+    // CPU copy for MeshResidency::KeepCompressed
+    CompressedMeshCopy compressMeshCopy(const VertexStreamView& vertex_streams, const IndexStreamView& index_stream);
+}
+
+#endif // _VERTEX_FORMAT_H__
@@ -0,0 +1,205 @@
+#include "editor/include/animation.h"
+#include "editor/include/animation_compression.h"
+#include "editor/include/mesh.h"
+#include "editor/include/thread_pool.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+namespace Hd2d {
+    namespace {
+        constexpr float UNORM16_MAX = 65535.0f;
+
+        // key starting the segment time falls into, clamped to the first and last key, and the factor into that segment
+        const AnimationKey* findKey(const AnimationTrack& track, const AnimationKey* keys, float time, float& factor) {
+            const AnimationKey* first = keys + track.first_key_;
+            const AnimationKey* last  = first + track.key_count_;
+            const AnimationKey* next  = std::upper_bound(first, last, time,
+                                                         [](float t, const AnimationKey& key) { return t < key.time_; });
+            factor = 0.0f;
+            if (next == first)
+                return first;
+            if (next != last) {
+                const float length = static_cast<float>(next->time_ - next[-1].time_);
+                factor = length > 0.0f ? std::clamp((time - next[-1].time_) / length, 0.0f, 1.0f) : 0.0f;
+            }
+            return next - 1;
+        }
+
+        glm::vec3 decodeVector(const AnimationTrack& track, const AnimationKey& key) {
+            return track.min_ + glm::vec3(key.value_[0], key.value_[1], key.value_[2]) * (track.extent_ / UNORM16_MAX);
+        }
+
+        glm::vec3 sampleVector(const AnimationTrack& track, const AnimationKey* keys, float time) {
+            float t;
+            const AnimationKey* key = findKey(track, keys, time, t);
+            const glm::vec3 value   = decodeVector(track, key[0]);
+            return t > 0.0f ? glm::mix(value, decodeVector(track, key[1]), t) : value;
+        }
+
+        glm::quat sampleRotation(const AnimationTrack& track, const AnimationKey* keys, float time) {
+            float t;
+            const AnimationKey* key = findKey(track, keys, time, t);
+            const glm::quat from    = unpackQuaternion(key[0].value_);
+            if (t <= 0.0f)
+                return from;
+            // nlerp: keys are dense enough after reduction that slerp's constant velocity isn't worth its trig
+            glm::quat to = unpackQuaternion(key[1].value_);
+            if (glm::dot(from, to) < 0.0f)
+                to = -to;
+            return glm::normalize(from * (1.0f - t) + to * t);
+        }
+    }
+
+    /// @brief build a skeleton over a model's node hierarchy
+    /// @param nodes model nodes, parents before children
+    /// @param bone_nodes node index of every bone, bone ids in the vertices index this
+    /// @param bone_offsets inverse bind matrix of every bone
+    /// @return skeleton, nullptr when there are no bones
+    std::shared_ptr<Skeleton> Skeleton::create(const std::vector<ModelNode>& nodes, std::vector<uint32_t> bone_nodes,
+                                               std::vector<glm::mat4> bone_offsets) {
+        if (bone_nodes.empty() || bone_nodes.size() != bone_offsets.size())
+            return nullptr;
+
+        std::shared_ptr<Skeleton> skeleton = std::make_shared<Skeleton>();
+        skeleton->parents_.reserve(nodes.size());
+        skeleton->bind_transforms_.reserve(nodes.size());
+        for (const ModelNode& node : nodes) {
+            skeleton->parents_.push_back(node.parent_);
+            skeleton->bind_transforms_.push_back(node.transform_);
+        }
+        for (uint32_t bone_node : bone_nodes)
+            if (bone_node >= nodes.size()) {
+                std::cout << "Error::Skeleton::Bone_Node_Out_Of_Range" << std::endl;
+                return nullptr;
+            }
+        skeleton->bone_nodes_   = std::move(bone_nodes);
+        skeleton->bone_offsets_ = std::move(bone_offsets);
+        return skeleton;
+    }
+
+    void Skeleton::computeGlobalTransforms(const std::vector<glm::mat4>& local_transforms,
+                                           std::vector<glm::mat4>& global_transforms) const {
+        // parents come first, so one pass resolves the whole hierarchy
+        const size_t node_count = getNodeCount();
+        global_transforms.resize(node_count);
+        for (size_t node = 0; node < node_count; node++) {
+            const int parent = parents_[node];
+            global_transforms[node] = parent >= 0 ? global_transforms[parent] * local_transforms[node] : local_transforms[node];
+        }
+    }
+
+    /// @brief evaluate the clip
+    /// @param time seconds, clamped to the keys of each channel
+    /// @param local_transforms one per skeleton node, only animated nodes are written
+    void AnimationClip::sample(float time, std::vector<glm::mat4>& local_transforms) const {
+        const float key_time = duration_ > 0.0f ? std::clamp(time / duration_, 0.0f, 1.0f) * UNORM16_MAX : 0.0f;
+        const AnimationKey* keys = keys_.data();
+        for (const AnimationChannel& channel : channels_) {
+            if (channel.node_ >= local_transforms.size())
+                continue;
+
+            const glm::vec3 position = channel.position_.key_count_ > 0 ? sampleVector(channel.position_, keys, key_time)
+                                                                         : glm::vec3(0.0f);
+            const glm::quat rotation = channel.rotation_.key_count_ > 0 ? sampleRotation(channel.rotation_, keys, key_time)
+                                                                         : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            const glm::vec3 scale    = channel.scale_.key_count_ > 0 ? sampleVector(channel.scale_, keys, key_time)
+                                                                      : glm::vec3(1.0f);
+
+            // T * R * S without building the three matrices
+            glm::mat4 transform = glm::mat4_cast(rotation);
+            transform[0] *= scale.x;
+            transform[1] *= scale.y;
+            transform[2] *= scale.z;
+            transform[3]  = glm::vec4(position, 1.0f);
+            local_transforms[channel.node_] = transform;
+        }
+    }
+
+    size_t AnimationClip::getByteSize() const noexcept {
+        return channels_.size() * sizeof(AnimationChannel) + keys_.size() * sizeof(AnimationKey);
+    }
+
+    Animator::~Animator() {
+        deleteBuffer();
+    }
+
+    size_t Animator::addInstance(std::shared_ptr<const Skeleton> skeleton, std::shared_ptr<const AnimationClip> clip) {
+        Instance instance;
+        instance.skeleton_ = std::move(skeleton);
+        instance.clip_     = std::move(clip);
+        instances_.push_back(std::move(instance));
+        palettes_.resize(instances_.size() * MAX_SKELETON_BONES, glm::mat4(1.0f));
+        // pose it right away so it can be drawn before the first update
+        poseInstance(instances_.back(), 0.0f, &palettes_[(instances_.size() - 1) * MAX_SKELETON_BONES]);
+        return instances_.size() - 1;
+    }
+
+    void Animator::play(size_t instance, std::shared_ptr<const AnimationClip> clip, float start_time, bool loop) {
+        instances_[instance].clip_ = std::move(clip);
+        instances_[instance].time_ = start_time;
+        instances_[instance].loop_ = loop;
+    }
+
+    void Animator::update(float delta_time) {
+        ThreadPool::getInstance().parallelFor(instances_.size(), [this, delta_time](size_t i) {
+            poseInstance(instances_[i], delta_time, &palettes_[i * MAX_SKELETON_BONES]);
+        });
+    }
+
+    void Animator::poseInstance(Instance& instance, float delta_time, glm::mat4* palette) {
+        const Skeleton* skeleton = instance.skeleton_.get();
+        if (skeleton == nullptr)
+            return;
+
+        instance.local_transforms_.assign(skeleton->bind_transforms_.begin(), skeleton->bind_transforms_.end());
+        if (const AnimationClip* clip = instance.clip_.get()) {
+            instance.time_ += delta_time * instance.speed_;
+            if (clip->duration_ > 0.0f)
+                instance.time_ = instance.loop_ ? instance.time_ - clip->duration_ * std::floor(instance.time_ / clip->duration_)
+                                                : std::clamp(instance.time_, 0.0f, clip->duration_);
+            clip->sample(instance.time_, instance.local_transforms_);
+        }
+
+        skeleton->computeGlobalTransforms(instance.local_transforms_, instance.global_transforms_);
+        const size_t bone_count = std::min<size_t>(skeleton->getBoneCount(), MAX_SKELETON_BONES);
+        for (size_t bone = 0; bone < bone_count; bone++)
+            palette[bone] = instance.global_transforms_[skeleton->bone_nodes_[bone]] * skeleton->bone_offsets_[bone];
+    }
+
+    void Animator::upload() {
+        constexpr size_t palette_bytes = MAX_SKELETON_BONES * sizeof(glm::mat4);
+        if (UBO == 0)
+            glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        // orphan the old storage so a frame still reading it doesn't stall the upload
+        ubo_instance_capacity_ = std::max(ubo_instance_capacity_, instances_.size());
+        glBufferData(GL_UNIFORM_BUFFER, ubo_instance_capacity_ * palette_bytes, nullptr, GL_STREAM_DRAW);
+        for (size_t i = 0; i < instances_.size(); i++) {
+            const Skeleton* skeleton = instances_[i].skeleton_.get();
+            if (skeleton == nullptr)
+                continue;
+            const size_t bone_count = std::min<size_t>(skeleton->getBoneCount(), MAX_SKELETON_BONES);
+            glBufferSubData(GL_UNIFORM_BUFFER, i * palette_bytes, bone_count * sizeof(glm::mat4), getPalette(i));
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void Animator::bind(size_t instance) const {
+        constexpr size_t palette_bytes = MAX_SKELETON_BONES * sizeof(glm::mat4);
+        if (UBO == 0 || instance >= ubo_instance_capacity_)
+            return;
+        glBindBufferRange(GL_UNIFORM_BUFFER, BONE_PALETTE_BINDING, UBO, instance * palette_bytes, palette_bytes);
+    }
+
+    void Animator::deleteBuffer() {
+        if (UBO != 0)
+            glDeleteBuffers(1, &UBO);
+        UBO = 0;
+        ubo_instance_capacity_ = 0;
+    }
+}
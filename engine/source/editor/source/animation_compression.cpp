@@ -0,0 +1,195 @@
+#include "editor/include/animation_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace Hd2d {
+    namespace {
+        // smallest three components always lie within +-1/sqrt(2)
+        constexpr float QUATERNION_COMPONENT_RANGE = 0.70710678f;
+        constexpr float UNORM15_MAX                = 32767.0f;
+        constexpr float UNORM16_MAX                = 65535.0f;
+
+        glm::quat alignedNlerp(const glm::quat& from, glm::quat to, float t) {
+            if (glm::dot(from, to) < 0.0f)
+                to = -to;
+            return glm::normalize(from * (1.0f - t) + to * t);
+        }
+
+        float rotationError(const glm::quat& a, const glm::quat& b) {
+            return 2.0f * std::acos(std::min(1.0f, std::abs(glm::dot(a, b))));
+        }
+
+        /// @brief greedy key reduction: grow each segment while lerping its end points reproduces every skipped key
+        /// @return indices of the keys to keep, the first and last always among them
+        template<typename T, typename Lerp, typename Error>
+        std::vector<uint32_t> reduceKeys(const std::vector<float>& times, const std::vector<T>& values,
+                                         Lerp lerp, Error error, float tolerance) {
+            const size_t key_count = std::min(times.size(), values.size());
+            if (key_count == 0)
+                return {};
+            // a constant track needs a single key
+            bool constant = true;
+            for (size_t k = 1; k < key_count && constant; k++)
+                constant = error(values[k], values[0]) <= tolerance;
+            if (constant)
+                return {0};
+
+            std::vector<uint32_t> kept{0};
+            size_t start = 0;
+            for (size_t end = 2; end < key_count; end++) {
+                const float length = times[end] - times[start];
+                bool fits = true;
+                for (size_t k = start + 1; k < end && fits; k++) {
+                    const float t = length > 0.0f ? (times[k] - times[start]) / length : 0.0f;
+                    fits = error(values[k], lerp(values[start], values[end], t)) <= tolerance;
+                }
+                if (!fits) {
+                    start = end - 1;
+                    kept.push_back(static_cast<uint32_t>(start));
+                }
+            }
+            kept.push_back(static_cast<uint32_t>(key_count - 1));
+            return kept;
+        }
+
+        uint16_t quantizeTime(float time, float duration) {
+            if (duration <= 0.0f)
+                return 0;
+            return static_cast<uint16_t>(std::lround(std::clamp(time / duration, 0.0f, 1.0f) * UNORM16_MAX));
+        }
+
+        AnimationTrack quantizeTrack(const std::vector<float>& times, const std::vector<glm::vec3>& values,
+                                     const std::vector<uint32_t>& kept, float duration, std::vector<AnimationKey>& keys) {
+            AnimationTrack track{};
+            track.first_key_ = static_cast<uint32_t>(keys.size());
+            track.key_count_ = static_cast<uint32_t>(kept.size());
+            if (kept.empty())
+                return track;
+
+            glm::vec3 range_max = values[kept[0]];
+            track.min_ = values[kept[0]];
+            for (uint32_t k : kept) {
+                track.min_ = glm::min(track.min_, values[k]);
+                range_max  = glm::max(range_max, values[k]);
+            }
+            track.extent_ = range_max - track.min_;
+            for (uint32_t k : kept) {
+                AnimationKey key{};
+                key.time_ = quantizeTime(times[k], duration);
+                for (int c = 0; c < 3; c++)
+                    if (track.extent_[c] > 0.0f)
+                        key.value_[c] = static_cast<uint16_t>(std::lround((values[k][c] - track.min_[c]) / track.extent_[c] * UNORM16_MAX));
+                keys.push_back(key);
+            }
+            return track;
+        }
+    }
+
+    void packQuaternion(const glm::quat& rotation, uint16_t packed[3]) noexcept {
+        glm::vec4 q(rotation.x, rotation.y, rotation.z, rotation.w);
+        int largest = 0;
+        for (int i = 1; i < 4; i++)
+            if (std::abs(q[i]) > std::abs(q[largest]))
+                largest = i;
+        // q and -q are the same rotation, keeping the dropped component positive lets it be rebuilt from the others
+        if (q[largest] < 0.0f)
+            q = -q;
+
+        uint64_t bits  = static_cast<uint64_t>(largest);
+        int      shift = 2;
+        for (int i = 0; i < 4; i++) {
+            if (i == largest)
+                continue;
+            const float snorm = std::clamp(q[i] / QUATERNION_COMPONENT_RANGE, -1.0f, 1.0f);
+            bits  |= static_cast<uint64_t>(std::lround((snorm * 0.5f + 0.5f) * UNORM15_MAX)) << shift;
+            shift += 15;
+        }
+        packed[0] = static_cast<uint16_t>(bits);
+        packed[1] = static_cast<uint16_t>(bits >> 16);
+        packed[2] = static_cast<uint16_t>(bits >> 32);
+    }
+
+    glm::quat unpackQuaternion(const uint16_t packed[3]) noexcept {
+        const uint64_t bits = static_cast<uint64_t>(packed[0]) | (static_cast<uint64_t>(packed[1]) << 16) |
+                              (static_cast<uint64_t>(packed[2]) << 32);
+        const int largest = static_cast<int>(bits & 3u);
+
+        glm::vec4 q(0.0f);
+        float sum = 0.0f;
+        int   shift = 2;
+        for (int i = 0; i < 4; i++) {
+            if (i == largest)
+                continue;
+            const float unorm = static_cast<float>((bits >> shift) & 0x7FFFu) / UNORM15_MAX;
+            q[i]   = (unorm * 2.0f - 1.0f) * QUATERNION_COMPONENT_RANGE;
+            sum   += q[i] * q[i];
+            shift += 15;
+        }
+        q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+        return glm::quat(q.w, q.x, q.y, q.z);
+    }
+
+    /// @brief build a compressed clip
+    /// @param name clip name
+    /// @param duration seconds, key times are quantized relative to it
+    /// @param channels imported keys per animated node
+    /// @param settings error each reduced track may have against the imported keys, quantization adds its own on top
+    /// @return clip with every channel's position, rotation and scale keys stored next to each other
+    std::shared_ptr<AnimationClip> compressAnimationClip(std::string name, float duration,
+                                                         const std::vector<RawAnimationChannel>& channels,
+                                                         const AnimationCompressionSettings& settings) {
+        std::shared_ptr<AnimationClip> clip = std::make_shared<AnimationClip>();
+        clip->name_     = std::move(name);
+        clip->duration_ = duration;
+        clip->channels_.reserve(channels.size());
+
+        auto vec3_lerp      = [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); };
+        auto position_error = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+        auto scale_error    = [](const glm::vec3& a, const glm::vec3& b) {
+            const glm::vec3 d = glm::abs(a - b);
+            return std::max(d.x, std::max(d.y, d.z));
+        };
+
+        for (const RawAnimationChannel& raw : channels) {
+            AnimationChannel channel{};
+            channel.node_ = raw.node_;
+
+            std::vector<uint32_t> kept = reduceKeys(raw.position_times_, raw.positions_, vec3_lerp, position_error,
+                                                    settings.position_error_);
+            channel.position_ = quantizeTrack(raw.position_times_, raw.positions_, kept, duration, clip->keys_);
+
+            // neighbours in the same hemisphere, so interpolation takes the short way like the sampler does
+            std::vector<glm::quat> rotations(raw.rotations_);
+            for (size_t k = 1; k < rotations.size(); k++)
+                if (glm::dot(rotations[k - 1], rotations[k]) < 0.0f)
+                    rotations[k] = -rotations[k];
+            kept = reduceKeys(raw.rotation_times_, rotations, alignedNlerp, rotationError, settings.rotation_error_);
+            channel.rotation_.first_key_ = static_cast<uint32_t>(clip->keys_.size());
+            channel.rotation_.key_count_ = static_cast<uint32_t>(kept.size());
+            for (uint32_t k : kept) {
+                AnimationKey key{};
+                key.time_ = quantizeTime(raw.rotation_times_[k], duration);
+                packQuaternion(glm::normalize(rotations[k]), key.value_);
+                clip->keys_.push_back(key);
+            }
+
+            kept = reduceKeys(raw.scale_times_, raw.scales_, vec3_lerp, scale_error, settings.scale_error_);
+            channel.scale_ = quantizeTrack(raw.scale_times_, raw.scales_, kept, duration, clip->keys_);
+
+            clip->channels_.push_back(channel);
+        }
+        clip->keys_.shrink_to_fit();
+        return clip;
+    }
+
+    size_t getRawByteSize(const std::vector<RawAnimationChannel>& channels) noexcept {
+        size_t byte_size = 0;
+        for (const RawAnimationChannel& channel : channels)
+            byte_size += channel.position_times_.size() * (sizeof(float) + sizeof(glm::vec3)) +
+                         channel.rotation_times_.size() * (sizeof(float) + sizeof(glm::quat)) +
+                         channel.scale_times_.size() * (sizeof(float) + sizeof(glm::vec3));
+        return byte_size;
+    }
+}
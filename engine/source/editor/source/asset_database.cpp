@@ -0,0 +1,342 @@
+#include "editor/include/asset_database.h"
+#include "editor/include/hash.h"
+#include "editor/include/mapped_file.h"
+#include "editor/include/thread_pool.h"
+
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <system_error>
+
+namespace Hd2d {
+    namespace {
+        constexpr char     ASSET_INDEX_MAGIC[8]   = {'H', 'D', '2', 'D', 'A', 'D', 'B', '\0'};
+        constexpr uint32_t ASSET_INDEX_VERSION    = 1;
+        constexpr uint32_t ASSET_INDEX_ENDIAN_TAG = 0x01020304;
+
+        // index layout: header | sources | artifacts | dependencies | NUL terminated paths, referenced by offset
+        struct AssetIndexHeader {
+            char     magic_[8];
+            uint32_t version_;
+            uint32_t endian_tag_;
+            uint32_t source_count_;
+            uint32_t artifact_count_;
+            uint32_t dependency_count_;
+            uint32_t strings_size_;
+        };
+
+        struct AssetIndexSource {
+            uint32_t path_;
+            uint32_t reserved_;
+            uint64_t size_;
+            int64_t  write_time_;
+            uint64_t content_hash_;
+        };
+
+        struct AssetIndexArtifact {
+            uint32_t path_;
+            uint32_t cooker_version_;
+            uint32_t first_dependency_;
+            uint32_t dependency_count_;
+            uint64_t settings_hash_;
+        };
+
+        struct AssetIndexDependency {
+            uint32_t path_;
+            uint32_t reserved_;
+            uint64_t content_hash_;
+        };
+
+        static_assert(sizeof(AssetIndexHeader) == 32, "AssetIndexHeader is written to disk as is");
+        static_assert(sizeof(AssetIndexSource) == 32, "AssetIndexSource is written to disk as is");
+        static_assert(sizeof(AssetIndexArtifact) == 24, "AssetIndexArtifact is written to disk as is");
+        static_assert(sizeof(AssetIndexDependency) == 16, "AssetIndexDependency is written to disk as is");
+
+        // size and write time as the index stores them, false if the file isn't there
+        bool statFile(const std::filesystem::path& path, uint64_t& size, int64_t& write_time) {
+            std::error_code error;
+            size = std::filesystem::file_size(path, error);
+            if (error)
+                return false;
+            const auto time = std::filesystem::last_write_time(path, error);
+            if (error)
+                return false;
+            write_time = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+        class StringTable {
+        public:
+            uint32_t add(const std::string& text) {
+                auto it = offsets_.find(text);
+                if (it != offsets_.end())
+                    return it->second;
+                const uint32_t offset = static_cast<uint32_t>(bytes_.size());
+                bytes_.insert(bytes_.end(), text.begin(), text.end());
+                bytes_.push_back('\0');
+                offsets_.emplace(text, offset);
+                return offset;
+            }
+            const std::vector<char>& getBytes() const noexcept { return bytes_; }
+
+        private:
+            std::vector<char>                         bytes_;
+            std::unordered_map<std::string, uint32_t> offsets_;
+        };
+    }
+
+    AssetDatabase& AssetDatabase::getInstance() {
+        static AssetDatabase asset_database;
+        return asset_database;
+    }
+
+    /// @brief load the index, call before any loading thread uses the database
+    /// @param index_path index file, paths in it are relative to its directory
+    /// @return true if an index was read, false if the database starts empty
+    bool AssetDatabase::open(const std::filesystem::path& index_path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index_path.empty())
+            return false;
+        index_path_ = std::filesystem::absolute(index_path).lexically_normal();
+        root_       = index_path_.parent_path();
+        sources_.clear();
+        artifacts_.clear();
+        dirty_ = false;
+
+        std::ifstream file(index_path_, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        std::vector<char> bytes(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(bytes.data(), static_cast<std::streamsize>(bytes.size())) || bytes.size() < sizeof(AssetIndexHeader))
+            return false;
+
+        AssetIndexHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        const size_t expected = sizeof(AssetIndexHeader) + size_t(header.source_count_) * sizeof(AssetIndexSource) +
+                                size_t(header.artifact_count_) * sizeof(AssetIndexArtifact) +
+                                size_t(header.dependency_count_) * sizeof(AssetIndexDependency) + header.strings_size_;
+        if (std::memcmp(header.magic_, ASSET_INDEX_MAGIC, sizeof(ASSET_INDEX_MAGIC)) != 0 ||
+            header.version_ != ASSET_INDEX_VERSION || header.endian_tag_ != ASSET_INDEX_ENDIAN_TAG ||
+            expected != bytes.size() || header.strings_size_ == 0 || bytes.back() != '\0') {
+            std::cout << "Error::AssetDatabase::Index_Not_Supported " << index_path_.generic_string() << std::endl;
+            return false;
+        }
+
+        const char* cursor  = bytes.data() + sizeof(AssetIndexHeader);
+        const char* strings = bytes.data() + bytes.size() - header.strings_size_;
+        auto getString = [&](uint32_t offset) { return std::string{offset < header.strings_size_ ? strings + offset : ""}; };
+
+        for (uint32_t i = 0; i < header.source_count_; i++, cursor += sizeof(AssetIndexSource)) {
+            AssetIndexSource source;
+            std::memcpy(&source, cursor, sizeof(source));
+            sources_[getString(source.path_)] = SourceState{source.size_, source.write_time_, source.content_hash_};
+        }
+        const char* dependencies = cursor + size_t(header.artifact_count_) * sizeof(AssetIndexArtifact);
+        for (uint32_t i = 0; i < header.artifact_count_; i++, cursor += sizeof(AssetIndexArtifact)) {
+            AssetIndexArtifact artifact;
+            std::memcpy(&artifact, cursor, sizeof(artifact));
+            if (size_t(artifact.first_dependency_) + artifact.dependency_count_ > header.dependency_count_)
+                continue;
+            ArtifactState& state = artifacts_[getString(artifact.path_)];
+            state.cooker_version_ = artifact.cooker_version_;
+            state.settings_hash_  = artifact.settings_hash_;
+            for (uint32_t j = 0; j < artifact.dependency_count_; j++) {
+                AssetIndexDependency dependency;
+                std::memcpy(&dependency, dependencies + size_t(artifact.first_dependency_ + j) * sizeof(AssetIndexDependency), sizeof(dependency));
+                state.dependencies_.emplace_back(getString(dependency.path_), dependency.content_hash_);
+            }
+        }
+        return true;
+    }
+
+    /// @brief write the index to a tmp file next to it, then rename it over the old one
+    /// @return false if it couldn't be written, true when it was or nothing changed
+    bool AssetDatabase::save() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dirty_ || index_path_.empty())
+            return true;
+
+        StringTable                       strings;
+        std::vector<AssetIndexSource>     sources;
+        std::vector<AssetIndexArtifact>   artifacts;
+        std::vector<AssetIndexDependency> dependencies;
+        sources.reserve(sources_.size());
+        for (const auto& [key, state] : sources_)
+            sources.push_back(AssetIndexSource{strings.add(key), 0, state.size_, state.write_time_, state.content_hash_});
+        artifacts.reserve(artifacts_.size());
+        for (const auto& [key, state] : artifacts_) {
+            artifacts.push_back(AssetIndexArtifact{strings.add(key), state.cooker_version_, static_cast<uint32_t>(dependencies.size()),
+                                                   static_cast<uint32_t>(state.dependencies_.size()), state.settings_hash_});
+            for (const auto& [dependency_key, content_hash] : state.dependencies_)
+                dependencies.push_back(AssetIndexDependency{strings.add(dependency_key), 0, content_hash});
+        }
+        // an empty table still needs its terminator
+        strings.add("");
+
+        AssetIndexHeader header{};
+        std::memcpy(header.magic_, ASSET_INDEX_MAGIC, sizeof(ASSET_INDEX_MAGIC));
+        header.version_          = ASSET_INDEX_VERSION;
+        header.endian_tag_       = ASSET_INDEX_ENDIAN_TAG;
+        header.source_count_     = static_cast<uint32_t>(sources.size());
+        header.artifact_count_   = static_cast<uint32_t>(artifacts.size());
+        header.dependency_count_ = static_cast<uint32_t>(dependencies.size());
+        header.strings_size_     = static_cast<uint32_t>(strings.getBytes().size());
+
+        std::filesystem::path tmp_path = index_path_;
+        tmp_path += ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(sources.data()), static_cast<std::streamsize>(sources.size() * sizeof(AssetIndexSource)));
+            file.write(reinterpret_cast<const char*>(artifacts.data()), static_cast<std::streamsize>(artifacts.size() * sizeof(AssetIndexArtifact)));
+            file.write(reinterpret_cast<const char*>(dependencies.data()), static_cast<std::streamsize>(dependencies.size() * sizeof(AssetIndexDependency)));
+            file.write(strings.getBytes().data(), static_cast<std::streamsize>(strings.getBytes().size()));
+            if (!file) {
+                std::cout << "Error::AssetDatabase::Index_Not_Successfully_Written " << tmp_path.generic_string() << std::endl;
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tmp_path, index_path_, error);
+        if (error) {
+            std::cout << "Error::AssetDatabase::Index_Not_Successfully_Written " << index_path_.generic_string() << std::endl;
+            return false;
+        }
+        dirty_ = false;
+        return true;
+    }
+
+    std::string AssetDatabase::getKey(std::string_view path) {
+        std::filesystem::path absolute = std::filesystem::absolute(std::filesystem::path{path}).lexically_normal();
+        if (root_.empty())
+            return absolute.generic_string();
+        std::filesystem::path relative = absolute.lexically_relative(root_);
+        return relative.empty() ? absolute.generic_string() : relative.generic_string();
+    }
+
+    std::filesystem::path AssetDatabase::getPath(const std::string& key) {
+        std::filesystem::path path{key};
+        return path.is_absolute() ? path : root_ / path;
+    }
+
+    /// @brief content hash of a source by key, trusted from the index while size and write time are unchanged
+    uint64_t AssetDatabase::getKeyHash(const std::string& key) {
+        const std::filesystem::path path = getPath(key);
+        uint64_t size       = 0;
+        int64_t  write_time = 0;
+        if (!statFile(path, size, write_time))
+            return 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sources_.find(key);
+            if (it != sources_.end() && it->second.size_ == size && it->second.write_time_ == write_time)
+                return it->second.content_hash_;
+        }
+
+        // hashed outside the lock so loading threads don't queue behind a large file
+        uint64_t content_hash = FNV_OFFSET_BASIS;
+        if (size > 0) {
+            std::shared_ptr<MappedFile> file = MappedFile::open(path.generic_string());
+            if (!file)
+                return 0;
+            content_hash = fnv1a64(file->getData(), file->getSize());
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        sources_[key] = SourceState{size, write_time, content_hash};
+        dirty_ = true;
+        return content_hash;
+    }
+
+    uint64_t AssetDatabase::getSourceHash(std::string_view source_path) {
+        return getKeyHash(getKey(source_path));
+    }
+
+    bool AssetDatabase::isRecorded(std::string_view artifact_path) {
+        const std::string key = getKey(artifact_path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return artifacts_.count(key) != 0;
+    }
+
+    bool AssetDatabase::isUpToDate(std::string_view artifact_path, uint32_t cooker_version) {
+        const std::string key = getKey(artifact_path);
+        std::vector<std::pair<std::string, uint64_t>> dependencies;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = artifacts_.find(key);
+            if (it == artifacts_.end() || it->second.cooker_version_ != cooker_version)
+                return false;
+            dependencies = it->second.dependencies_;
+        }
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(getPath(key), error))
+            return false;
+        for (const auto& [dependency_key, content_hash] : dependencies)
+            if (getKeyHash(dependency_key) != content_hash)
+                return false;
+        return true;
+    }
+
+    bool AssetDatabase::isUpToDate(std::string_view artifact_path, const std::vector<std::string>& dependencies,
+                                   uint32_t cooker_version, uint64_t settings_hash) {
+        const std::string key = getKey(artifact_path);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = artifacts_.find(key);
+            if (it == artifacts_.end() || it->second.settings_hash_ != settings_hash ||
+                it->second.dependencies_.size() != dependencies.size())
+                return false;
+            for (size_t i = 0; i < dependencies.size(); i++)
+                if (it->second.dependencies_[i].first != getKey(dependencies[i]))
+                    return false;
+        }
+        return isUpToDate(artifact_path, cooker_version);
+    }
+
+    void AssetDatabase::record(std::string_view artifact_path, const std::vector<std::string>& dependencies,
+                               uint32_t cooker_version, uint64_t settings_hash) {
+        ArtifactState state;
+        state.cooker_version_ = cooker_version;
+        state.settings_hash_  = settings_hash;
+        for (const std::string& dependency : dependencies) {
+            std::string dependency_key = getKey(dependency);
+            const uint64_t content_hash = getKeyHash(dependency_key);
+            state.dependencies_.emplace_back(std::move(dependency_key), content_hash);
+        }
+        const std::string key = getKey(artifact_path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        artifacts_[key] = std::move(state);
+        dirty_ = true;
+    }
+
+    /// @brief incremental batch cook, checks and cooks both run on the thread pool
+    /// @param jobs artifacts to bring up to date
+    /// @param failed jobs whose cook returned false, they stay unrecorded and are tried again next time
+    /// @return jobs cooked
+    size_t AssetDatabase::cookOutdated(const std::vector<AssetCookJob>& jobs, size_t& failed) {
+        ThreadPool& pool = ThreadPool::getInstance();
+        // 0 up to date, 1 cooked, 2 failed
+        std::vector<std::future<int>> results;
+        results.reserve(jobs.size());
+        for (const AssetCookJob& job : jobs)
+            results.push_back(pool.submit([this, &job]() {
+                if (isUpToDate(job.artifact_path_, job.dependencies_, job.cooker_version_, job.settings_hash_))
+                    return 0;
+                if (!job.cook_())
+                    return 2;
+                record(job.artifact_path_, job.dependencies_, job.cooker_version_, job.settings_hash_);
+                return 1;
+            }));
+
+        size_t cooked = 0;
+        failed = 0;
+        for (std::future<int>& result : results) {
+            pool.wait(result);
+            const int outcome = result.get();
+            cooked += outcome == 1;
+            failed += outcome == 2;
+        }
+        return cooked;
+    }
+}
@@ -0,0 +1,225 @@
+#include "editor/include/bc_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+namespace Hd2d {
+    namespace {
+        // BC7 4 bit index weights, out of 64
+        constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        // mode 6 endpoints expanded to 8 bits, the lowest bit of every channel is the endpoint's p-bit
+        struct Bc7Endpoints {
+            int color_[2][4];
+        };
+
+        struct BitWriter {
+            uint8_t* bytes_;
+            int      position_ = 0;
+
+            void write(uint32_t value, int bit_count) {
+                for (int i = 0; i < bit_count; i++, position_++)
+                    if ((value >> i) & 1u)
+                        bytes_[position_ >> 3] |= uint8_t(1u << (position_ & 7));
+            }
+        };
+
+        /// @brief snap an endpoint to 7 bits per channel plus the p-bit shared by its four channels
+        /// @param target endpoint in [0, 255]
+        /// @param color 8 bit result, (7 bit value << 1) | p-bit
+        void quantizeEndpoint(const float target[4], int color[4]) {
+            float best_error = std::numeric_limits<float>::max();
+            for (int p_bit = 0; p_bit < 2; p_bit++) {
+                int   candidate[4];
+                float error = 0.0f;
+                for (int channel = 0; channel < 4; channel++) {
+                    const int value = std::clamp(int(std::lround((target[channel] - p_bit) * 0.5f)), 0, 127);
+                    candidate[channel] = (value << 1) | p_bit;
+                    const float d = candidate[channel] - target[channel];
+                    error += d * d;
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    std::memcpy(color, candidate, sizeof(candidate));
+                }
+            }
+        }
+
+        /// @brief pick the closest of the 16 palette entries for every texel
+        /// @return summed squared error of the block
+        int assignIndices(const uint8_t rgba[64], const Bc7Endpoints& endpoints, uint8_t indices[16]) {
+            int palette[16][4];
+            for (int i = 0; i < 16; i++)
+                for (int channel = 0; channel < 4; channel++)
+                    palette[i][channel] = ((64 - BC7_WEIGHTS[i]) * endpoints.color_[0][channel] +
+                                           BC7_WEIGHTS[i] * endpoints.color_[1][channel] + 32) >> 6;
+
+            int total_error = 0;
+            for (int texel = 0; texel < 16; texel++) {
+                const uint8_t* pixel = rgba + texel * 4;
+                int best_error = std::numeric_limits<int>::max();
+                for (int i = 0; i < 16; i++) {
+                    int error = 0;
+                    for (int channel = 0; channel < 4; channel++) {
+                        const int d = palette[i][channel] - pixel[channel];
+                        error += d * d;
+                    }
+                    if (error < best_error) {
+                        best_error     = error;
+                        indices[texel] = uint8_t(i);
+                    }
+                }
+                total_error += best_error;
+            }
+            return total_error;
+        }
+
+        /// @brief endpoints minimizing the squared error for fixed indices
+        /// @return false when every texel uses the same weight and the system is singular
+        bool fitEndpoints(const uint8_t rgba[64], const uint8_t indices[16], float endpoints[2][4]) {
+            float a = 0.0f, b = 0.0f, c = 0.0f;
+            float rhs0[4] = {}, rhs1[4] = {};
+            for (int texel = 0; texel < 16; texel++) {
+                const float w1 = BC7_WEIGHTS[indices[texel]] / 64.0f;
+                const float w0 = 1.0f - w1;
+                a += w0 * w0;
+                b += w0 * w1;
+                c += w1 * w1;
+                for (int channel = 0; channel < 4; channel++) {
+                    rhs0[channel] += w0 * rgba[texel * 4 + channel];
+                    rhs1[channel] += w1 * rgba[texel * 4 + channel];
+                }
+            }
+            const float determinant = a * c - b * b;
+            if (std::fabs(determinant) < 1e-6f)
+                return false;
+            for (int channel = 0; channel < 4; channel++) {
+                endpoints[0][channel] = std::clamp((c * rhs0[channel] - b * rhs1[channel]) / determinant, 0.0f, 255.0f);
+                endpoints[1][channel] = std::clamp((a * rhs1[channel] - b * rhs0[channel]) / determinant, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        /// @brief initial endpoints at the extremes of the block's principal axis
+        void principalEndpoints(const uint8_t rgba[64], float endpoints[2][4]) {
+            float mean[4] = {};
+            for (int texel = 0; texel < 16; texel++)
+                for (int channel = 0; channel < 4; channel++)
+                    mean[channel] += rgba[texel * 4 + channel] / 16.0f;
+
+            float covariance[4][4] = {};
+            for (int texel = 0; texel < 16; texel++) {
+                float d[4];
+                for (int channel = 0; channel < 4; channel++)
+                    d[channel] = rgba[texel * 4 + channel] - mean[channel];
+                for (int i = 0; i < 4; i++)
+                    for (int j = 0; j < 4; j++)
+                        covariance[i][j] += d[i] * d[j];
+            }
+
+            // power iteration, converges fast enough for a 4x4 matrix
+            float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+            for (int iteration = 0; iteration < 8; iteration++) {
+                float next[4] = {};
+                for (int i = 0; i < 4; i++)
+                    for (int j = 0; j < 4; j++)
+                        next[i] += covariance[i][j] * axis[j];
+                const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+                if (length < 1e-6f)
+                    break;
+                for (int i = 0; i < 4; i++)
+                    axis[i] = next[i] / length;
+            }
+
+            float t_min = std::numeric_limits<float>::max(), t_max = std::numeric_limits<float>::lowest();
+            for (int texel = 0; texel < 16; texel++) {
+                float t = 0.0f;
+                for (int channel = 0; channel < 4; channel++)
+                    t += (rgba[texel * 4 + channel] - mean[channel]) * axis[channel];
+                t_min = std::min(t_min, t);
+                t_max = std::max(t_max, t);
+            }
+            for (int channel = 0; channel < 4; channel++) {
+                endpoints[0][channel] = std::clamp(mean[channel] + t_min * axis[channel], 0.0f, 255.0f);
+                endpoints[1][channel] = std::clamp(mean[channel] + t_max * axis[channel], 0.0f, 255.0f);
+            }
+        }
+    }
+
+    void encodeBc1Block(const uint8_t rgba[64], uint8_t block[8]) noexcept {
+        stb_compress_dxt_block(block, rgba, 0, STB_DXT_HIGHQUAL);
+    }
+
+    void encodeBc3Block(const uint8_t rgba[64], uint8_t block[16]) noexcept {
+        stb_compress_dxt_block(block, rgba, 1, STB_DXT_HIGHQUAL);
+    }
+
+    void encodeBc4Block(const uint8_t rgba[64], uint8_t block[8]) noexcept {
+        uint8_t red[16];
+        for (int texel = 0; texel < 16; texel++)
+            red[texel] = rgba[texel * 4];
+        stb_compress_bc4_block(block, red);
+    }
+
+    void encodeBc5Block(const uint8_t rgba[64], uint8_t block[16]) noexcept {
+        uint8_t red_green[32];
+        for (int texel = 0; texel < 16; texel++) {
+            red_green[texel * 2]     = rgba[texel * 4];
+            red_green[texel * 2 + 1] = rgba[texel * 4 + 1];
+        }
+        stb_compress_bc5_block(block, red_green);
+    }
+
+    /// @brief BC7 mode 6: principal axis endpoints, then a few least squares refinements
+    /// @param rgba 16 texels, row order
+    /// @param block 16 byte output
+    void encodeBc7Block(const uint8_t rgba[64], uint8_t block[16]) noexcept {
+        float        targets[2][4];
+        Bc7Endpoints endpoints;
+        uint8_t      indices[16];
+        principalEndpoints(rgba, targets);
+        quantizeEndpoint(targets[0], endpoints.color_[0]);
+        quantizeEndpoint(targets[1], endpoints.color_[1]);
+        int error = assignIndices(rgba, endpoints, indices);
+
+        for (int iteration = 0; iteration < 2 && error > 0; iteration++) {
+            if (!fitEndpoints(rgba, indices, targets))
+                break;
+            Bc7Endpoints refined;
+            uint8_t      refined_indices[16];
+            quantizeEndpoint(targets[0], refined.color_[0]);
+            quantizeEndpoint(targets[1], refined.color_[1]);
+            const int refined_error = assignIndices(rgba, refined, refined_indices);
+            if (refined_error >= error)
+                break;
+            error     = refined_error;
+            endpoints = refined;
+            std::memcpy(indices, refined_indices, sizeof(indices));
+        }
+
+        // the anchor index is stored without its top bit, swap the endpoints to clear it
+        if (indices[0] & 8) {
+            std::swap(endpoints.color_[0], endpoints.color_[1]);
+            for (uint8_t& index : indices)
+                index = uint8_t(15 - index);
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter writer{block};
+        writer.write(1u << 6, 7);
+        for (int channel = 0; channel < 4; channel++) {
+            writer.write(uint32_t(endpoints.color_[0][channel] >> 1), 7);
+            writer.write(uint32_t(endpoints.color_[1][channel] >> 1), 7);
+        }
+        writer.write(uint32_t(endpoints.color_[0][0] & 1), 1);
+        writer.write(uint32_t(endpoints.color_[1][0] & 1), 1);
+        writer.write(indices[0], 3);
+        for (int texel = 1; texel < 16; texel++)
+            writer.write(indices[texel], 4);
+    }
+}
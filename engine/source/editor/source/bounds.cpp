@@ -0,0 +1,190 @@
+#include "editor/include/bounds.h"
+#include "editor/include/mesh.h"
+#include "editor/include/vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HD2D_BOUNDS_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace Hd2d {
+    namespace {
+        glm::vec3 loadVec3(const unsigned char* position) {
+            glm::vec3 p;
+            std::memcpy(&p, position, sizeof(p));
+            return p;
+        }
+
+#if HD2D_BOUNDS_SSE
+        // xyz in the low lanes, w holds whatever follows the position and is never read back
+        inline __m128 loadPosition(const unsigned char* position) {
+            return _mm_loadu_ps(reinterpret_cast<const float*>(position));
+        }
+
+        // the last position of a tightly packed stream can't be read 16 bytes wide
+        inline __m128 loadLastPosition(const unsigned char* position) {
+            float xyzw[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            std::memcpy(xyzw, position, 3 * sizeof(float));
+            return _mm_loadu_ps(xyzw);
+        }
+
+        inline glm::vec3 storeVec3(__m128 value) {
+            float xyzw[4];
+            _mm_storeu_ps(xyzw, value);
+            return glm::vec3(xyzw[0], xyzw[1], xyzw[2]);
+        }
+#endif
+    }
+
+    /// @brief bounding box of a strided position stream
+    /// @param positions first position, 3 floats
+    /// @param stride bytes from one position to the next
+    /// @param count positions
+    /// @return box, empty when count is 0
+    Aabb computeAabb(const void* positions, size_t stride, size_t count) noexcept {
+        Aabb box;
+        if (count == 0)
+            return box;
+        const unsigned char* bytes = static_cast<const unsigned char*>(positions);
+#if HD2D_BOUNDS_SSE
+        // every position but a tightly packed last one has 4 more readable bytes behind it
+        const size_t wide_count = stride >= 4 * sizeof(float) ? count : count - 1;
+        const __m128 first = wide_count > 0 ? loadPosition(bytes) : loadLastPosition(bytes);
+        // two accumulator pairs so consecutive min/max don't wait on each other
+        __m128 min0 = first, max0 = first, min1 = first, max1 = first;
+        size_t i = 1;
+        for (; i + 2 <= wide_count; i += 2) {
+            const __m128 a = loadPosition(bytes + i * stride);
+            const __m128 b = loadPosition(bytes + (i + 1) * stride);
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+            min1 = _mm_min_ps(min1, b);
+            max1 = _mm_max_ps(max1, b);
+        }
+        for (; i < count; i++) {
+            const __m128 p = i < wide_count ? loadPosition(bytes + i * stride) : loadLastPosition(bytes + i * stride);
+            min0 = _mm_min_ps(min0, p);
+            max0 = _mm_max_ps(max0, p);
+        }
+        box.min_ = storeVec3(_mm_min_ps(min0, min1));
+        box.max_ = storeVec3(_mm_max_ps(max0, max1));
+#else
+        box.min_ = box.max_ = loadVec3(bytes);
+        for (size_t i = 1; i < count; i++) {
+            const glm::vec3 p = loadVec3(bytes + i * stride);
+            box.min_ = glm::min(box.min_, p);
+            box.max_ = glm::max(box.max_, p);
+        }
+#endif
+        return box;
+    }
+
+    /// @brief sphere centered on box reaching every position, not minimal but stable and one pass
+    /// @param box computeAabb of the same positions
+    BoundingSphere computeBoundingSphere(const void* positions, size_t stride, size_t count, const Aabb& box) noexcept {
+        BoundingSphere sphere;
+        if (count == 0 || box.isEmpty())
+            return sphere;
+        sphere.center_ = box.getCenter();
+        const unsigned char* bytes = static_cast<const unsigned char*>(positions);
+
+        float max_distance2 = 0.0f;
+        size_t i = 0;
+#if HD2D_BOUNDS_SSE
+        // four positions at a time, transposed so each lane measures one of them
+        const size_t wide_count = stride >= 4 * sizeof(float) ? count : count - 1;
+        const __m128 center_x = _mm_set1_ps(sphere.center_.x);
+        const __m128 center_y = _mm_set1_ps(sphere.center_.y);
+        const __m128 center_z = _mm_set1_ps(sphere.center_.z);
+        __m128 farthest = _mm_setzero_ps();
+        for (; i + 4 <= wide_count; i += 4) {
+            __m128 x = loadPosition(bytes + i * stride);
+            __m128 y = loadPosition(bytes + (i + 1) * stride);
+            __m128 z = loadPosition(bytes + (i + 2) * stride);
+            __m128 w = loadPosition(bytes + (i + 3) * stride);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            const __m128 dx = _mm_sub_ps(x, center_x);
+            const __m128 dy = _mm_sub_ps(y, center_y);
+            const __m128 dz = _mm_sub_ps(z, center_z);
+            const __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            farthest = _mm_max_ps(farthest, distance2);
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, farthest);
+        max_distance2 = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+        for (; i < count; i++) {
+            const glm::vec3 d = loadVec3(bytes + i * stride) - sphere.center_;
+            max_distance2 = std::max(max_distance2, glm::dot(d, d));
+        }
+        sphere.radius_ = std::sqrt(max_distance2);
+        return sphere;
+    }
+
+    MeshBounds computeMeshBounds(const VertexStreamView& vertex_streams) noexcept {
+        MeshBounds bounds;
+        const size_t stride = getVertexStride(vertex_streams.layout_);
+        bounds.box_    = computeAabb(vertex_streams.vertices_, stride, vertex_streams.vertex_count_);
+        bounds.sphere_ = computeBoundingSphere(vertex_streams.vertices_, stride, vertex_streams.vertex_count_, bounds.box_);
+        return bounds;
+    }
+
+    /// @brief move local boxes into world space in one pass
+    /// @param boxes count local boxes, empty ones stay empty
+    /// @param transforms count local to world matrices, affine
+    /// @param transformed count output boxes, may alias boxes
+    void transformAabbs(const Aabb* boxes, const glm::mat4* transforms, Aabb* transformed, size_t count) noexcept {
+#if HD2D_BOUNDS_SSE
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+#endif
+        for (size_t i = 0; i < count; i++) {
+            if (boxes[i].isEmpty()) {
+                transformed[i] = boxes[i];
+                continue;
+            }
+            const glm::vec3 center = boxes[i].getCenter();
+            const glm::vec3 extent = boxes[i].getExtent();
+#if HD2D_BOUNDS_SSE
+            const float* m = &transforms[i][0][0];
+            const __m128 column0 = _mm_loadu_ps(m);
+            const __m128 column1 = _mm_loadu_ps(m + 4);
+            const __m128 column2 = _mm_loadu_ps(m + 8);
+            const __m128 column3 = _mm_loadu_ps(m + 12);
+            // the center moves with the matrix, the extent with its absolute 3x3 part
+            __m128 world_center = _mm_add_ps(column3, _mm_mul_ps(column0, _mm_set1_ps(center.x)));
+            world_center = _mm_add_ps(world_center, _mm_mul_ps(column1, _mm_set1_ps(center.y)));
+            world_center = _mm_add_ps(world_center, _mm_mul_ps(column2, _mm_set1_ps(center.z)));
+            __m128 world_extent = _mm_mul_ps(_mm_and_ps(column0, abs_mask), _mm_set1_ps(extent.x));
+            world_extent = _mm_add_ps(world_extent, _mm_mul_ps(_mm_and_ps(column1, abs_mask), _mm_set1_ps(extent.y)));
+            world_extent = _mm_add_ps(world_extent, _mm_mul_ps(_mm_and_ps(column2, abs_mask), _mm_set1_ps(extent.z)));
+            transformed[i].min_ = storeVec3(_mm_sub_ps(world_center, world_extent));
+            transformed[i].max_ = storeVec3(_mm_add_ps(world_center, world_extent));
+#else
+            const glm::mat4& transform = transforms[i];
+            const glm::vec3 world_center = glm::vec3(transform * glm::vec4(center, 1.0f));
+            const glm::mat3 absolute(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])),
+                                     glm::abs(glm::vec3(transform[2])));
+            const glm::vec3 world_extent = absolute * extent;
+            transformed[i].min_ = world_center - world_extent;
+            transformed[i].max_ = world_center + world_extent;
+#endif
+        }
+    }
+
+    void transformSpheres(const BoundingSphere* spheres, const glm::mat4* transforms, BoundingSphere* transformed, size_t count) noexcept {
+        for (size_t i = 0; i < count; i++) {
+            const glm::mat4& transform = transforms[i];
+            // non-uniform scale grows the sphere by its largest axis
+            const float scale2 = std::max(std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                                                   glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+                                          glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])));
+            const float radius = spheres[i].radius_ * std::sqrt(scale2);
+            transformed[i].center_ = glm::vec3(transform * glm::vec4(spheres[i].center_, 1.0f));
+            transformed[i].radius_ = radius;
+        }
+    }
+}
@@ -23,6 +23,10 @@ namespace Hd2d {
                     shader_path_ = root_folder_ / value;
                 } else if (name == "ModelPath") {
                     model_path_ = root_folder_ / value;
+                } else if (name == "AssetIndexPath") {
+                    asset_index_path_ = root_folder_ / value;
+                } else if (name == "DemoCrowd") {
+                    demo_crowd_ = value == "1" || value == "true";
                 }
             }
         }
@@ -35,4 +39,8 @@ namespace Hd2d {
     const std::filesystem::path& ConfigManager::getShaderPath() const { return shader_path_;}
 
     const std::filesystem::path& ConfigManager::getModelPath() const {return model_path_;}
+
+    const std::filesystem::path& ConfigManager::getAssetIndexPath() const {return asset_index_path_;}
+
+    bool ConfigManager::isDemoCrowdEnabled() const { return demo_crowd_; }
 }
\ No newline at end of file
@@ -0,0 +1,419 @@
+#include "editor/include/cooked_model.h"
+#include "editor/include/hash.h"
+#include "editor/include/vertex_format.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+namespace Hd2d {
+    static_assert(std::is_trivially_copyable_v<Vertex>, "cooked vertex streams are copied byte for byte");
+    static_assert(std::is_trivially_copyable_v<Meshlet>, "cooked meshlets are copied byte for byte");
+    static_assert(std::is_trivially_copyable_v<MeshLod>, "cooked levels of detail are copied byte for byte");
+    static_assert(std::is_trivially_copyable_v<MeshBounds> && sizeof(MeshBounds) == 40, "cooked bounds are copied byte for byte");
+    static_assert(std::is_trivially_copyable_v<AnimationChannel> && std::is_trivially_copyable_v<AnimationKey>,
+                  "cooked animation keys are copied byte for byte");
+    static_assert(sizeof(AnimationKey) == 8 && sizeof(AnimationChannel) % 16 == 0, "cooked animation layout changed");
+
+    namespace {
+        constexpr char COOKED_MODEL_MAGIC[8] = {'H', 'D', '2', 'D', 'M', 'E', 'S', 'H'};
+
+        uint64_t alignUp(uint64_t offset) {
+            return (offset + COOKED_MODEL_ALIGNMENT - 1) & ~(COOKED_MODEL_ALIGNMENT - 1);
+        }
+
+        // grows a byte blob section by section, keeping every section aligned
+        class CookedWriter {
+        public:
+            uint64_t reserve(uint64_t size) {
+                uint64_t offset = alignUp(bytes_.size());
+                bytes_.resize(offset + size, 0);
+                return offset;
+            }
+
+            uint64_t append(const void* data, uint64_t size) {
+                uint64_t offset = reserve(size);
+                if (size > 0)
+                    std::memcpy(bytes_.data() + offset, data, size);
+                return offset;
+            }
+
+            template<typename T>
+            T* at(uint64_t offset) { return reinterpret_cast<T*>(bytes_.data() + offset); }
+
+            const std::vector<unsigned char>& getBytes() const { return bytes_; }
+
+        private:
+            std::vector<unsigned char> bytes_;
+        };
+
+        class StringTable {
+        public:
+            CookedString add(std::string_view text) {
+                CookedString cooked_string{static_cast<uint32_t>(chars_.size()), static_cast<uint32_t>(text.size())};
+                chars_.insert(chars_.end(), text.begin(), text.end());
+                return cooked_string;
+            }
+
+            const std::string& getChars() const { return chars_; }
+
+        private:
+            std::string chars_;
+        };
+    }
+
+    /// @brief content hash of an asset source file
+    /// @param source_file_path file to hash
+    /// @return FNV-1a of the file bytes, 0 if the file can't be read
+    uint64_t CookedModel::hashSourceFile(std::string_view source_file_path) {
+        std::shared_ptr<MappedFile> source = MappedFile::open(source_file_path);
+        if (!source)
+            return 0;
+        return fnv1a64(source->getData(), source->getSize());
+    }
+
+    uint32_t CookedModel::hashLodRatios(const std::vector<float>& lod_ratios) {
+        return static_cast<uint32_t>(fnv1a64(lod_ratios.data(), lod_ratios.size() * sizeof(float)));
+    }
+
+    /// @brief map a cooked model and check that it is still valid for the source
+    /// @param cooked_file_path .hd2dmesh file path
+    /// @param source_hash content hash of the source model file
+    /// @param layout vertex layout the model is requested with
+    /// @param lod_ratios level of detail chain the model is requested with
+    /// @return cooked model, nullptr if it has to be re-cooked
+    std::shared_ptr<CookedModel> CookedModel::open(std::string_view cooked_file_path, uint64_t source_hash, VertexLayout layout,
+                                                   const std::vector<float>& lod_ratios) {
+        std::shared_ptr<MappedFile> file = MappedFile::open(cooked_file_path);
+        if (!file || file->getSize() < sizeof(CookedModelHeader))
+            return nullptr;
+
+        std::shared_ptr<CookedModel> cooked_model = std::make_shared<CookedModel>();
+        cooked_model->file_   = file;
+        cooked_model->header_ = cooked_model->at<CookedModelHeader>(0);
+        if (!cooked_model->validate(source_hash, layout, lod_ratios))
+            return nullptr;
+        return cooked_model;
+    }
+
+    bool CookedModel::validate(uint64_t source_hash, VertexLayout layout, const std::vector<float>& lod_ratios) const {
+        const uint64_t file_size = file_->getSize();
+        auto fits = [file_size](uint64_t offset, uint64_t count, uint64_t element_size) {
+            return offset % COOKED_MODEL_ALIGNMENT == 0 &&
+                   offset <= file_size && count <= (file_size - offset) / element_size;
+        };
+
+        if (std::memcmp(header_->magic_, COOKED_MODEL_MAGIC, sizeof(COOKED_MODEL_MAGIC)) != 0 ||
+            header_->version_     != COOKED_MODEL_VERSION    ||
+            header_->endian_tag_  != COOKED_MODEL_ENDIAN_TAG ||
+            header_->vertex_layout_ != static_cast<uint32_t>(layout) ||
+            header_->vertex_stride_ != getVertexStride(layout)       ||
+            header_->lod_ratios_hash_ != hashLodRatios(lod_ratios)  ||
+            header_->source_hash_ != source_hash)
+            return false;
+
+        if (!fits(header_->meshes_offset_, header_->mesh_count_, sizeof(CookedMesh)) ||
+            !fits(header_->texture_refs_offset_, header_->texture_ref_count_, sizeof(CookedTextureRef)) ||
+            !fits(header_->nodes_offset_, header_->node_count_, sizeof(CookedNode)) ||
+            !fits(header_->strings_offset_, header_->strings_size_, 1) ||
+            !fits(header_->bones_offset_, header_->bone_count_, sizeof(CookedBone)) ||
+            !fits(header_->clips_offset_, header_->clip_count_, sizeof(CookedClip)) ||
+            header_->bone_count_ > MAX_SKELETON_BONES)
+            return false;
+
+        const CookedMesh* meshes = at<CookedMesh>(header_->meshes_offset_);
+        for (uint32_t i = 0; i < header_->mesh_count_; i++) {
+            const CookedMesh& mesh = meshes[i];
+            if (!fits(mesh.vertex_offset_, mesh.vertex_count_, header_->vertex_stride_) ||
+                (mesh.skin_offset_ != 0 && !fits(mesh.skin_offset_, mesh.vertex_count_, sizeof(SkinVertex))) ||
+                mesh.index_type_ > static_cast<uint32_t>(IndexType::UInt32) ||
+                !fits(mesh.index_offset_, mesh.index_count_, getIndexSize(static_cast<IndexType>(mesh.index_type_))) ||
+                !fits(mesh.meshlet_offset_, mesh.meshlet_count_, sizeof(Meshlet)) ||
+                !fits(mesh.lod_offset_, mesh.lod_count_, sizeof(MeshLod)) ||
+                mesh.first_texture_ref_ > header_->texture_ref_count_ ||
+                mesh.texture_ref_count_ > header_->texture_ref_count_ - mesh.first_texture_ref_)
+                return false;
+        }
+
+        auto string_fits = [this](const CookedString& cooked_string) {
+            return cooked_string.offset_ <= header_->strings_size_ &&
+                   cooked_string.length_ <= header_->strings_size_ - cooked_string.offset_;
+        };
+        const CookedTextureRef* texture_refs = at<CookedTextureRef>(header_->texture_refs_offset_);
+        for (uint32_t i = 0; i < header_->texture_ref_count_; i++) {
+            if (!string_fits(texture_refs[i].type_) || !string_fits(texture_refs[i].path_))
+                return false;
+        }
+        const CookedNode* nodes = at<CookedNode>(header_->nodes_offset_);
+        for (uint32_t i = 0; i < header_->node_count_; i++) {
+            if (!string_fits(nodes[i].name_) || nodes[i].parent_ >= static_cast<int32_t>(i) ||
+                nodes[i].first_mesh_ > header_->mesh_count_ ||
+                nodes[i].mesh_count_ > header_->mesh_count_ - nodes[i].first_mesh_)
+                return false;
+        }
+        const CookedBone* bones = at<CookedBone>(header_->bones_offset_);
+        for (uint32_t i = 0; i < header_->bone_count_; i++) {
+            if (bones[i].node_ >= header_->node_count_)
+                return false;
+        }
+
+        const CookedClip* clips = at<CookedClip>(header_->clips_offset_);
+        for (uint32_t i = 0; i < header_->clip_count_; i++) {
+            const CookedClip& clip = clips[i];
+            if (!string_fits(clip.name_) ||
+                !fits(clip.channels_offset_, clip.channel_count_, sizeof(AnimationChannel)) ||
+                !fits(clip.keys_offset_, clip.key_count_, sizeof(AnimationKey)))
+                return false;
+            auto range_fits = [&clip](const AnimationTrack& track) {
+                return track.first_key_ <= clip.key_count_ && track.key_count_ <= clip.key_count_ - track.first_key_;
+            };
+            const AnimationChannel* channels = at<AnimationChannel>(clip.channels_offset_);
+            for (uint32_t c = 0; c < clip.channel_count_; c++) {
+                const AnimationChannel& channel = channels[c];
+                if (channel.node_ >= header_->node_count_ ||
+                    !range_fits(channel.position_) || !range_fits(channel.rotation_) || !range_fits(channel.scale_))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    std::string_view CookedModel::getString(const CookedString& cooked_string) const {
+        return std::string_view{at<char>(header_->strings_offset_ + cooked_string.offset_), cooked_string.length_};
+    }
+
+    CookedMeshView CookedModel::getMesh(size_t index) const {
+        const CookedMesh& mesh = at<CookedMesh>(header_->meshes_offset_)[index];
+
+        CookedMeshView view;
+        view.vertex_streams_.layout_       = static_cast<VertexLayout>(header_->vertex_layout_);
+        view.vertex_streams_.vertex_count_ = mesh.vertex_count_;
+        view.vertex_streams_.vertices_     = at<unsigned char>(mesh.vertex_offset_);
+        view.vertex_streams_.skin_         = mesh.skin_offset_ != 0 ? at<SkinVertex>(mesh.skin_offset_) : nullptr;
+        view.index_stream_.type_           = static_cast<IndexType>(mesh.index_type_);
+        view.index_stream_.index_count_    = mesh.index_count_;
+        view.index_stream_.indices_        = at<unsigned char>(mesh.index_offset_);
+        view.bounds_                       = mesh.bounds_;
+
+        // meshlets and levels are tiny and kept by the mesh, copy them out of the mapping
+        const Meshlet* meshlets = at<Meshlet>(mesh.meshlet_offset_);
+        view.meshlets_.assign(meshlets, meshlets + mesh.meshlet_count_);
+        for (const Meshlet& meshlet : view.meshlets_)
+            if (meshlet.index_offset_ > mesh.index_count_ || meshlet.index_count_ > mesh.index_count_ - meshlet.index_offset_) {
+                view.meshlets_.clear();
+                break;
+            }
+        const MeshLod* lods = at<MeshLod>(mesh.lod_offset_);
+        view.lods_.assign(lods, lods + mesh.lod_count_);
+        for (const MeshLod& lod : view.lods_)
+            if (lod.index_offset_ > mesh.index_count_ || lod.index_count_ > mesh.index_count_ - lod.index_offset_) {
+                view.lods_.clear();
+                break;
+            }
+
+        const CookedTextureRef* texture_refs = at<CookedTextureRef>(header_->texture_refs_offset_) + mesh.first_texture_ref_;
+        view.textures_.reserve(mesh.texture_ref_count_);
+        for (uint32_t i = 0; i < mesh.texture_ref_count_; i++)
+            view.textures_.push_back(TextureRef{std::string{getString(texture_refs[i].type_)},
+                                                std::string{getString(texture_refs[i].path_)}});
+        return view;
+    }
+
+    std::vector<ModelNode> CookedModel::getNodes() const {
+        const CookedNode* cooked_nodes = at<CookedNode>(header_->nodes_offset_);
+
+        std::vector<ModelNode> nodes(header_->node_count_);
+        for (uint32_t i = 0; i < header_->node_count_; i++) {
+            nodes[i].name_       = std::string{getString(cooked_nodes[i].name_)};
+            std::memcpy(&nodes[i].transform_[0][0], cooked_nodes[i].transform_, sizeof(cooked_nodes[i].transform_));
+            nodes[i].parent_     = cooked_nodes[i].parent_;
+            nodes[i].first_mesh_ = cooked_nodes[i].first_mesh_;
+            nodes[i].mesh_count_ = cooked_nodes[i].mesh_count_;
+        }
+        return nodes;
+    }
+
+    std::shared_ptr<Skeleton> CookedModel::getSkeleton() const {
+        const CookedBone* cooked_bones = at<CookedBone>(header_->bones_offset_);
+
+        std::vector<uint32_t>  bone_nodes(header_->bone_count_);
+        std::vector<glm::mat4> bone_offsets(header_->bone_count_);
+        for (uint32_t i = 0; i < header_->bone_count_; i++) {
+            bone_nodes[i] = cooked_bones[i].node_;
+            std::memcpy(&bone_offsets[i][0][0], cooked_bones[i].offset_, sizeof(cooked_bones[i].offset_));
+        }
+        return Skeleton::create(getNodes(), std::move(bone_nodes), std::move(bone_offsets));
+    }
+
+    std::vector<std::shared_ptr<AnimationClip>> CookedModel::getClips() const {
+        const CookedClip* cooked_clips = at<CookedClip>(header_->clips_offset_);
+        // key arrays are copied out, clips outlive the mapping
+        auto copy = [this](auto& keys, uint64_t offset, uint32_t count) {
+            using Key = typename std::decay_t<decltype(keys)>::value_type;
+            const Key* first = at<Key>(offset);
+            keys.assign(first, first + count);
+        };
+
+        std::vector<std::shared_ptr<AnimationClip>> clips;
+        clips.reserve(header_->clip_count_);
+        for (uint32_t i = 0; i < header_->clip_count_; i++) {
+            const CookedClip& cooked_clip = cooked_clips[i];
+            std::shared_ptr<AnimationClip> clip = std::make_shared<AnimationClip>();
+            clip->name_     = std::string{getString(cooked_clip.name_)};
+            clip->duration_ = cooked_clip.duration_;
+            copy(clip->channels_, cooked_clip.channels_offset_, cooked_clip.channel_count_);
+            copy(clip->keys_, cooked_clip.keys_offset_, cooked_clip.key_count_);
+            clips.push_back(std::move(clip));
+        }
+        return clips;
+    }
+
+    /// @brief cook already processed meshes and their hierarchy into a .hd2dmesh file
+    /// @param cooked_file_path output path, written through a temporary file so readers never see half a file
+    /// @param source_hash content hash of the source model file
+    /// @param layout vertex layout the meshes were packed with
+    /// @param lod_ratios level of detail chain the meshes were simplified with
+    /// @param skeleton bones the skin streams refer to, nullptr for static models
+    /// @param clips animations over nodes
+    /// @return true on success
+    bool CookedModel::write(std::string_view cooked_file_path, uint64_t source_hash, VertexLayout layout,
+                            const std::vector<float>& lod_ratios, const std::vector<MeshData>& meshes, 
+                            const std::vector<ModelNode>& nodes, const Skeleton* skeleton,
+                            const std::vector<std::shared_ptr<AnimationClip>>& clips) {
+        CookedWriter writer;
+        StringTable  strings;
+
+        uint32_t texture_ref_count = 0;
+        for (const MeshData& mesh : meshes)
+            texture_ref_count += static_cast<uint32_t>(mesh.textures_.size());
+
+        const uint64_t header_offset       = writer.reserve(sizeof(CookedModelHeader));
+        const uint64_t meshes_offset       = writer.reserve(meshes.size() * sizeof(CookedMesh));
+        const uint64_t texture_refs_offset = writer.reserve(texture_ref_count * sizeof(CookedTextureRef));
+        const uint64_t nodes_offset        = writer.reserve(nodes.size() * sizeof(CookedNode));
+        const size_t   bone_count          = skeleton != nullptr ? skeleton->getBoneCount() : 0;
+        const uint64_t bones_offset        = writer.reserve(bone_count * sizeof(CookedBone));
+        const uint64_t clips_offset        = writer.reserve(clips.size() * sizeof(CookedClip));
+
+        uint32_t texture_ref_index = 0;
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const MeshData& mesh = meshes[i];
+            CookedMesh cooked_mesh{};
+            cooked_mesh.vertex_count_      = static_cast<uint32_t>(mesh.vertices_.size());
+            cooked_mesh.index_count_       = static_cast<uint32_t>(mesh.indices_.size());
+            cooked_mesh.first_texture_ref_ = texture_ref_index;
+            cooked_mesh.texture_ref_count_ = static_cast<uint32_t>(mesh.textures_.size());
+            cooked_mesh.index_type_        = static_cast<uint32_t>(mesh.index_type_);
+            cooked_mesh.meshlet_count_     = static_cast<uint32_t>(mesh.meshlets_.size());
+            cooked_mesh.lod_count_         = static_cast<uint32_t>(mesh.lods_.size());
+            cooked_mesh.bounds_            = mesh.bounds_;
+            for (const TextureRef& texture_ref : mesh.textures_) {
+                CookedTextureRef cooked_ref{strings.add(texture_ref.type_), strings.add(texture_ref.path_)};
+                *writer.at<CookedTextureRef>(texture_refs_offset + texture_ref_index * sizeof(CookedTextureRef)) = cooked_ref;
+                texture_ref_index++;
+            }
+            *writer.at<CookedMesh>(meshes_offset + i * sizeof(CookedMesh)) = cooked_mesh;
+        }
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            CookedNode cooked_node{};
+            std::memcpy(cooked_node.transform_, &nodes[i].transform_[0][0], sizeof(cooked_node.transform_));
+            cooked_node.name_       = strings.add(nodes[i].name_);
+            cooked_node.parent_     = nodes[i].parent_;
+            cooked_node.first_mesh_ = nodes[i].first_mesh_;
+            cooked_node.mesh_count_ = nodes[i].mesh_count_;
+            *writer.at<CookedNode>(nodes_offset + i * sizeof(CookedNode)) = cooked_node;
+        }
+
+        for (size_t i = 0; i < bone_count; i++) {
+            CookedBone cooked_bone{};
+            std::memcpy(cooked_bone.offset_, &skeleton->bone_offsets_[i][0][0], sizeof(cooked_bone.offset_));
+            cooked_bone.node_ = skeleton->bone_nodes_[i];
+            *writer.at<CookedBone>(bones_offset + i * sizeof(CookedBone)) = cooked_bone;
+        }
+        for (size_t i = 0; i < clips.size(); i++) {
+            CookedClip cooked_clip{};
+            cooked_clip.name_               = strings.add(clips[i]->name_);
+            cooked_clip.duration_           = clips[i]->duration_;
+            cooked_clip.channel_count_      = static_cast<uint32_t>(clips[i]->channels_.size());
+            cooked_clip.key_count_          = static_cast<uint32_t>(clips[i]->keys_.size());
+            *writer.at<CookedClip>(clips_offset + i * sizeof(CookedClip)) = cooked_clip;
+        }
+
+        const uint64_t strings_offset = writer.append(strings.getChars().data(), strings.getChars().size());
+
+        // bulk streams go last so the small tables above stay together at the front of the file
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const MeshData& mesh = meshes[i];
+            VertexStreamView vertex_streams = mesh.getVertexStreams();
+            uint64_t vertex_offset = writer.append(vertex_streams.vertices_, vertex_streams.vertex_count_ * getVertexStride(layout));
+            uint64_t skin_offset   = vertex_streams.skin_ != nullptr ? 
+                                     writer.append(vertex_streams.skin_, vertex_streams.vertex_count_ * sizeof(SkinVertex)) : 0;
+            IndexStreamView  index_stream   = mesh.getIndexStream();
+            uint64_t index_offset  = writer.append(index_stream.indices_, index_stream.index_count_ * getIndexSize(index_stream.type_));
+            uint64_t meshlet_offset = writer.append(mesh.meshlets_.data(), mesh.meshlets_.size() * sizeof(Meshlet));
+            uint64_t lod_offset     = writer.append(mesh.lods_.data(), mesh.lods_.size() * sizeof(MeshLod));
+            CookedMesh* cooked_mesh = writer.at<CookedMesh>(meshes_offset + i * sizeof(CookedMesh));
+            cooked_mesh->vertex_offset_  = vertex_offset;
+            cooked_mesh->skin_offset_    = skin_offset;
+            cooked_mesh->index_offset_   = index_offset;
+            cooked_mesh->meshlet_offset_ = meshlet_offset;
+            cooked_mesh->lod_offset_     = lod_offset;
+        }
+        for (size_t i = 0; i < clips.size(); i++) {
+            const AnimationClip& clip = *clips[i];
+            auto append = [&writer](const auto& keys) {
+                return writer.append(keys.data(), keys.size() * sizeof(keys[0]));
+            };
+            const uint64_t channels_offset = append(clip.channels_);
+            const uint64_t keys_offset     = append(clip.keys_);
+            CookedClip* cooked_clip = writer.at<CookedClip>(clips_offset + i * sizeof(CookedClip));
+            cooked_clip->channels_offset_ = channels_offset;
+            cooked_clip->keys_offset_     = keys_offset;
+        }
+
+        CookedModelHeader header{};
+        std::memcpy(header.magic_, COOKED_MODEL_MAGIC, sizeof(COOKED_MODEL_MAGIC));
+        header.version_             = COOKED_MODEL_VERSION;
+        header.endian_tag_          = COOKED_MODEL_ENDIAN_TAG;
+        header.source_hash_         = source_hash;
+        header.vertex_layout_       = static_cast<uint32_t>(layout);
+        header.vertex_stride_       = static_cast<uint32_t>(getVertexStride(layout));
+        header.mesh_count_          = static_cast<uint32_t>(meshes.size());
+        header.texture_ref_count_   = texture_ref_count;
+        header.node_count_          = static_cast<uint32_t>(nodes.size());
+        header.lod_ratios_hash_     = hashLodRatios(lod_ratios);
+        header.meshes_offset_       = meshes_offset;
+        header.texture_refs_offset_ = texture_refs_offset;
+        header.nodes_offset_        = nodes_offset;
+        header.strings_offset_      = strings_offset;
+        header.strings_size_        = strings.getChars().size();
+        header.bone_count_          = static_cast<uint32_t>(bone_count);
+        header.clip_count_          = static_cast<uint32_t>(clips.size());
+        header.bones_offset_        = bones_offset;
+        header.clips_offset_        = clips_offset;
+        *writer.at<CookedModelHeader>(header_offset) = header;
+
+        std::string temp_path = std::string{cooked_file_path} + ".tmp";
+        {
+            std::ofstream output_file_stream(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            output_file_stream.write(reinterpret_cast<const char*>(writer.getBytes().data()), writer.getBytes().size());
+            if (!output_file_stream.good()) {
+                std::cout << "Error::CookedModel::File_Not_Successfully_Written " << temp_path << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, std::string{cooked_file_path}, error);
+        if (error) {
+            std::cout << "Error::CookedModel::File_Not_Successfully_Written " << cooked_file_path << std::endl;
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,38 @@
+#include "editor/include/cpt_format.h"
+
+namespace Hd2d {
+    bool isCptHeadValid(const CptFileHead& head) noexcept {
+        return CptFileHead::isCptFile(head.type_) &&
+               head.version_    == CPT_VERSION    &&
+               head.endian_tag_ == CPT_ENDIAN_TAG &&
+               head.format_ >= static_cast<uint8_t>(CptFormat::BC1) &&
+               head.format_ <= static_cast<uint8_t>(CptFormat::BC7) &&
+               head.width_ > 0 && head.height_ > 0 && head.mip_count_ > 0;
+    }
+
+    /// @brief check a mapped .cpt before its blocks are handed to GL
+    /// @param bytes whole file
+    /// @param size file size
+    /// @return head at bytes, nullptr if the file can't be uploaded as is
+    const CptFileHead* validateCptFile(const unsigned char* bytes, size_t size) noexcept {
+        if (bytes == nullptr || size < sizeof(CptFileHead))
+            return nullptr;
+        const CptFileHead* head = reinterpret_cast<const CptFileHead*>(bytes);
+        if (!isCptHeadValid(*head) || head->mip_count_ > (size - sizeof(CptFileHead)) / sizeof(CptMipLevel))
+            return nullptr;
+
+        const CptFormat    format = static_cast<CptFormat>(head->format_);
+        const CptMipLevel* levels = getCptLevels(head);
+        for (uint16_t i = 0; i < head->mip_count_; i++) {
+            const CptMipLevel& level = levels[i];
+            // each level halves the one above, down to 1
+            const uint32_t width  = i == 0 ? head->width_ : (levels[i - 1].width_ > 1 ? levels[i - 1].width_ / 2 : 1);
+            const uint32_t height = i == 0 ? head->height_ : (levels[i - 1].height_ > 1 ? levels[i - 1].height_ / 2 : 1);
+            if (level.width_ != width || level.height_ != height ||
+                level.size_ != getCptLevelSize(format, width, height) ||
+                level.offset_ > size || level.size_ > size - level.offset_)
+                return nullptr;
+        }
+        return head;
+    }
+}
@@ -0,0 +1,82 @@
+#include "editor/include/culling.h"
+
+namespace Hd2d {
+    /// @brief Gribb/Hartmann plane extraction
+    /// @param matrix clip transform, its rows combine into the six clip planes
+    /// @return normalized planes in the space matrix transforms from
+    Frustum Frustum::fromMatrix(const glm::mat4& matrix) noexcept {
+        // glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        auto row = [&matrix](int i) { return glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]); };
+
+        Frustum frustum;
+        frustum.planes_[0] = row(3) + row(0); // left
+        frustum.planes_[1] = row(3) - row(0); // right
+        frustum.planes_[2] = row(3) + row(1); // bottom
+        frustum.planes_[3] = row(3) - row(1); // top
+        frustum.planes_[4] = row(3) + row(2); // near
+        frustum.planes_[5] = row(3) - row(2); // far
+        for (glm::vec4& plane : frustum.planes_)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    bool Frustum::isSphereVisible(const glm::vec3& center, float radius) const noexcept {
+        for (const glm::vec4& plane : planes_)
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return false;
+        return true;
+    }
+
+    bool Frustum::isBoxVisible(const Aabb& box) const noexcept {
+        if (box.isEmpty())
+            return false;
+        const glm::vec3 center = box.getCenter();
+        const glm::vec3 extent = box.getExtent();
+        for (const glm::vec4& plane : planes_) {
+            // distance of the corner farthest along the plane normal
+            const glm::vec3 normal(plane);
+            if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extent) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    /// @brief build the culling state of one draw
+    /// @param model model matrix of the mesh
+    /// @param view camera view matrix
+    /// @param projection camera projection matrix
+    /// @return frustum and camera position in model space, cone tests assume model has no non-uniform scale
+    CullView CullView::fromMatrices(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) noexcept {
+        CullView cull_view;
+        cull_view.frustum_         = Frustum::fromMatrix(projection * view * model);
+        cull_view.camera_position_ = glm::vec3(glm::inverse(view * model)[3]);
+        return cull_view;
+    }
+
+    /// @brief move the culling state into a child space
+    /// @param transform child to current space, e.g. SceneGraph::getWorldTransform with a world space view
+    /// @param normal_matrix inverse transpose of transform's upper 3x3, see SceneGraph::getNormalMatrix
+    /// @return frustum and camera position in the child space
+    CullView CullView::toLocalSpace(const glm::mat4& transform, const glm::mat3& normal_matrix) const noexcept {
+        CullView cull_view = *this;
+        // planes are covectors: dot(plane, transform * p) = dot(transpose(transform) * plane, p)
+        const glm::mat4 plane_transform = glm::transpose(transform);
+        for (glm::vec4& plane : cull_view.frustum_.planes_) {
+            plane  = plane_transform * plane;
+            plane /= glm::length(glm::vec3(plane));
+        }
+        // transpose of the normal matrix is the inverse of the upper 3x3
+        cull_view.camera_position_ = glm::transpose(normal_matrix) * (camera_position_ - glm::vec3(transform[3]));
+        return cull_view;
+    }
+
+    bool CullView::isClusterVisible(const glm::vec3& center, float radius, const glm::vec3& cone_axis, float cone_cutoff) const noexcept {
+        if (!frustum_.isSphereVisible(center, radius))
+            return false;
+        if (!backface_culling_)
+            return true;
+        // the cone test of meshoptimizer, widened by the radius so it holds for any point of the cluster
+        glm::vec3 to_center = center - camera_position_;
+        return glm::dot(to_center, cone_axis) < cone_cutoff * glm::length(to_center) + radius;
+    }
+}
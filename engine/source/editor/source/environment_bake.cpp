@@ -0,0 +1,405 @@
+#include "editor/include/environment_bake.h"
+#include "editor/include/hash.h"
+#include "editor/include/image_kernels.h"
+#include "editor/include/thread_pool.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Hd2d {
+    namespace {
+        constexpr float PI = 3.14159265358979f;
+
+        // one level of a float cube, the six faces one after another, rows top to bottom like the images
+        struct CubeLevel {
+            uint32_t               size_ = 0;
+            std::vector<glm::vec3> texels_;
+
+            const glm::vec3& at(uint32_t face, uint32_t x, uint32_t y) const { return texels_[(size_t(face) * size_ + y) * size_ + x]; }
+        };
+
+        // direction through face coordinates s, t in [-1, 1], the GL cube map convention
+        glm::vec3 getFaceDirection(uint32_t face, float s, float t) {
+            switch (face) {
+                case 0:  return glm::normalize(glm::vec3( 1.0f,   -t,   -s));
+                case 1:  return glm::normalize(glm::vec3(-1.0f,   -t,    s));
+                case 2:  return glm::normalize(glm::vec3(    s, 1.0f,    t));
+                case 3:  return glm::normalize(glm::vec3(    s,-1.0f,   -t));
+                case 4:  return glm::normalize(glm::vec3(    s,   -t, 1.0f));
+                default: return glm::normalize(glm::vec3(   -s,   -t,-1.0f));
+            }
+        }
+
+        // the face a direction hits and where, s and t in [-1, 1]
+        uint32_t getFaceCoordinates(const glm::vec3& direction, float& s, float& t) {
+            const glm::vec3 magnitude = glm::abs(direction);
+            uint32_t face;
+            float    major;
+            if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z) {
+                face  = direction.x > 0.0f ? 0 : 1;
+                major = magnitude.x;
+                s     = direction.x > 0.0f ? -direction.z : direction.z;
+                t     = -direction.y;
+            } else if (magnitude.y >= magnitude.z) {
+                face  = direction.y > 0.0f ? 2 : 3;
+                major = magnitude.y;
+                s     = direction.x;
+                t     = direction.y > 0.0f ? direction.z : -direction.z;
+            } else {
+                face  = direction.z > 0.0f ? 4 : 5;
+                major = magnitude.z;
+                s     = direction.z > 0.0f ? direction.x : -direction.x;
+                t     = -direction.y;
+            }
+            s /= major;
+            t /= major;
+            return face;
+        }
+
+        // bilinear inside the face, clamped at its edges like GL_CLAMP_TO_EDGE
+        glm::vec3 sampleFace(const CubeLevel& level, uint32_t face, float s, float t) {
+            const float    max_texel = float(level.size_ - 1);
+            const float    x  = std::clamp((s + 1.0f) * 0.5f * level.size_ - 0.5f, 0.0f, max_texel);
+            const float    y  = std::clamp((t + 1.0f) * 0.5f * level.size_ - 0.5f, 0.0f, max_texel);
+            const uint32_t x0 = uint32_t(x);
+            const uint32_t y0 = uint32_t(y);
+            const uint32_t x1 = std::min(x0 + 1, level.size_ - 1);
+            const uint32_t y1 = std::min(y0 + 1, level.size_ - 1);
+            const float    fx = x - float(x0);
+            const float    fy = y - float(y0);
+            return glm::mix(glm::mix(level.at(face, x0, y0), level.at(face, x1, y0), fx),
+                            glm::mix(level.at(face, x0, y1), level.at(face, x1, y1), fx), fy);
+        }
+
+        // trilinear between the two chain levels around lod
+        glm::vec3 sampleCube(const std::vector<CubeLevel>& chain, const glm::vec3& direction, float lod) {
+            float s, t;
+            const uint32_t face = getFaceCoordinates(direction, s, t);
+            lod = std::clamp(lod, 0.0f, float(chain.size() - 1));
+            const uint32_t level = uint32_t(lod);
+            const float    blend = lod - float(level);
+            const glm::vec3 fine = sampleFace(chain[level], face, s, t);
+            if (blend <= 0.0f || level + 1 >= chain.size())
+                return fine;
+            return glm::mix(fine, sampleFace(chain[level + 1], face, s, t), blend);
+        }
+
+        float getAreaElement(float x, float y) {
+            return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0f));
+        }
+
+        // solid angle a texel of a size x size face covers on the unit sphere
+        float getTexelSolidAngle(uint32_t x, uint32_t y, uint32_t size) {
+            const float inverse_size = 2.0f / float(size);
+            const float x0 = float(x) * inverse_size - 1.0f;
+            const float y0 = float(y) * inverse_size - 1.0f;
+            const float x1 = x0 + inverse_size;
+            const float y1 = y0 + inverse_size;
+            return getAreaElement(x0, y0) - getAreaElement(x0, y1) - getAreaElement(x1, y0) + getAreaElement(x1, y1);
+        }
+
+        // 8 bit face box filtered down to at most face_size a side, as float RGB
+        void loadFace(const EnvironmentFace& face, uint32_t face_size, glm::vec3* texels) {
+            const uint32_t channels = uint32_t(face.channels_);
+            uint32_t size = uint32_t(face.width_);
+            std::vector<uint8_t> pixels(face.pixels_, face.pixels_ + size_t(size) * size * channels);
+            std::vector<uint8_t> half;
+            while (size > face_size) {
+                half.resize(size_t(size / 2) * (size / 2) * channels);
+                // stored values are what the skybox shows, so no sRGB decode here either
+                downsampleBox(pixels.data(), size, size, channels, false, half.data());
+                pixels.swap(half);
+                size /= 2;
+            }
+            for (size_t i = 0; i < size_t(size) * size; i++)
+                texels[i] = glm::vec3(pixels[i * channels], pixels[i * channels + 1], pixels[i * channels + 2]) / 255.0f;
+        }
+
+        CubeLevel downsampleLevel(const CubeLevel& source) {
+            CubeLevel target;
+            target.size_ = std::max(1u, source.size_ / 2);
+            target.texels_.resize(size_t(6) * target.size_ * target.size_);
+            const uint32_t step = source.size_ > 1 ? 1 : 0;
+            for (uint32_t face = 0; face < 6; face++)
+                for (uint32_t y = 0; y < target.size_; y++)
+                    for (uint32_t x = 0; x < target.size_; x++)
+                        target.texels_[(size_t(face) * target.size_ + y) * target.size_ + x] =
+                            (source.at(face, x * 2, y * 2) + source.at(face, x * 2 + step, y * 2) +
+                             source.at(face, x * 2, y * 2 + step) + source.at(face, x * 2 + step, y * 2 + step)) * 0.25f;
+            return target;
+        }
+
+        // radiance projected on the 9 real SH basis functions, weighted by texel solid angle. rows run in parallel
+        // into their own sums, which are added up in order so the result doesn't depend on the thread count
+        void projectSH(const CubeLevel& level, glm::vec3 (&sh)[ENVIRONMENT_SH_COEFFICIENTS]) {
+            const size_t row_count = size_t(6) * level.size_;
+            std::vector<glm::vec3> row_sh(row_count * ENVIRONMENT_SH_COEFFICIENTS, glm::vec3(0.0f));
+            std::vector<float>     row_weight(row_count, 0.0f);
+            ThreadPool::getInstance().parallelFor(row_count, [&](size_t row) {
+                const uint32_t face = uint32_t(row / level.size_);
+                const uint32_t y    = uint32_t(row % level.size_);
+                glm::vec3* sums = &row_sh[row * ENVIRONMENT_SH_COEFFICIENTS];
+                for (uint32_t x = 0; x < level.size_; x++) {
+                    const float     s = (float(x) + 0.5f) * 2.0f / float(level.size_) - 1.0f;
+                    const float     t = (float(y) + 0.5f) * 2.0f / float(level.size_) - 1.0f;
+                    const glm::vec3 n = getFaceDirection(face, s, t);
+                    const float     solid_angle = getTexelSolidAngle(x, y, level.size_);
+                    const glm::vec3 radiance    = level.at(face, x, y) * solid_angle;
+                    // the basis polynomials without their constants, those are applied once at the end
+                    sums[0] += radiance;
+                    sums[1] += radiance * n.y;
+                    sums[2] += radiance * n.z;
+                    sums[3] += radiance * n.x;
+                    sums[4] += radiance * (n.x * n.y);
+                    sums[5] += radiance * (n.y * n.z);
+                    sums[6] += radiance * (3.0f * n.z * n.z - 1.0f);
+                    sums[7] += radiance * (n.x * n.z);
+                    sums[8] += radiance * (n.x * n.x - n.y * n.y);
+                    row_weight[row] += solid_angle;
+                }
+            });
+
+            float total_weight = 0.0f;
+            for (size_t i = 0; i < ENVIRONMENT_SH_COEFFICIENTS; i++)
+                sh[i] = glm::vec3(0.0f);
+            for (size_t row = 0; row < row_count; row++) {
+                for (size_t i = 0; i < ENVIRONMENT_SH_COEFFICIENTS; i++)
+                    sh[i] += row_sh[row * ENVIRONMENT_SH_COEFFICIENTS + i];
+                total_weight += row_weight[row];
+            }
+
+            // the texel solid angles sum to 4 pi up to rounding, renormalize so a constant sky stays constant
+            const float normalize = 4.0f * PI / total_weight;
+            // the basis constant squared (projection and evaluation) times the cosine lobe convolution of the band
+            // (pi, 2 pi / 3, pi / 4), divided by pi for the diffuse radiance of a white surface
+            constexpr float BAND_SCALE[ENVIRONMENT_SH_COEFFICIENTS] = {
+                0.282095f * 0.282095f,
+                0.488603f * 0.488603f * 2.0f / 3.0f, 0.488603f * 0.488603f * 2.0f / 3.0f, 0.488603f * 0.488603f * 2.0f / 3.0f,
+                1.092548f * 1.092548f / 4.0f, 1.092548f * 1.092548f / 4.0f, 0.315392f * 0.315392f / 4.0f,
+                1.092548f * 1.092548f / 4.0f, 0.546274f * 0.546274f / 4.0f
+            };
+            for (size_t i = 0; i < ENVIRONMENT_SH_COEFFICIENTS; i++)
+                sh[i] *= normalize * BAND_SCALE[i];
+        }
+
+        // one GGX importance sample around N = V = (0, 0, 1): the light direction, its cosine weight and the
+        // source lod whose texels cover about the solid angle the sample stands for
+        struct SpecularSample {
+            glm::vec3 direction_;
+            float     weight_;
+            float     lod_;
+        };
+
+        float radicalInverse(uint32_t bits) {
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return float(bits) * 2.3283064365386963e-10f;
+        }
+
+        // the samples only depend on roughness, so they are made once per level and rotated to each texel
+        std::vector<SpecularSample> makeSpecularSamples(float roughness, uint32_t sample_count, uint32_t source_size) {
+            const float alpha         = roughness * roughness;
+            const float alpha_squared = alpha * alpha;
+            const float texel_solid_angle = 4.0f * PI / (6.0f * float(source_size) * float(source_size));
+            std::vector<SpecularSample> samples;
+            samples.reserve(sample_count);
+            for (uint32_t i = 0; i < sample_count; i++) {
+                // Hammersley point, mapped to a half vector distributed like D(h) (n.h)
+                const float u         = float(i) / float(sample_count);
+                const float v         = radicalInverse(i);
+                const float phi       = 2.0f * PI * u;
+                const float cos_theta = std::sqrt((1.0f - v) / (1.0f + (alpha_squared - 1.0f) * v));
+                const float sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+                const glm::vec3 half_vector(std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, cos_theta);
+                const glm::vec3 light = 2.0f * cos_theta * half_vector - glm::vec3(0.0f, 0.0f, 1.0f);
+                if (light.z <= 0.0f)
+                    continue;
+                // with n = v the pdf of the light direction is D / 4
+                const float denominator = cos_theta * cos_theta * (alpha_squared - 1.0f) + 1.0f;
+                const float pdf         = alpha_squared / (PI * denominator * denominator) / 4.0f;
+                const float sample_solid_angle = 1.0f / (float(sample_count) * pdf + 1e-6f);
+                const float lod = 0.5f * std::log2(sample_solid_angle / texel_solid_angle);
+                samples.push_back({light, light.z, std::max(lod, 0.0f)});
+            }
+            return samples;
+        }
+
+        // the split sum prefilter: every texel of the level convolved with the GGX lobe of its roughness
+        void prefilterLevel(const std::vector<CubeLevel>& chain, const std::vector<SpecularSample>& samples, CubeLevel& target) {
+            ThreadPool::getInstance().parallelFor(size_t(6) * target.size_, [&](size_t row) {
+                const uint32_t face = uint32_t(row / target.size_);
+                const uint32_t y    = uint32_t(row % target.size_);
+                for (uint32_t x = 0; x < target.size_; x++) {
+                    const float     s = (float(x) + 0.5f) * 2.0f / float(target.size_) - 1.0f;
+                    const float     t = (float(y) + 0.5f) * 2.0f / float(target.size_) - 1.0f;
+                    const glm::vec3 n = getFaceDirection(face, s, t);
+                    const glm::vec3 up        = std::abs(n.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                    const glm::vec3 tangent   = glm::normalize(glm::cross(up, n));
+                    const glm::vec3 bitangent = glm::cross(n, tangent);
+                    glm::vec3 color(0.0f);
+                    float     weight = 0.0f;
+                    for (const SpecularSample& sample : samples) {
+                        const glm::vec3 light = tangent * sample.direction_.x + bitangent * sample.direction_.y + n * sample.direction_.z;
+                        color  += sampleCube(chain, light, sample.lod_) * sample.weight_;
+                        weight += sample.weight_;
+                    }
+                    target.texels_[(size_t(face) * target.size_ + y) * target.size_ + x] = weight > 0.0f ? color / weight : chain[0].at(face, x, y);
+                }
+            });
+        }
+    }
+
+    /// @brief project the skybox to SH irradiance and prefilter its specular levels
+    /// @param faces +x, -x, +y, -y, +z, -z, decoded
+    /// @param settings level 0 size, level count and GGX samples
+    /// @return bake, invalid if the faces can't be used
+    BakedEnvironment bakeEnvironment(const std::array<EnvironmentFace, 6>& faces, const EnvironmentBakeSettings& settings) {
+        BakedEnvironment environment;
+        const int source_size = faces[0].width_;
+        for (const EnvironmentFace& face : faces) {
+            if (face.pixels_ == nullptr || face.width_ != source_size || face.height_ != source_size || face.channels_ < 3) {
+                std::cout << "Error::EnvironmentBake::Faces_Not_Supported" << std::endl;
+                return environment;
+            }
+        }
+        if (source_size <= 0 || settings.face_size_ == 0)
+            return environment;
+
+        // halve the source until it fits, so every level below is an exact halving like the GL levels
+        uint32_t face_size = uint32_t(source_size);
+        while (face_size > settings.face_size_)
+            face_size /= 2;
+        uint32_t max_mip_count = 1;
+        while ((face_size >> max_mip_count) > 0)
+            max_mip_count++;
+        const uint32_t mip_count = std::clamp(settings.mip_count_, 1u, max_mip_count);
+
+        // source chain down to 1x1, the coarse levels are what wide lobes sample
+        std::vector<CubeLevel> chain(1);
+        chain[0].size_ = face_size;
+        chain[0].texels_.resize(size_t(6) * face_size * face_size);
+        ThreadPool::getInstance().parallelFor(6, [&](size_t face) {
+            loadFace(faces[face], face_size, &chain[0].texels_[face * face_size * face_size]);
+        });
+        while (chain.back().size_ > 1)
+            chain.push_back(downsampleLevel(chain.back()));
+
+        // 64 texels a side resolve nine coefficients plenty, finer levels only cost time
+        size_t sh_level = 0;
+        while (chain[sh_level].size_ > 64)
+            sh_level++;
+        glm::vec3 sh[ENVIRONMENT_SH_COEFFICIENTS];
+        projectSH(chain[sh_level], sh);
+
+        EnvironmentFileHeader& header = environment.header_;
+        std::memcpy(header.magic_, ENVIRONMENT_MAGIC, sizeof(ENVIRONMENT_MAGIC));
+        header.version_      = ENVIRONMENT_FILE_VERSION;
+        header.endian_tag_   = ENVIRONMENT_ENDIAN_TAG;
+        header.face_size_    = face_size;
+        header.mip_count_    = mip_count;
+        header.sample_count_ = settings.sample_count_;
+        header.reserved_     = 0;
+        for (size_t i = 0; i < ENVIRONMENT_SH_COEFFICIENTS; i++) {
+            header.sh_[i][0] = sh[i].r;
+            header.sh_[i][1] = sh[i].g;
+            header.sh_[i][2] = sh[i].b;
+            header.sh_[i][3] = 0.0f;
+        }
+
+        environment.data_.reserve(getEnvironmentDataSize(face_size, mip_count) / sizeof(uint16_t));
+        for (uint32_t level = 0; level < mip_count; level++) {
+            // a mirror reflects the sky as is
+            CubeLevel prefiltered = chain[level];
+            if (level > 0) {
+                const float roughness = float(level) / float(mip_count - 1);
+                prefilterLevel(chain, makeSpecularSamples(roughness, std::max(1u, settings.sample_count_), face_size), prefiltered);
+            }
+            for (const glm::vec3& texel : prefiltered.texels_) {
+                environment.data_.push_back(glm::packHalf1x16(texel.r));
+                environment.data_.push_back(glm::packHalf1x16(texel.g));
+                environment.data_.push_back(glm::packHalf1x16(texel.b));
+            }
+        }
+        return environment;
+    }
+
+    /// @brief write a bake, through a temporary file so a crash never leaves half a file behind
+    /// @param environment_path output path
+    /// @return true on success
+    bool writeEnvironmentFile(std::string_view environment_path, const BakedEnvironment& environment) {
+        if (!environment.isValid())
+            return false;
+
+        std::string temp_path = std::string{environment_path} + ".tmp";
+        {
+            std::ofstream output_file_stream(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            output_file_stream.write(reinterpret_cast<const char*>(&environment.header_), sizeof(EnvironmentFileHeader));
+            output_file_stream.write(reinterpret_cast<const char*>(environment.data_.data()), environment.data_.size() * sizeof(uint16_t));
+            if (!output_file_stream.good()) {
+                std::cout << "Error::EnvironmentBake::File_Not_Successfully_Written " << temp_path << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, std::string{environment_path}, error);
+        if (error) {
+            std::cout << "Error::EnvironmentBake::File_Not_Successfully_Written " << environment_path << std::endl;
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t hashEnvironmentBakeSettings(const EnvironmentBakeSettings& settings) noexcept {
+        const uint32_t fields[] = {settings.face_size_, settings.mip_count_, settings.sample_count_};
+        return fnv1a64(fields, sizeof(fields));
+    }
+
+    size_t getEnvironmentDataSize(uint32_t face_size, uint32_t mip_count) noexcept {
+        size_t size = 0;
+        for (uint32_t level = 0; level < mip_count; level++) {
+            const size_t level_size = std::max(1u, face_size >> level);
+            size += 6 * level_size * level_size * 3 * sizeof(uint16_t);
+        }
+        return size;
+    }
+
+    /// @brief check a mapped bake before its texels are uploaded
+    /// @param bytes whole file
+    /// @param size file size
+    /// @return header at bytes, nullptr if the file can't be used as is
+    const EnvironmentFileHeader* validateEnvironmentFile(const unsigned char* bytes, size_t size) noexcept {
+        if (bytes == nullptr || size < sizeof(EnvironmentFileHeader))
+            return nullptr;
+        const EnvironmentFileHeader* header = reinterpret_cast<const EnvironmentFileHeader*>(bytes);
+        if (std::memcmp(header->magic_, ENVIRONMENT_MAGIC, sizeof(ENVIRONMENT_MAGIC)) != 0 ||
+            header->version_    != ENVIRONMENT_FILE_VERSION ||
+            header->endian_tag_ != ENVIRONMENT_ENDIAN_TAG   ||
+            header->face_size_ == 0 || header->mip_count_ == 0 || header->mip_count_ > 32 ||
+            (header->face_size_ >> (header->mip_count_ - 1)) == 0)
+            return nullptr;
+        if (sizeof(EnvironmentFileHeader) + getEnvironmentDataSize(header->face_size_, header->mip_count_) > size)
+            return nullptr;
+        return header;
+    }
+
+    std::string getEnvironmentPath(std::string_view face_path) {
+        const std::filesystem::path directory = std::filesystem::path{face_path}.parent_path();
+        // a bare file name still has a directory to be named after
+        std::filesystem::path name = std::filesystem::absolute(face_path).parent_path().filename();
+        if (name.empty())
+            name = "environment";
+        return (directory / name).generic_string() + std::string{ENVIRONMENT_EXTENSION};
+    }
+}
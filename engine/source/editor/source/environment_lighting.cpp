@@ -0,0 +1,107 @@
+#include "editor/include/environment_lighting.h"
+#include "editor/include/asset_database.h"
+#include "editor/include/mapped_file.h"
+#include "editor/include/texture2d.h"
+#include "editor/include/thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <iostream>
+
+namespace Hd2d {
+    EnvironmentLighting::~EnvironmentLighting() {
+        deleteBuffer();
+    }
+
+    /// @brief load the lighting of a skybox, from its cached bake when that is still up to date
+    /// @param faces +x, -x, +y, -y, +z, -z face file paths
+    /// @param settings bake settings, a cache baked with others is baked again
+    /// @return lighting, nullptr if the faces can't be decoded or baked
+    std::shared_ptr<EnvironmentLighting> EnvironmentLighting::load(const std::vector<std::string>& faces,
+                                                                   const EnvironmentBakeSettings& settings) {
+        if (faces.size() != 6)
+            return nullptr;
+        AssetDatabase& asset_database = AssetDatabase::getInstance();
+        const std::string environment_path = getEnvironmentPath(faces[0]);
+        const uint64_t    settings_hash    = hashEnvironmentBakeSettings(settings);
+
+        std::shared_ptr<EnvironmentLighting> lighting = std::make_shared<EnvironmentLighting>();
+        std::shared_ptr<MappedFile> file;
+        if (asset_database.isUpToDate(environment_path, faces, ENVIRONMENT_BAKE_VERSION, settings_hash))
+            file = MappedFile::open(environment_path);
+        const EnvironmentFileHeader* header = file ? validateEnvironmentFile(file->getData(), file->getSize()) : nullptr;
+        if (header != nullptr) {
+            lighting->upload(*header, reinterpret_cast<const uint16_t*>(header + 1));
+            return lighting;
+        }
+
+        ThreadPool& pool = ThreadPool::getInstance();
+        std::vector<std::future<Image>> decodes = Texture2D::decodeImages(faces);
+        std::array<Image, 6> images;
+        std::array<EnvironmentFace, 6> environment_faces;
+        for (size_t i = 0; i < images.size(); i++) {
+            pool.wait(decodes[i]);
+            images[i] = decodes[i].get();
+            environment_faces[i] = EnvironmentFace{images[i].pixels_.get(), images[i].width_, images[i].height_, images[i].channels_};
+        }
+        BakedEnvironment environment = bakeEnvironment(environment_faces, settings);
+        if (!environment.isValid()) {
+            std::cout << "Error::EnvironmentLighting::Skybox_Not_Baked " << faces[0] << std::endl;
+            return nullptr;
+        }
+        if (writeEnvironmentFile(environment_path, environment))
+            asset_database.record(environment_path, faces, ENVIRONMENT_BAKE_VERSION, settings_hash);
+        lighting->upload(environment.header_, environment.data_.data());
+        return lighting;
+    }
+
+    /// @brief create the SH uniform buffer and the specular cube with every prefiltered level
+    /// @param header validated header
+    /// @param texels RGB16F levels following the header
+    void EnvironmentLighting::upload(const EnvironmentFileHeader& header, const uint16_t* texels) {
+        mip_count_ = header.mip_count_;
+
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        // sh_ already has the std140 layout of vec4 sh[9]
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(header.sh_), header.sh_, GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glGenTextures(1, &specular_texture_id_);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, specular_texture_id_);
+        // RGB16F rows are 6 bytes a texel, the 1x1 levels don't fill a 4 byte row
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+        for (uint32_t level = 0; level < header.mip_count_; level++) {
+            const GLsizei size = static_cast<GLsizei>(std::max(1u, header.face_size_ >> level));
+            for (GLenum face = 0; face < 6; face++) {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, static_cast<GLint>(level), GL_RGB16F, size, size, 0,
+                             GL_RGB, GL_HALF_FLOAT, texels);
+                texels += size_t(size) * size * 3;
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header.mip_count_ - 1));
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+
+    void EnvironmentLighting::bind(GLenum texture_unit) const {
+        glBindBufferBase(GL_UNIFORM_BUFFER, AMBIENT_SH_BINDING, UBO);
+        glActiveTexture(GL_TEXTURE0 + texture_unit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, specular_texture_id_);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void EnvironmentLighting::deleteBuffer() {
+        if (UBO != 0)
+            glDeleteBuffers(1, &UBO);
+        if (specular_texture_id_ != 0)
+            glDeleteTextures(1, &specular_texture_id_);
+        UBO = specular_texture_id_ = 0;
+    }
+}
@@ -0,0 +1,220 @@
+#include "editor/include/geometry_buffer.h"
+#include "editor/include/mesh.h"
+#include "editor/include/vertex_format.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace Hd2d {
+    namespace {
+        // replace buffer by a bigger one holding the same first used_bytes
+        void reallocateBuffer(unsigned int& buffer, size_t used_bytes, size_t new_bytes) {
+            unsigned int new_buffer = 0;
+            glGenBuffers(1, &new_buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, new_bytes, nullptr, GL_STATIC_DRAW);
+            if (buffer != 0 && used_bytes > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used_bytes);
+            }
+            if (buffer != 0)
+                glDeleteBuffers(1, &buffer);
+            buffer = new_buffer;
+        }
+
+        // uploads go through the copy targets so no VAO state is touched
+        void uploadBuffer(unsigned int buffer, size_t offset, size_t size, const void* data) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        }
+    }
+
+    GeometryBuffer::GeometryBuffer(VertexLayout layout) : layout_{layout} {
+        glGenVertexArrays(1, &VAO);
+    }
+
+    GeometryBuffer::~GeometryBuffer() {
+        deleteBuffer();
+    }
+
+    std::shared_ptr<GeometryBuffer> GeometryBuffer::create(VertexLayout layout) {
+        return std::make_shared<GeometryBuffer>(layout);
+    }
+
+    /// @brief make room for more submeshes
+    /// @param vertex_count vertices the buffer has to hold in total
+    /// @param index_bytes index bytes the buffer has to hold in total
+    void GeometryBuffer::reserve(size_t vertex_count, size_t index_bytes) {
+        if (vertex_count > vertex_capacity_)
+            growVertices(vertex_count);
+        if (index_bytes > index_capacity_)
+            growIndices(index_bytes);
+    }
+
+    /// @brief append a submesh
+    /// @param vertex_streams vertices in this buffer's layout, the skin stream may be missing
+    /// @param index_stream indices local to vertex_streams
+    /// @return range to draw it with, empty if the layout doesn't match
+    GeometryRange GeometryBuffer::allocate(const VertexStreamView& vertex_streams, const IndexStreamView& index_stream) {
+        GeometryRange range;
+        range.index_type_ = index_stream.type_;
+        if (vertex_streams.layout_ != layout_) {
+            std::cout << "Error::GeometryBuffer::Vertex_Layout_Mismatch" << std::endl;
+            return range;
+        }
+
+        // a 32-bit range has to start on a 4 byte boundary
+        const size_t index_size   = getIndexSize(index_stream.type_);
+        const size_t index_offset = (index_bytes_ + index_size - 1) / index_size * index_size;
+        const size_t index_end    = index_offset + index_stream.index_count_ * index_size;
+        const size_t vertex_end   = vertex_count_ + vertex_streams.vertex_count_;
+        if (vertex_end > vertex_capacity_)
+            growVertices(std::max(vertex_end, vertex_capacity_ * 2));
+        if (index_end > index_capacity_)
+            growIndices(std::max(index_end, index_capacity_ * 2));
+
+        const size_t stride = getVertexStride(layout_);
+        uploadBuffer(VBO, vertex_count_ * stride, vertex_streams.vertex_count_ * stride, vertex_streams.vertices_);
+        if (vertex_streams.skin_ != nullptr && SkinVBO == 0)
+            createSkinBuffer();
+        if (SkinVBO != 0) {
+            // static submeshes sharing the buffer with skinned ones get zero weights
+            std::vector<SkinVertex> no_skin;
+            const void* skin = vertex_streams.skin_;
+            if (skin == nullptr) {
+                no_skin.resize(vertex_streams.vertex_count_, SkinVertex{});
+                skin = no_skin.data();
+            }
+            uploadBuffer(SkinVBO, vertex_count_ * sizeof(SkinVertex), vertex_streams.vertex_count_ * sizeof(SkinVertex), skin);
+        }
+        uploadBuffer(EBO, index_offset, index_end - index_offset, index_stream.indices_);
+
+        range.base_vertex_       = static_cast<GLint>(vertex_count_);
+        range.vertex_count_      = vertex_streams.vertex_count_;
+        range.index_byte_offset_ = index_offset;
+        range.index_count_       = index_stream.index_count_;
+        vertex_count_ = vertex_end;
+        index_bytes_  = index_end;
+        return range;
+    }
+
+    void GeometryBuffer::read(const GeometryRange& range, std::vector<unsigned char>& vertices, std::vector<SkinVertex>& skin) const {
+        const size_t stride = getVertexStride(layout_);
+        vertices.resize(range.vertex_count_ * stride);
+        skin.clear();
+        if (VBO == 0 || range.vertex_count_ == 0)
+            return;
+        glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, range.base_vertex_ * stride, vertices.size(), vertices.data());
+        if (SkinVBO != 0) {
+            skin.resize(range.vertex_count_);
+            glBindBuffer(GL_COPY_READ_BUFFER, SkinVBO);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, range.base_vertex_ * sizeof(SkinVertex), skin.size() * sizeof(SkinVertex), skin.data());
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    void GeometryBuffer::bind() const {
+        glBindVertexArray(VAO);
+    }
+
+    void GeometryBuffer::deleteBuffer() {
+        if (VAO != 0)
+            glDeleteVertexArrays(1, &VAO);
+        if (VBO != 0)
+            glDeleteBuffers(1, &VBO);
+        if (EBO != 0)
+            glDeleteBuffers(1, &EBO);
+        if (SkinVBO != 0)
+            glDeleteBuffers(1, &SkinVBO);
+        VAO = VBO = EBO = SkinVBO = 0;
+        vertex_capacity_ = vertex_count_ = index_capacity_ = index_bytes_ = 0;
+    }
+
+    void GeometryBuffer::growVertices(size_t vertex_capacity) {
+        reallocateBuffer(VBO, vertex_count_ * getVertexStride(layout_), vertex_capacity * getVertexStride(layout_));
+        if (SkinVBO != 0)
+            reallocateBuffer(SkinVBO, vertex_count_ * sizeof(SkinVertex), vertex_capacity * sizeof(SkinVertex));
+        vertex_capacity_ = vertex_capacity;
+        setupAttributes();
+    }
+
+    void GeometryBuffer::growIndices(size_t index_capacity) {
+        reallocateBuffer(EBO, index_bytes_, index_capacity);
+        index_capacity_ = index_capacity;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindVertexArray(0);
+    }
+
+    void GeometryBuffer::createSkinBuffer() {
+        // everything allocated so far is static
+        std::vector<SkinVertex> no_skin(vertex_capacity_, SkinVertex{});
+        glGenBuffers(1, &SkinVBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, SkinVBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, no_skin.size() * sizeof(SkinVertex), no_skin.data(), GL_STATIC_DRAW);
+        setupAttributes();
+    }
+
+    void GeometryBuffer::setupAttributes() {
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        // attribute locations stay the same for every layout, shaders decode normals with HD2D_OCT_NORMAL / HD2D_QTANGENT
+        if (layout_ == VertexLayout::Full) {
+            // position attribute
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // normal attribute
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal_));
+            // texture coord attribute
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords_));
+            // tangent attribute
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent_));
+            // bitangent attribute
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bitangent_));
+            // ids
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIDs_));
+            // weights
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, weights_));
+        } else if (layout_ == VertexLayout::Compact) {
+            // position attribute
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)0);
+            // octahedral normal attribute
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal_));
+            // half texture coord attribute
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, texCoords_));
+        } else {
+            // position attribute
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CompactTangentFrameVertex), (void*)0);
+            // half texture coord attribute
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactTangentFrameVertex), (void*)offsetof(CompactTangentFrameVertex, texCoords_));
+            // tangent frame quaternion attribute
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 4, GL_SHORT, GL_TRUE, sizeof(CompactTangentFrameVertex), (void*)offsetof(CompactTangentFrameVertex, tangentFrame_));
+        }
+
+        // compact layouts keep skinning in a second stream, only present once a skinned submesh was added
+        if (layout_ != VertexLayout::Full && SkinVBO != 0) {
+            glBindBuffer(GL_ARRAY_BUFFER, SkinVBO);
+            // ids
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, sizeof(SkinVertex), (void*)offsetof(SkinVertex, boneIDs_));
+            // weights
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SkinVertex), (void*)offsetof(SkinVertex, weights_));
+        }
+        glBindVertexArray(0);
+    }
+}
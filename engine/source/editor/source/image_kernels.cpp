@@ -0,0 +1,238 @@
+#include "editor/include/image_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HD2D_IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#define HD2D_IMAGE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HD2D_IMAGE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Hd2d {
+    namespace {
+        constexpr uint32_t SRGB_ENCODE_STEPS = 4096;
+
+        struct SrgbTables {
+            float   to_linear_[256];
+            float   thresholds_[255];                // linear value halfway (in sRGB) between code i and i + 1
+            uint8_t encode_start_[SRGB_ENCODE_STEPS]; // code of linear i / (SRGB_ENCODE_STEPS - 1), at most one short of the exact one
+        };
+
+        float srgbToLinear(float srgb) {
+            return srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+        }
+
+        const SrgbTables& getSrgbTables() {
+            static const SrgbTables tables = []() {
+                SrgbTables result;
+                for (int i = 0; i < 256; i++)
+                    result.to_linear_[i] = srgbToLinear(float(i) / 255.0f);
+                for (int i = 0; i < 255; i++)
+                    result.thresholds_[i] = srgbToLinear((float(i) + 0.5f) / 255.0f);
+                uint32_t code = 0;
+                for (uint32_t i = 0; i < SRGB_ENCODE_STEPS; i++) {
+                    while (code < 255 && float(i) / float(SRGB_ENCODE_STEPS - 1) >= result.thresholds_[code])
+                        code++;
+                    result.encode_start_[i] = uint8_t(code);
+                }
+                return result;
+            }();
+            return tables;
+        }
+
+        /// @brief nearest sRGB code of a linear value in 0..1, a table guess finished against the code thresholds so it is exact.
+        ///        one table step is finer than the smallest gap between codes, the guess is never off by more than one
+        uint8_t linearToSrgb(float linear, const SrgbTables& tables) {
+            uint32_t code = tables.encode_start_[uint32_t(linear * float(SRGB_ENCODE_STEPS - 1))];
+            if (code < 255 && linear >= tables.thresholds_[code])
+                code++;
+            return uint8_t(code);
+        }
+
+        uint8_t premultiplyChannel(uint32_t color, uint32_t alpha) {
+            const uint32_t product = color * alpha + 128;
+            return uint8_t((product + (product >> 8)) >> 8);
+        }
+
+#if HD2D_IMAGE_SSE2
+        /// @brief two RGBA texels widened to 16 bit lanes, every channel times the texel's alpha / 255
+        __m128i premultiplyWide(__m128i texels) {
+            const __m128i alpha   = _mm_shufflehi_epi16(_mm_shufflelo_epi16(texels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m128i product = _mm_add_epi16(_mm_mullo_epi16(texels, alpha), _mm_set1_epi16(128));
+            return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+        }
+#endif
+
+        /// @brief one target row of the plain 2x2 box, target_x is where the vector loop stopped
+        void downsampleRowScalar(const uint8_t* row0, const uint8_t* row1, uint32_t width, uint32_t channels,
+                                 uint32_t target_x, uint32_t target_width, uint8_t* target) {
+            for (; target_x < target_width; target_x++) {
+                const uint32_t x0 = target_x * 2;
+                const uint32_t x1 = std::min(x0 + 1, width - 1);
+                for (uint32_t c = 0; c < channels; c++) {
+                    const uint32_t sum = row0[x0 * channels + c] + row0[x1 * channels + c] + row1[x0 * channels + c] + row1[x1 * channels + c];
+                    target[target_x * channels + c] = uint8_t((sum + 2) >> 2);
+                }
+            }
+        }
+
+        /// @brief one target row with the color channels averaged in linear light
+        void downsampleRowSrgb(const uint8_t* row0, const uint8_t* row1, uint32_t width, uint32_t channels,
+                               uint32_t target_width, uint8_t* target) {
+            const SrgbTables& tables = getSrgbTables();
+            // gray alpha and RGBA keep alpha last, it is coverage and stays linear
+            const uint32_t color_channels = channels == 2 || channels == 4 ? channels - 1 : channels;
+            for (uint32_t target_x = 0; target_x < target_width; target_x++) {
+                const uint32_t x0 = target_x * 2;
+                const uint32_t x1 = std::min(x0 + 1, width - 1);
+                for (uint32_t c = 0; c < channels; c++) {
+                    const uint8_t texels[4] = {row0[x0 * channels + c], row0[x1 * channels + c], row1[x0 * channels + c], row1[x1 * channels + c]};
+                    if (c < color_channels) {
+                        const float linear = (tables.to_linear_[texels[0]] + tables.to_linear_[texels[1]] +
+                                              tables.to_linear_[texels[2]] + tables.to_linear_[texels[3]]) * 0.25f;
+                        target[target_x * channels + c] = linearToSrgb(linear, tables);
+                    }
+                    else
+                        target[target_x * channels + c] = uint8_t((uint32_t(texels[0]) + texels[1] + texels[2] + texels[3] + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    void expandRgbToRgba(const uint8_t* rgb, uint8_t* rgba, size_t texel_count) noexcept {
+        size_t i = 0;
+#if HD2D_IMAGE_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+        const __m128i alpha   = _mm_set1_epi32(int(0xFF000000u));
+        // 4 texels a step, the 16 byte load reads 4 bytes past them so the last texels are left to the tail
+        for (; i + 6 <= texel_count; i += 4) {
+            const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(source, shuffle), alpha));
+        }
+#elif HD2D_IMAGE_NEON
+        for (; i + 16 <= texel_count; i += 16) {
+            const uint8x16x3_t source = vld3q_u8(rgb + i * 3);
+            uint8x16x4_t       target;
+            target.val[0] = source.val[0];
+            target.val[1] = source.val[1];
+            target.val[2] = source.val[2];
+            target.val[3] = vdupq_n_u8(255);
+            vst4q_u8(rgba + i * 4, target);
+        }
+#endif
+        for (; i < texel_count; i++) {
+            rgba[i * 4 + 0] = rgb[i * 3 + 0];
+            rgba[i * 4 + 1] = rgb[i * 3 + 1];
+            rgba[i * 4 + 2] = rgb[i * 3 + 2];
+            rgba[i * 4 + 3] = 255;
+        }
+    }
+
+    void premultiplyAlpha(uint8_t* rgba, size_t texel_count) noexcept {
+        size_t i = 0;
+#if HD2D_IMAGE_SSE2
+        const __m128i zero       = _mm_setzero_si128();
+        const __m128i alpha_mask = _mm_set1_epi32(int(0xFF000000u));
+        for (; i + 4 <= texel_count; i += 4) {
+            const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+            const __m128i scaled = _mm_packus_epi16(premultiplyWide(_mm_unpacklo_epi8(texels, zero)),
+                                                    premultiplyWide(_mm_unpackhi_epi8(texels, zero)));
+            // alpha times itself would darken it, keep the original
+            const __m128i result = _mm_or_si128(_mm_andnot_si128(alpha_mask, scaled), _mm_and_si128(alpha_mask, texels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), result);
+        }
+#elif HD2D_IMAGE_NEON
+        for (; i + 8 <= texel_count; i += 8) {
+            uint8x8x4_t texels = vld4_u8(rgba + i * 4);
+            for (int c = 0; c < 3; c++) {
+                const uint16x8_t product = vmull_u8(texels.val[c], texels.val[3]);
+                texels.val[c] = vraddhn_u16(product, vrshrq_n_u16(product, 8));
+            }
+            vst4_u8(rgba + i * 4, texels);
+        }
+#endif
+        for (; i < texel_count; i++) {
+            uint8_t* texel = rgba + i * 4;
+            texel[0] = premultiplyChannel(texel[0], texel[3]);
+            texel[1] = premultiplyChannel(texel[1], texel[3]);
+            texel[2] = premultiplyChannel(texel[2], texel[3]);
+        }
+    }
+
+    void downsampleBox(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, bool srgb, uint8_t* target) noexcept {
+        const uint32_t target_width  = std::max(1u, width / 2);
+        const uint32_t target_height = std::max(1u, height / 2);
+        const size_t   source_pitch  = size_t(width) * channels;
+        const size_t   target_pitch  = size_t(target_width) * channels;
+        for (uint32_t target_y = 0; target_y < target_height; target_y++) {
+            const uint8_t* row0       = source + size_t(target_y) * 2 * source_pitch;
+            const uint8_t* row1       = height > 1 ? row0 + source_pitch : row0;
+            uint8_t*       target_row = target + target_y * target_pitch;
+            if (srgb) {
+                downsampleRowSrgb(row0, row1, width, channels, target_width, target_row);
+                continue;
+            }
+
+            uint32_t target_x = 0;
+            // two target texels from a 4x2 source block a step, width >= 2 keeps every source column inside the row
+            if (channels == 4 && width >= 2) {
+#if HD2D_IMAGE_SSE2
+                const __m128i zero  = _mm_setzero_si128();
+                const __m128i round = _mm_set1_epi16(2);
+                for (; target_x + 2 <= target_width; target_x += 2) {
+                    const __m128i top    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + target_x * 8));
+                    const __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + target_x * 8));
+                    const __m128i left   = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                    const __m128i right  = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+                    sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(target_row + target_x * 4), _mm_packus_epi16(sum, sum));
+                }
+#elif HD2D_IMAGE_NEON
+                for (; target_x + 2 <= target_width; target_x += 2) {
+                    const uint8x16_t top    = vld1q_u8(row0 + target_x * 8);
+                    const uint8x16_t bottom = vld1q_u8(row1 + target_x * 8);
+                    const uint16x8_t left   = vaddl_u8(vget_low_u8(top), vget_low_u8(bottom));
+                    const uint16x8_t right  = vaddl_u8(vget_high_u8(top), vget_high_u8(bottom));
+                    const uint16x8_t sum    = vcombine_u16(vadd_u16(vget_low_u16(left), vget_high_u16(left)),
+                                                           vadd_u16(vget_low_u16(right), vget_high_u16(right)));
+                    vst1_u8(target_row + target_x * 4, vrshrn_n_u16(sum, 2));
+                }
+#endif
+            }
+            downsampleRowScalar(row0, row1, width, channels, target_x, target_width, target_row);
+        }
+    }
+
+    /// @brief the whole mip chain below an image, each level filtered from the one above it
+    /// @param pixels level 0, width * height texels of channels bytes
+    /// @param srgb average color channels in linear light, for color maps but not normal or other data maps
+    /// @return levels 1 to the 1x1 one, empty for a 1x1 image
+    std::vector<std::vector<uint8_t>> buildMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, bool srgb) {
+        std::vector<std::vector<uint8_t>> levels;
+        uint32_t level_count = 0;
+        while ((std::max(width, height) >> (level_count + 1)) > 0)
+            level_count++;
+        levels.reserve(level_count);
+
+        const uint8_t* source = pixels;
+        while (width > 1 || height > 1) {
+            const uint32_t target_width  = std::max(1u, width / 2);
+            const uint32_t target_height = std::max(1u, height / 2);
+            levels.emplace_back(size_t(target_width) * target_height * channels);
+            downsampleBox(source, width, height, channels, srgb, levels.back().data());
+            source = levels.back().data();
+            width  = target_width;
+            height = target_height;
+        }
+        return levels;
+    }
+}
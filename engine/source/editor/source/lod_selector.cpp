@@ -0,0 +1,68 @@
+#include "editor/include/lod_selector.h"
+#include "editor/include/mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Hd2d {
+    /// @brief build the LOD selection state of one draw
+    /// @param model model matrix of the mesh, errors and distances both live in its space so uniform scale cancels out
+    /// @param view camera view matrix
+    /// @param zoom vertical field of view in degrees, see Camera::getZoom
+    /// @param viewport_height height in pixels of the target the mesh is rendered to
+    /// @param threshold_pixels screen space error a level may have
+    LodSelector LodSelector::fromCamera(const glm::mat4& model, const glm::mat4& view, float zoom, float viewport_height,
+                                        float threshold_pixels) noexcept {
+        LodSelector lod_selector;
+        lod_selector.camera_position_  = glm::vec3(glm::inverse(view * model)[3]);
+        lod_selector.projection_scale_ = viewport_height / (2.0f * std::tan(glm::radians(zoom) * 0.5f));
+        lod_selector.threshold_pixels_ = threshold_pixels;
+        return lod_selector;
+    }
+
+    LodSelector LodSelector::toLocalSpace(const glm::mat4& transform, const glm::mat3& normal_matrix) const noexcept {
+        LodSelector lod_selector = *this;
+        lod_selector.camera_position_ = glm::transpose(normal_matrix) * (camera_position_ - glm::vec3(transform[3]));
+        return lod_selector;
+    }
+
+    float LodSelector::getProjectedError(float error, const glm::vec3& center, float radius) const noexcept {
+        // measured to the closest point of the bounds, inside them nothing is coarse enough
+        const float distance = glm::length(center - camera_position_) - radius;
+        if (distance <= 0.0f)
+            return error > 0.0f ? threshold_pixels_ * 1e6f : 0.0f;
+        return error * projection_scale_ / distance;
+    }
+
+    /// @brief choose a level for this frame
+    /// @param lods levels ordered from the full mesh, errors growing
+    /// @param center bounds of level 0
+    /// @param radius bounds of level 0
+    /// @param current_lod level drawn last frame
+    /// @return level to draw
+    size_t LodSelector::select(const std::vector<MeshLod>& lods, const glm::vec3& center, float radius, size_t current_lod) const noexcept {
+        if (lods.empty())
+            return 0;
+        current_lod = std::min(current_lod, lods.size() - 1);
+        auto fits = [&](size_t lod, float factor) {
+            return getProjectedError(lods[lod].error_, center, radius) <= threshold_pixels_ * factor;
+        };
+
+        // coarser only once comfortably under the threshold
+        size_t coarser = current_lod;
+        for (size_t lod = current_lod + 1; lod < lods.size(); lod++)
+            if (fits(lod, 1.0f - hysteresis_))
+                coarser = lod;
+        if (coarser != current_lod)
+            return coarser;
+
+        // finer only once clearly over it
+        if (fits(current_lod, 1.0f + hysteresis_))
+            return current_lod;
+        size_t finer = 0;
+        for (size_t lod = 1; lod < current_lod; lod++)
+            if (fits(lod, 1.0f))
+                finer = lod;
+        return finer;
+    }
+}
@@ -10,12 +10,19 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <utility>
 
+#include "editor/include/animation.h"
+#include "editor/include/asset_database.h"
 #include "editor/include/config_manager.h"
 #include "editor/include/camera.h"
+#include "editor/include/environment_lighting.h"
 #include "editor/include/shader.h"
 #include "editor/include/model.h"
+#include "editor/include/scene_graph.h"
+#include "editor/include/texture_streamer.h"
 #include "editor/include/input.h"
+#include "editor/include/vertex_animation.h"
 
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
@@ -84,10 +91,11 @@ void initOpenGL() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-std::shared_ptr<ShaderProgram> loadShader(Hd2d::ConfigManager& config_manager, std::string shader_name) {
+std::shared_ptr<ShaderProgram> loadShader(Hd2d::ConfigManager& config_manager, std::string shader_name,
+                                          const std::vector<std::string>& defines = {}) {
     std::string vs_path = (config_manager.getShaderPath() / (shader_name + ".vs") ).generic_string();
     std::string fs_path = (config_manager.getShaderPath() / (shader_name + ".fs")).generic_string();
-    std::shared_ptr<ShaderProgram> shader = std::make_shared<ShaderProgram>(vs_path, fs_path);
+    std::shared_ptr<ShaderProgram> shader = std::make_shared<ShaderProgram>(vs_path, fs_path, defines);
     return shader;
 }
 
@@ -214,13 +222,9 @@ std::shared_ptr<Hd2d::Texture2D>  initPlane(Hd2d::ConfigManager& config_manager,
     return floor_texture;
 } 
 
-std::shared_ptr<Hd2d::Texture2D> initSkybox(Hd2d::ConfigManager& config_manager,
-                                           unsigned int& VAO, 
-                                           unsigned int& VBO) 
-{
-    // load skybox texture
-    std::vector<std::string> faces
-    {
+// +x, -x, +y, -y, +z, -z
+std::vector<std::string> getSkyboxFaces(Hd2d::ConfigManager& config_manager) {
+    return {
         (config_manager.getTexturePath() /"skybox/right.jpg").generic_string(),
         (config_manager.getTexturePath() /"skybox/left.jpg").generic_string(),
         (config_manager.getTexturePath() /"skybox/top.jpg").generic_string(),
@@ -228,6 +232,14 @@ std::shared_ptr<Hd2d::Texture2D> initSkybox(Hd2d::ConfigManager& config_manager,
         (config_manager.getTexturePath() /"skybox/front.jpg").generic_string(),
         (config_manager.getTexturePath() /"skybox/back.jpg").generic_string()
     };
+}
+
+std::shared_ptr<Hd2d::Texture2D> initSkybox(Hd2d::ConfigManager& config_manager,
+                                           unsigned int& VAO, 
+                                           unsigned int& VBO) 
+{
+    // load skybox texture
+    std::vector<std::string> faces = getSkyboxFaces(config_manager);
     std::shared_ptr<Hd2d::Texture2D> skybox_texture = Hd2d::Texture2D::loadCubemap(faces);
 
     float skybox_vertices[] = {
@@ -417,13 +429,44 @@ int main(int argc, char** argv)
     std::filesystem::path config_file_path = executable_path.parent_path() / "Hd2dEditor.ini";
     Hd2d::ConfigManager config_manager;
     config_manager.initialize(config_file_path);
+    // remembers which cooked files are still valid, so unchanged assets are neither hashed nor cooked again
+    Hd2d::AssetDatabase::getInstance().open(config_manager.getAssetIndexPath());
 
     std::string model_path = (config_manager.getModelPath() / "nanosuit/nanosuit.obj").generic_string();
-    Hd2d::Model our_model(model_path);
+    Hd2d::Model our_model(model_path, Hd2d::VertexLayout::Compact);
+    std::vector<std::string> model_defines = our_model.getShaderDefines();
+
+    // the animated crowd is a stress scene, only loaded when the ini asks for it
+    std::unique_ptr<Hd2d::Model> character_model;
+    if (config_manager.isDemoCrowdEnabled()) {
+        std::string character_path = (config_manager.getModelPath() / "nijika/nijika.FBX").generic_string();
+        character_model = std::make_unique<Hd2d::Model>(character_path, Hd2d::VertexLayout::Compact);
+    }
 
     // load shaders
-    std::shared_ptr<ShaderProgram> model_shader = loadShader(config_manager, "model_loading");
-    std::shared_ptr<ShaderProgram> edge_shader = loadShader(config_manager, "edge");
+    // the lit programs share the skybox ambient and one sun
+    const glm::vec3 light_direction(0.4f, -1.0f, 0.2f);
+    std::shared_ptr<ShaderProgram> model_shader = loadShader(config_manager, "model_loading", model_defines);
+    model_shader->use();
+    model_shader->setUniformBlock("Matrices", 0);
+    model_shader->setUniformBlock("AmbientSH", Hd2d::AMBIENT_SH_BINDING);
+    model_shader->setUniform("lightDirection", light_direction);
+    std::shared_ptr<ShaderProgram> edge_shader = loadShader(config_manager, "edge", model_defines);
+    std::shared_ptr<ShaderProgram> character_shader;
+    if (character_model != nullptr) {
+        character_shader = loadShader(config_manager, "model_loading", character_model->getShaderDefines());
+        character_shader->use();
+        character_shader->setUniformBlock("Matrices", 0);
+        character_shader->setUniformBlock("BonePalette", Hd2d::BONE_PALETTE_BINDING);
+        character_shader->setUniformBlock("AmbientSH", Hd2d::AMBIENT_SH_BINDING);
+        character_shader->setUniform("lightDirection", light_direction);
+    }
+
+    std::shared_ptr<ShaderProgram> vertex_animation_shader = loadShader(config_manager, "vertex_animation");
+    vertex_animation_shader->use();
+    vertex_animation_shader->setUniformBlock("Matrices", 0);
+    vertex_animation_shader->setUniformBlock("AmbientSH", Hd2d::AMBIENT_SH_BINDING);
+    vertex_animation_shader->setUniform("lightDirection", light_direction);
 
     std::shared_ptr<ShaderProgram> screen_shader = loadShader(config_manager, "screen");
     screen_shader->use();
@@ -444,6 +487,8 @@ int main(int argc, char** argv)
     floor_shader->use();
     floor_shader->setTexture("floor_texture", 0);
     floor_shader->setUniformBlock("Matrices", 0);
+    floor_shader->setUniformBlock("AmbientSH", Hd2d::AMBIENT_SH_BINDING);
+    floor_shader->setUniform("lightDirection", light_direction);
 
     std::shared_ptr<ShaderProgram> grass_shader = loadShader(config_manager, "grass");
     grass_shader->use();
@@ -457,7 +502,7 @@ int main(int argc, char** argv)
     std::string normal_vs_path = (config_manager.getShaderPath() / "normal_visualization.vs").generic_string();
     std::string normal_gs_path = (config_manager.getShaderPath() / "normal_visualization.gs").generic_string();
     std::string normal_fs_path = (config_manager.getShaderPath() / "normal_visualization.fs").generic_string();
-    ShaderProgram normal_shader(normal_vs_path, normal_gs_path, normal_fs_path);
+    ShaderProgram normal_shader(normal_vs_path, normal_gs_path, normal_fs_path, model_defines);
     normal_shader.use();
     normal_shader.setUniformBlock("Matrices", 0);
 
@@ -476,6 +521,10 @@ int main(int argc, char** argv)
     unsigned int skyboxVBO;
     std::shared_ptr<Hd2d::Texture2D> skybox_texture = 
     initSkybox(config_manager, skyboxVAO, skyboxVBO); 
+    // ambient light and prefiltered reflections of the skybox, baked on the worker pool the first time only
+    std::shared_ptr<Hd2d::EnvironmentLighting> environment = Hd2d::EnvironmentLighting::load(getSkyboxFaces(config_manager));
+    if (environment != nullptr)
+        environment->bind();
 
     unsigned int windowVAO;
     unsigned int windowVBO;
@@ -511,6 +560,50 @@ int main(int argc, char** argv)
 
     glm::vec3 lightPos(-2.0f, 4.0f, -1.0f);
 
+    // scene layout, world matrices are only recomputed below nodes whose local transform changed
+    Hd2d::SceneGraph scene;
+    const size_t floor_node = scene.addNode(Hd2d::SceneGraph::NO_PARENT, glm::mat4(1.0f), "floor");
+    // the model is a bit too big for our scene, so scale it down
+    const size_t model_node = scene.addNode(Hd2d::SceneGraph::NO_PARENT, glm::scale(glm::mat4(1.0f), glm::vec3(0.1f)), "model");
+    const size_t model_root = our_model.attachTo(scene, static_cast<int>(model_node));
+    // a crowd of characters sharing one model, each posed by its own animator instance
+    Hd2d::Animator animator;
+    std::vector<std::pair<size_t, size_t>> characters; // scene root, animator instance
+    if (character_model != nullptr && character_model->getSkeleton() != nullptr) {
+        const std::vector<std::shared_ptr<Hd2d::AnimationClip>>& clips = character_model->getClips();
+        for(int i = 0; i < 16; i++) {
+            glm::mat4 placement = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f + 2.0f * (i % 4), 0.0f, -6.0f - 2.0f * (i / 4)));
+            // FBX units are centimetres
+            placement = glm::scale(placement, glm::vec3(0.01f));
+            const size_t placement_node = scene.addNode(Hd2d::SceneGraph::NO_PARENT, placement, "character");
+            const size_t instance = animator.addInstance(character_model->getSkeleton());
+            if (!clips.empty())
+                animator.play(instance, clips[i % clips.size()], 0.37f * i);
+            characters.emplace_back(character_model->attachTo(scene, static_cast<int>(placement_node)), instance);
+        }
+    }
+    // background villagers play a baked clip on the GPU, one instanced draw per mesh and no CPU posing
+    std::shared_ptr<Hd2d::VertexAnimationTexture> villager_animation;
+    Hd2d::VertexAnimationCrowd villagers;
+    if (character_model != nullptr && character_model->getSkeleton() != nullptr && !character_model->getClips().empty()) {
+        villager_animation = Hd2d::VertexAnimationTexture::create(
+            Hd2d::bakeVertexAnimation(*character_model, *character_model->getClips()[0]));
+        for(int i = 0; i < 100; i++) {
+            glm::mat4 placement = glm::translate(glm::mat4(1.0f), glm::vec3(-9.0f + 2.0f * (i % 10), 0.0f, -16.0f - 2.0f * (i / 10)));
+            placement = glm::scale(placement, glm::vec3(0.01f));
+            villagers.addInstance(placement, 0.29f * i, 0.9f + 0.02f * (i % 10));
+        }
+    }
+    std::vector<size_t> window_nodes;
+    for(const glm::vec3& window_position : windows)
+        window_nodes.push_back(scene.addNode(Hd2d::SceneGraph::NO_PARENT, glm::translate(glm::mat4(1.0f), window_position), "window"));
+    Hd2d::AssetDatabase::getInstance().save();
+
+    // uniforms set every frame, hashed once here instead of looked up by name on each call
+    constexpr UniformId model_uniform{"model"};
+    constexpr UniformId color_uniform{"color"};
+    constexpr UniformId view_sp_uniform{"view_sp"};
+
     while (!glfwWindowShouldClose(window))
     {
         // per-frame time logic
@@ -521,11 +614,18 @@ int main(int argc, char** argv)
         // input
         input.processInput(window, delta_time);
 
+        scene.update();
+        // pose the crowd on the worker pool, then hand the palettes to the GPU
+        if (!characters.empty()) {
+            animator.update(delta_time);
+            animator.upload();
+        }
+
         // sort for transparent object
-        std::map<float, glm::vec3> sorted_map;
-        for(unsigned int i =0; i < windows.size(); i++ ) {
-            float distance = glm::length(camera.getPosition() - windows[i]);
-            sorted_map[distance] = windows[i];
+        std::map<float, size_t> sorted_map;
+        for(size_t window_node : window_nodes) {
+            float distance = glm::length(camera.getPosition() - glm::vec3(scene.getWorldTransform(window_node)[3]));
+            sorted_map[distance] = window_node;
         }
 
         // render configuration
@@ -552,8 +652,7 @@ int main(int argc, char** argv)
 
         // draw floor
         floor_shader->use();
-        glm::mat4 floor_model = glm::mat4(1.0f);
-        floor_shader->setUniform("model", floor_model);
+        floor_shader->setUniform(model_uniform, scene.getWorldTransform(floor_node));
         glBindVertexArray(planeVAO);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, floor_texture->getTextureId());
@@ -565,17 +664,17 @@ int main(int argc, char** argv)
 
         glEnable(GL_CULL_FACE);
         model_shader->use();
-        // draw the loaded model
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); 
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));	
-        model_shader->setUniform("model", model);
-        our_model.draw(*model_shader);
+        // draw the loaded model, its nodes take their matrices from the scene
+        // skip meshlets outside the view or facing away, back faces are culled for this pass
+        Hd2d::CullView world_cull_view = Hd2d::CullView::fromMatrices(glm::mat4(1.0f), view, projection);
+        // the scene renders at 1/buf_scale resolution, pick levels for the pixels actually drawn
+        Hd2d::LodSelector world_lod_selector = Hd2d::LodSelector::fromCamera(glm::mat4(1.0f), view, camera.getZoom(), 
+                                                                             static_cast<float>(SCR_HEIGHT / buf_scale));
+        our_model.draw(*model_shader, scene, model_root, &world_cull_view, &world_lod_selector);
 
         if(isNormalShow) {
             normal_shader.use();
-            normal_shader.setUniform("model", model);
-            our_model.draw(normal_shader);
+            our_model.draw(normal_shader, scene, model_root, nullptr, &world_lod_selector);
         }
 
         glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
@@ -587,28 +686,42 @@ int main(int argc, char** argv)
         color.x = static_cast<float>(sin(glfwGetTime() * 4.0) + 1.0f);
         color.y = static_cast<float>(sin(glfwGetTime() * 1.4) + 1.0f);
         color.z = static_cast<float>(sin(glfwGetTime() * 2.6) + 1.0f);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));	// it's a bit too big for our scene, so scale it down
-        edge_shader->setUniform("color", color);
-        edge_shader->setUniform("model", model);
-        our_model.draw(*edge_shader);
+        edge_shader->setUniform(color_uniform, color);
+        our_model.draw(*edge_shader, scene, model_root, &world_cull_view, &world_lod_selector);
 
         glBindVertexArray(0);
         glStencilMask(0xFF);
         glStencilFunc(GL_ALWAYS, 0, 0xFF);
 
+        // draw the characters
+        if (!characters.empty()) {
+            character_shader->use();
+            for(const std::pair<size_t, size_t>& character : characters) {
+                animator.bind(character.second);
+                character_model->draw(*character_shader, scene, character.first, &world_cull_view, &world_lod_selector);
+            }
+        }
+        if (villager_animation != nullptr) {
+            vertex_animation_shader->use();
+            villager_animation->bind(*vertex_animation_shader);
+            // they stand far back, the first coarser level is plenty
+            villagers.draw(*vertex_animation_shader, *character_model, currentFrame, 1);
+        }
+
         glDisable(GL_CULL_FACE);
 
+        // what the models were drawn at decides which texture mips stream in for the next frames
+        our_model.requestTextures(scene, model_root, world_lod_selector, &world_cull_view);
+        for(const std::pair<size_t, size_t>& character : characters)
+            character_model->requestTextures(scene, character.first, world_lod_selector, &world_cull_view);
+        Hd2d::TextureStreamer::getInstance().update();
+
         // draw transparent object (windows)
         blend_shader->use();
         glBindVertexArray(windowVAO);
         glBindTexture(GL_TEXTURE_2D, window_texture->getTextureId());
-        for(std::map<float, glm::vec3>::reverse_iterator it = sorted_map.rbegin(); it != sorted_map.rend(); ++it ) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
-            blend_shader->setUniform("model", model);
+        for(std::map<float, size_t>::reverse_iterator it = sorted_map.rbegin(); it != sorted_map.rend(); ++it ) {
+            blend_shader->setUniform(model_uniform, scene.getWorldTransform(it->second));
             glDrawArrays(GL_TRIANGLES, 0, 6);
         }
 
@@ -616,7 +729,7 @@ int main(int argc, char** argv)
         glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
         skybox_shader->use();
         glm::mat4 view_sp = glm::mat4(glm::mat3(camera.getViewMatrix())); // remove translation from the view matrix
-        skybox_shader->setUniform("view_sp", view_sp);
+        skybox_shader->setUniform(view_sp_uniform, view_sp);
         // skybox cube
         glBindVertexArray(skyboxVAO);
         glActiveTexture(GL_TEXTURE0);
@@ -645,6 +758,13 @@ int main(int argc, char** argv)
     }
 
     our_model.deleteBuffer();
+    if (character_model != nullptr)
+        character_model->deleteBuffer();
+    animator.deleteBuffer();
+    villagers.deleteBuffer();
+    villager_animation.reset();
+    if (environment != nullptr)
+        environment->deleteBuffer();
     glDeleteVertexArrays(1, &grassVAO);
     glDeleteBuffers(1, &grassVBO);
     glDeleteVertexArrays(1, &windowVAO);
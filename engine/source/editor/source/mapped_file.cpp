@@ -0,0 +1,93 @@
+#include "editor/include/mapped_file.h"
+
+#include <string>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Hd2d {
+    MappedFile::~MappedFile() {
+#ifdef _WIN32
+        if (data_ != nullptr)
+            UnmapViewOfFile(data_);
+        if (mapping_ != nullptr)
+            CloseHandle(static_cast<HANDLE>(mapping_));
+#else
+        if (data_ != nullptr)
+            munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+
+    /// @brief map a whole file read only
+    /// @param file_path file to map
+    /// @return mapping, nullptr on failure
+    std::shared_ptr<MappedFile> MappedFile::open(std::string_view file_path) {
+        std::shared_ptr<MappedFile> mapped_file = std::make_shared<MappedFile>();
+        std::string path{file_path};
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return nullptr;
+
+        LARGE_INTEGER file_size{};
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return nullptr;
+        }
+        mapped_file->size_ = static_cast<size_t>(file_size.QuadPart);
+        if (mapped_file->size_ == 0) {
+            CloseHandle(file);
+            return mapped_file;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        // the mapping keeps the file alive on its own
+        CloseHandle(file);
+        if (mapping == nullptr)
+            return nullptr;
+        mapped_file->mapping_ = mapping;
+
+        mapped_file->data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (mapped_file->data_ == nullptr)
+            return nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            return nullptr;
+        }
+        mapped_file->size_ = static_cast<size_t>(file_stat.st_size);
+        if (mapped_file->size_ == 0) {
+            close(fd);
+            return mapped_file;
+        }
+
+        void* data = mmap(nullptr, mapped_file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive on its own
+        close(fd);
+        if (data == MAP_FAILED)
+            return nullptr;
+        mapped_file->data_ = static_cast<const unsigned char*>(data);
+#endif
+
+        return mapped_file;
+    }
+}
@@ -0,0 +1,124 @@
+#include "editor/include/material.h"
+#include "editor/include/hash.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace Hd2d {
+    namespace {
+        // what the last Material::bind left on the texture units
+        struct BoundMaterial {
+            uint64_t     material_id_ = 0;
+            unsigned int program_id_  = 0;
+        };
+
+        BoundMaterial bound_material;
+        uint64_t      next_material_id = 1;
+        // weak like the texture cache, a material lives as long as some mesh draws with it
+        std::unordered_map<uint64_t, std::weak_ptr<const Material>> materials;
+        // materials of unloaded models are only looked up again by chance, expired entries are swept
+        // whenever the map doubles
+        constexpr size_t MIN_SWEEP_SIZE = 64;
+        size_t sweep_size = MIN_SWEEP_SIZE;
+
+        void sweepExpiredMaterials() {
+            for (auto it = materials.begin(); it != materials.end();) {
+                if (it->second.expired())
+                    it = materials.erase(it);
+                else
+                    ++it;
+            }
+            sweep_size = std::max(MIN_SWEEP_SIZE, materials.size() * 2);
+        }
+    }
+
+    /// @brief the material of a mesh, shared with every live mesh using the same textures
+    /// @param textures mesh textures, their order decides the texture units
+    /// @return material
+    std::shared_ptr<const Material> Material::create(const std::vector<Texture2D>& textures) {
+        std::vector<GLuint>      texture_ids;
+        std::vector<std::string> samplers;
+        texture_ids.reserve(textures.size());
+        samplers.reserve(textures.size());
+        unsigned int diffuse_count  = 1;
+        unsigned int specular_count = 1;
+        unsigned int normal_count   = 1;
+        unsigned int height_count   = 1;
+        uint64_t key = FNV_OFFSET_BASIS;
+        for (const Texture2D& texture : textures) {
+            // retrieve texture number (the N in texture_diffuseN)
+            const std::string& type = texture.getTextureType();
+            std::string number;
+            if (type == "texture_diffuse")
+                number = std::to_string(diffuse_count++);
+            else if (type == "texture_specular")
+                number = std::to_string(specular_count++);
+            else if (type == "texture_normal")
+                number = std::to_string(normal_count++);
+            else if (type == "texture_height")
+                number = std::to_string(height_count++);
+            texture_ids.push_back(texture.getTextureId());
+            samplers.push_back(type + number);
+            key = fnv1a64(&texture_ids.back(), sizeof(GLuint), key);
+            key = fnv1a64(samplers.back(), key);
+        }
+
+        std::shared_ptr<const Material> cached;
+        auto it = materials.find(key);
+        if (it != materials.end()) {
+            cached = it->second.lock();
+            if (cached == nullptr)
+                materials.erase(it);
+            else if (cached->texture_ids_ == texture_ids && cached->samplers_ == samplers)
+                return cached;
+        }
+
+        auto material = std::make_shared<Material>();
+        material->id_          = next_material_id++;
+        material->texture_ids_ = std::move(texture_ids);
+        material->samplers_    = std::move(samplers);
+        // a hash collision keeps the older material cached, the new one just isn't shared
+        if (cached == nullptr) {
+            if (materials.size() >= sweep_size)
+                sweepExpiredMaterials();
+            materials.emplace(key, material);
+        }
+        return material;
+    }
+
+    void Material::bind(const ShaderProgram& shader_program) const {
+        const unsigned int program_id = shader_program.getId();
+        if (bound_material.material_id_ == id_ && bound_material.program_id_ == program_id)
+            return;
+
+        const std::vector<GLint>& locations = getLocations(shader_program);
+        for (size_t unit = 0; unit < texture_ids_.size(); unit++) {
+            glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+            glBindTexture(GL_TEXTURE_2D, texture_ids_[unit]);
+            // sampler uniforms are program state another material may have pointed elsewhere
+            if (locations[unit] >= 0)
+                glUniform1i(locations[unit], static_cast<GLint>(unit));
+        }
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+        bound_material = BoundMaterial{id_, program_id};
+    }
+
+    void Material::invalidateBinding() noexcept {
+        bound_material = BoundMaterial{};
+    }
+
+    const std::vector<GLint>& Material::getLocations(const ShaderProgram& shader_program) const {
+        const unsigned int program_id = shader_program.getId();
+        for (const auto& program_locations : program_locations_)
+            if (program_locations.first == program_id)
+                return program_locations.second;
+
+        std::vector<GLint> locations;
+        locations.reserve(samplers_.size());
+        for (const std::string& sampler : samplers_)
+            locations.push_back(shader_program.getUniformLocation(UniformId{sampler}));
+        program_locations_.emplace_back(program_id, std::move(locations));
+        return program_locations_.back().second;
+    }
+}
@@ -1,9 +1,13 @@
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <glad/glad.h>
 
 #include "editor/include/mesh.h"
+#include "editor/include/vertex_format.h"
 #include "editor/include/shader.h"
 #include "editor/include/texture2d.h"
 
@@ -11,92 +15,231 @@ namespace Hd2d {
     Mesh::Mesh(std::vector<Vertex>       vertices   ,
                std::vector<unsigned int> indices    ,
                std::vector<Texture2D>    textures ) :
-               vertices_ {vertices} ,
-               indices_  {indices } ,
-               textures_ {textures}
+               vertices_ {std::move(vertices)} ,
+               indices_  {std::move(indices )} ,
+               textures_ {std::move(textures)}
     {
-        setupMesh();
-    }
-
-    void Mesh::draw(ShaderProgram& shader_program) {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures_.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            std::string number;
-            std::string name = std::string{textures_[i].getTextureType()};
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-                
-            // now set the sampler to the correct texture unit
-            shader_program.setUniform((name + number).c_str(), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures_[i].getTextureId());
+        VertexStreamView vertex_streams;
+        vertex_streams.vertex_count_ = vertices_.size();
+        vertex_streams.vertices_     = vertices_.data();
+
+        // narrow the upload when every vertex is addressable with 16 bits, indices_ keeps the 32-bit copy
+        IndexStreamView index_stream;
+        index_stream.index_count_ = indices_.size();
+        index_stream.indices_     = indices_.data();
+        std::vector<uint16_t> narrow_indices;
+        if (selectIndexType(vertices_.size()) == IndexType::UInt16) {
+            narrow_indices.assign(indices_.begin(), indices_.end());
+            index_stream.type_    = IndexType::UInt16;
+            index_stream.indices_ = narrow_indices.data();
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices_.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        setupMesh(vertex_streams, index_stream, nullptr);
+    }
+
+    Mesh::Mesh(MeshData&&                      mesh_data ,
+               std::vector<Texture2D>          textures  ,
+               MeshResidency                   residency ,
+               std::shared_ptr<GeometryBuffer> geometry ) :
+               textures_ {std::move(textures)} ,
+               meshlets_ {std::move(mesh_data.meshlets_)} ,
+               lods_     {std::move(mesh_data.lods_)}
+    {
+        const IndexStreamView index_stream = mesh_data.getIndexStream();
+        setupMesh(mesh_data.getVertexStreams(), index_stream, std::move(geometry), 
+                  mesh_data.bounds_.box_.isEmpty() ? nullptr : &mesh_data.bounds_);
+        if (residency == MeshResidency::Keep) {
+            vertices_ = std::move(mesh_data.vertices_);
+            indices_  = std::move(mesh_data.indices_);
+            indices_.resize(getBaseIndexStream(index_stream).index_count_);
+        } else if (residency == MeshResidency::KeepCompressed) {
+            compressed_ = compressMeshCopy(mesh_data.getVertexStreams(), getBaseIndexStream(index_stream));
+        }
+    }
+
+    Mesh::Mesh(const VertexStreamView& vertex_streams,
+               const IndexStreamView&  index_stream  ,
+               std::vector<Texture2D>  textures      ,
+               MeshResidency           residency     ,
+               std::vector<Meshlet>    meshlets      ,
+               std::vector<MeshLod>    lods          ,
+               std::shared_ptr<GeometryBuffer> geometry ,
+               const MeshBounds*       bounds        ) :
+               textures_ {std::move(textures)} ,
+               meshlets_ {std::move(meshlets)} ,
+               lods_     {std::move(lods)}
+    {
+        setupMesh(vertex_streams, index_stream, std::move(geometry), bounds);
+        const IndexStreamView base_index_stream = getBaseIndexStream(index_stream);
+        if (residency == MeshResidency::Keep && vertex_streams.layout_ == VertexLayout::Full) {
+            const Vertex* vertices = static_cast<const Vertex*>(vertex_streams.vertices_);
+            vertices_.assign(vertices, vertices + vertex_streams.vertex_count_);
+            indices_.resize(base_index_stream.index_count_);
+            for (size_t i = 0; i < base_index_stream.index_count_; i++)
+                indices_[i] = index_stream.type_ == IndexType::UInt16 ? static_cast<const uint16_t*>(index_stream.indices_)[i]
+                                                                      : static_cast<const uint32_t*>(index_stream.indices_)[i];
+        } else if (residency != MeshResidency::DiscardAfterUpload) {
+            compressed_ = compressMeshCopy(vertex_streams, base_index_stream);
+        }
+    }
+
+    IndexStreamView Mesh::getBaseIndexStream(const IndexStreamView& index_stream) const {
+        IndexStreamView base_index_stream = index_stream;
+        if (!lods_.empty())
+            base_index_stream.index_count_ = std::min<size_t>(lods_[0].index_count_, index_stream.index_count_);
+        return base_index_stream;
+    }
+
+    size_t Mesh::getCpuBytes() const noexcept {
+        return vertices_.capacity() * sizeof(Vertex) + indices_.capacity() * sizeof(unsigned int) + compressed_.getByteSize();
+    }
+
+    size_t CompressedMeshCopy::getIndexCount() const noexcept {
+        return indices_.size() / getIndexSize(index_type_);
+    }
+
+    glm::vec3 CompressedMeshCopy::getPosition(size_t vertex) const noexcept {
+        const uint16_t* quantized = &positions_[vertex * 3];
+        return bounds_min_ + glm::vec3(quantized[0], quantized[1], quantized[2]) * bounds_scale_;
+    }
+
+    unsigned int CompressedMeshCopy::getIndex(size_t index) const noexcept {
+        if (index_type_ == IndexType::UInt16) {
+            uint16_t value;
+            std::memcpy(&value, &indices_[index * sizeof(value)], sizeof(value));
+            return value;
+        }
+        uint32_t value;
+        std::memcpy(&value, &indices_[index * sizeof(value)], sizeof(value));
+        return value;
+    }
+
+    VertexStreamView MeshData::getVertexStreams() const {
+        VertexStreamView vertex_streams;
+        vertex_streams.layout_       = layout_;
+        vertex_streams.vertex_count_ = vertices_.size();
+        if (layout_ == VertexLayout::Full) {
+            vertex_streams.vertices_ = vertices_.data();
+        } else {
+            vertex_streams.vertices_ = packed_vertices_.data();
+            vertex_streams.skin_     = skin_.empty() ? nullptr : skin_.data();
+        }
+        return vertex_streams;
+    }
+
+    IndexStreamView MeshData::getIndexStream() const {
+        IndexStreamView index_stream;
+        index_stream.type_        = index_type_;
+        index_stream.index_count_ = indices_.size();
+        index_stream.indices_     = index_type_ == IndexType::UInt16 ? static_cast<const void*>(packed_indices_.data()) 
+                                                                     : static_cast<const void*>(indices_.data());
+        return index_stream;
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
-    }
-
-    void Mesh::setupMesh() {
-        // configure the cubes
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-        // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(Vertex), 
-                     &vertices_[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), 
-                     &indices_[0], GL_STATIC_DRAW);
-
-        // position attribute
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // normal attribute
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal_));
-        // texture coord attribute
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords_));
-        // tangent attribute
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent_));
-        // bitangent attribute
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bitangent_));
-        // ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIDs_));
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, weights_));
-        
+    void Mesh::draw(ShaderProgram& shader_program, const CullView* cull_view, const LodSelector* lod_selector) {
+        if (geometry_ == nullptr)
+            return;
+        geometry_->bind();
+        // a lone mesh can't know what was bound since its last draw
+        Material::invalidateBinding();
+        drawBound(shader_program, cull_view, lod_selector);
         glBindVertexArray(0);
     }
 
+    void Mesh::drawBound(ShaderProgram& shader_program, const CullView* cull_view, const LodSelector* lod_selector) {
+        // one box test before walking the meshlets
+        if (cull_view != nullptr && !cull_view->frustum_.isBoxVisible(bounds_.box_))
+            return;
+        if (lod_selector != nullptr && lods_.size() > 1)
+            current_lod_ = lod_selector->select(lods_, bounds_.sphere_.center_, bounds_.sphere_.radius_, current_lod_);
+
+        material_->bind(shader_program);
+
+        // draw mesh
+        drawElements(cull_view);
+    }
+
+    /// @brief draw a whole level instance_count times, with getGeometry() already bound.
+    /// per-instance attributes are the caller's, see VertexAnimationCrowd
+    void Mesh::drawInstanced(ShaderProgram& shader_program, GLsizei instance_count, size_t lod) {
+        material_->bind(shader_program);
+
+        const GLenum index_type  = range_.index_type_ == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        uint32_t     first_index = 0;
+        size_t       index_count = range_.index_count_;
+        if (!lods_.empty()) {
+            const MeshLod& level = lods_[std::min(lod, lods_.size() - 1)];
+            first_index = level.index_offset_;
+            index_count = level.index_count_;
+        }
+        const void* index_offset = reinterpret_cast<const void*>(range_.index_byte_offset_ + 
+                                                                 static_cast<uintptr_t>(first_index) * getIndexSize(range_.index_type_));
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(index_count), index_type, index_offset,
+                                          instance_count, range_.base_vertex_);
+    }
+
+    void Mesh::drawElements(const CullView* cull_view) {
+        const GLenum index_type = range_.index_type_ == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        const size_t index_size = getIndexSize(range_.index_type_);
+        // offsets are relative to this mesh's range of the shared index buffer
+        auto index_offset = [this, index_size](uint32_t first_index) {
+            return reinterpret_cast<const void*>(range_.index_byte_offset_ + static_cast<uintptr_t>(first_index) * index_size);
+        };
+        // coarser levels are drawn whole, meshlets only cover level 0
+        if (!lods_.empty() && (current_lod_ > 0 || cull_view == nullptr || meshlets_.empty())) {
+            const MeshLod& lod = lods_[std::min(current_lod_, lods_.size() - 1)];
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(lod.index_count_), index_type, 
+                                     index_offset(lod.index_offset_), range_.base_vertex_);
+            return;
+        }
+        if (cull_view == nullptr || meshlets_.empty()) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range_.index_count_), index_type, 
+                                     index_offset(0), range_.base_vertex_);
+            return;
+        }
+
+        // visible meshlets next to each other in the index buffer merge into one range
+        draw_counts_.clear();
+        draw_offsets_.clear();
+        uint32_t range_end = ~0u;
+        for (const Meshlet& meshlet : meshlets_) {
+            if (!cull_view->isClusterVisible(meshlet.center_, meshlet.radius_, meshlet.cone_axis_, meshlet.cone_cutoff_))
+                continue;
+            if (meshlet.index_offset_ == range_end) {
+                draw_counts_.back() += static_cast<GLsizei>(meshlet.index_count_);
+            } else {
+                draw_counts_.push_back(static_cast<GLsizei>(meshlet.index_count_));
+                draw_offsets_.push_back(index_offset(meshlet.index_offset_));
+            }
+            range_end = meshlet.index_offset_ + meshlet.index_count_;
+        }
+
+        if (draw_counts_.size() == 1) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, draw_counts_[0], index_type, draw_offsets_[0], range_.base_vertex_);
+        } else if (!draw_counts_.empty()) {
+            draw_base_vertices_.assign(draw_counts_.size(), range_.base_vertex_);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, draw_counts_.data(), index_type, draw_offsets_.data(), 
+                                          static_cast<GLsizei>(draw_counts_.size()), draw_base_vertices_.data());
+        }
+    }
+
+    void Mesh::setupMesh(const VertexStreamView& vertex_streams, const IndexStreamView& index_stream,
+                         std::shared_ptr<GeometryBuffer> geometry, const MeshBounds* bounds) {
+        material_ = Material::create(textures_);
+        bounds_ = bounds != nullptr ? *bounds : computeMeshBounds(vertex_streams);
+        if (vertex_streams.layout_ == VertexLayout::Full) {
+            const Vertex* vertices = static_cast<const Vertex*>(vertex_streams.vertices_);
+            skinned_ = std::any_of(vertices, vertices + vertex_streams.vertex_count_, [](const Vertex& vertex) {
+                return std::any_of(std::begin(vertex.weights_), std::end(vertex.weights_), [](float w) { return w > 0.0f; });
+            });
+        } else {
+            skinned_ = vertex_streams.skin_ != nullptr;
+        }
+        geometry_ = geometry != nullptr ? std::move(geometry) : GeometryBuffer::create(vertex_streams.layout_);
+        range_    = geometry_->allocate(vertex_streams, index_stream);
+    }
+
     void Mesh::deleteBuffer() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        // the GL objects go with the last mesh or model referencing the buffer
+        geometry_.reset();
     }
 }
\ No newline at end of file
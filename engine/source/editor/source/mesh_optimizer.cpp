@@ -0,0 +1,541 @@
+#include "editor/include/mesh_optimizer.h"
+#include "editor/include/hash.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace Hd2d {
+    namespace {
+        // FIFO post-transform cache simulation, a vertex is cached while fewer than size misses happened since its own
+        class FifoCache {
+        public:
+            FifoCache(size_t vertex_count, unsigned int size) : timestamps_(vertex_count, 0), time_{size + 1}, size_{size} {}
+
+            // true on a miss
+            bool access(unsigned int vertex) {
+                if (time_ - timestamps_[vertex] > size_) {
+                    timestamps_[vertex] = time_++;
+                    return true;
+                }
+                return false;
+            }
+
+            void reset() { time_ += size_ + 1; }
+
+        private:
+            std::vector<unsigned int> timestamps_;
+            unsigned int              time_;
+            unsigned int              size_;
+        };
+
+        unsigned int triangleMisses(FifoCache& cache, const unsigned int* triangle) {
+            return cache.access(triangle[0]) + cache.access(triangle[1]) + cache.access(triangle[2]);
+        }
+
+        // Forsyth's scoring, see "Linear-Speed Vertex Cache Optimisation"
+        constexpr int   FORSYTH_CACHE_SIZE  = 32;
+        constexpr float CACHE_DECAY_POWER   = 1.5f;
+        constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+        constexpr float VALENCE_BOOST_SCALE = 2.0f;
+        constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+        // bounding sphere around the vertices and normal cone of the triangles
+        Meshlet computeMeshletBounds(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                     const std::vector<unsigned int>& meshlet_vertices, const std::vector<unsigned int>& meshlet_triangles) {
+            Meshlet meshlet{};
+            glm::vec3 bounds_min(std::numeric_limits<float>::max());
+            glm::vec3 bounds_max(-std::numeric_limits<float>::max());
+            for (unsigned int v : meshlet_vertices) {
+                bounds_min = glm::min(bounds_min, vertices[v].position_);
+                bounds_max = glm::max(bounds_max, vertices[v].position_);
+            }
+            meshlet.center_ = (bounds_min + bounds_max) * 0.5f;
+            for (unsigned int v : meshlet_vertices)
+                meshlet.radius_ = std::max(meshlet.radius_, glm::length(vertices[v].position_ - meshlet.center_));
+
+            std::vector<glm::vec3> normals;
+            normals.reserve(meshlet_triangles.size());
+            glm::vec3 axis(0.0f);
+            for (unsigned int t : meshlet_triangles) {
+                const glm::vec3& p0 = vertices[indices[t * 3    ]].position_;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position_;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position_;
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float length = glm::length(normal);
+                // degenerate triangles never face anywhere
+                if (length <= 0.0f)
+                    continue;
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+
+            meshlet.cone_axis_   = glm::vec3(0.0f, 0.0f, 1.0f);
+            meshlet.cone_cutoff_ = 1.0f;
+            if (!normals.empty() && glm::length(axis) > 0.0f) {
+                axis = glm::normalize(axis);
+                float min_dot = 1.0f;
+                for (const glm::vec3& normal : normals)
+                    min_dot = std::min(min_dot, glm::dot(axis, normal));
+                // a spread of 90 degrees or more can't be culled as a whole
+                meshlet.cone_axis_ = axis;
+                if (min_dot > 0.0f)
+                    meshlet.cone_cutoff_ = std::sqrt(1.0f - min_dot * min_dot);
+            }
+            return meshlet;
+        }
+
+        float vertexScore(int cache_position, unsigned int remaining_triangles) {
+            // no triangle needs this vertex anymore
+            if (remaining_triangles == 0)
+                return -1.0f;
+
+            float score = 0.0f;
+            if (cache_position >= 0) {
+                // the last triangle's vertices get a fixed score so the next one isn't picked too greedily
+                if (cache_position < 3) {
+                    score = LAST_TRIANGLE_SCORE;
+                } else {
+                    const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                    score = std::pow(1.0f - (cache_position - 3) * scaler, CACHE_DECAY_POWER);
+                }
+            }
+            // boost vertices with few triangles left so lone triangles don't get stranded
+            score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -VALENCE_BOOST_POWER);
+            return score;
+        }
+    }
+
+    /// @brief merge duplicate vertices and remap the indices onto the survivors
+    /// @param vertices vertex buffer, compacted in place
+    /// @param indices index buffer referring to vertices
+    /// @param epsilon 0 for exact equality, otherwise the grid every float attribute is snapped to before comparing
+    /// @return number of vertices removed
+    size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float epsilon) {
+        static_assert(sizeof(Vertex) == 22 * 4, "Vertex is hashed and compared byte for byte, it can't have padding");
+        if (vertices.empty())
+            return 0;
+
+        // adding 0 folds -0 into +0 so they weld
+        auto snap = [epsilon](float value) {
+            return (epsilon > 0.0f ? std::round(value / epsilon) * epsilon : value) + 0.0f;
+        };
+        auto make_key = [&snap](const Vertex& vertex) {
+            Vertex key = vertex;
+            for (int i = 0; i < 3; i++) {
+                key.position_[i]  = snap(vertex.position_[i]);
+                key.normal_[i]    = snap(vertex.normal_[i]);
+                key.tangent_[i]   = snap(vertex.tangent_[i]);
+                key.bitangent_[i] = snap(vertex.bitangent_[i]);
+            }
+            for (int i = 0; i < 2; i++)
+                key.texCoords_[i] = snap(vertex.texCoords_[i]);
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+                key.weights_[i] = snap(vertex.weights_[i]);
+            return key;
+        };
+
+        // open addressing over the welded vertices, at most half full
+        size_t table_size = 1;
+        while (table_size < vertices.size() * 2)
+            table_size <<= 1;
+        constexpr unsigned int empty = ~0u;
+        std::vector<unsigned int> table(table_size, empty);
+        std::vector<Vertex> keys;
+        std::vector<Vertex> welded;
+        std::vector<unsigned int> remap(vertices.size());
+        keys.reserve(vertices.size());
+        welded.reserve(vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); i++) {
+            Vertex key = make_key(vertices[i]);
+            size_t slot = fnv1a64(&key, sizeof(key)) & (table_size - 1);
+            while (table[slot] != empty && std::memcmp(&keys[table[slot]], &key, sizeof(key)) != 0)
+                slot = (slot + 1) & (table_size - 1);
+
+            if (table[slot] == empty) {
+                table[slot] = static_cast<unsigned int>(welded.size());
+                keys.push_back(key);
+                // the first vertex of a group is kept unsnapped
+                welded.push_back(vertices[i]);
+            }
+            remap[i] = table[slot];
+        }
+
+        for (unsigned int& index : indices)
+            index = remap[index];
+        const size_t removed = vertices.size() - welded.size();
+        vertices.swap(welded);
+        return removed;
+    }
+
+    /// @brief simulate a FIFO post-transform cache over an index buffer
+    /// @param indices triangle list
+    /// @param vertex_count size of the vertex buffer the indices point into
+    /// @param cache_size simulated cache entries
+    /// @return ACMR and ATVR of the index order
+    VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertex_count, unsigned int cache_size) {
+        VertexCacheStatistics statistics;
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0 || vertex_count == 0)
+            return statistics;
+
+        FifoCache cache(vertex_count, cache_size);
+        std::vector<bool> referenced(vertex_count, false);
+        size_t misses = 0;
+        size_t unique_vertices = 0;
+        for (size_t i = 0; i < triangle_count * 3; i++) {
+            misses += cache.access(indices[i]);
+            if (!referenced[indices[i]]) {
+                referenced[indices[i]] = true;
+                unique_vertices++;
+            }
+        }
+
+        statistics.acmr_ = static_cast<float>(misses) / triangle_count;
+        statistics.atvr_ = static_cast<float>(misses) / unique_vertices;
+        return statistics;
+    }
+
+    void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertex_count) {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+            return;
+
+        // triangles adjacent to each vertex, the first remaining_[v] entries are the ones not emitted yet
+        std::vector<unsigned int> remaining(vertex_count, 0);
+        for (size_t i = 0; i < triangle_count * 3; i++)
+            remaining[indices[i]]++;
+        std::vector<unsigned int> offsets(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; v++)
+            offsets[v + 1] = offsets[v] + remaining[v];
+        std::vector<unsigned int> adjacency(triangle_count * 3);
+        {
+            std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t t = 0; t < triangle_count; t++)
+                for (size_t k = 0; k < 3; k++)
+                    adjacency[cursor[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+        }
+
+        std::vector<int>   cache_position(vertex_count, -1);
+        std::vector<float> vertex_score(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++)
+            vertex_score[v] = vertexScore(-1, remaining[v]);
+
+        auto triangle_score = [&indices, &vertex_score](size_t t) {
+            return vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+        };
+
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<unsigned int> output;
+        output.reserve(triangle_count * 3);
+
+        long long best_triangle = 0;
+        float best_score = triangle_score(0);
+        for (size_t t = 1; t < triangle_count; t++) {
+            float score = triangle_score(t);
+            if (score > best_score) {
+                best_score = score;
+                best_triangle = static_cast<long long>(t);
+            }
+        }
+
+        std::vector<unsigned int> cache;
+        std::vector<unsigned int> new_cache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        size_t next_unemitted = 0;
+
+        for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+            // nothing adjacent to the cache is left, continue with the next triangle in input order
+            if (best_triangle < 0) {
+                while (emitted[next_unemitted])
+                    next_unemitted++;
+                best_triangle = static_cast<long long>(next_unemitted);
+            }
+
+            const size_t t = static_cast<size_t>(best_triangle);
+            const unsigned int* triangle = &indices[t * 3];
+            emitted[t] = true;
+            output.insert(output.end(), triangle, triangle + 3);
+
+            // detach the triangle from its vertices
+            for (size_t k = 0; k < 3; k++) {
+                const unsigned int v = triangle[k];
+                unsigned int* begin = &adjacency[offsets[v]];
+                unsigned int* end   = begin + remaining[v];
+                unsigned int* it    = std::find(begin, end, static_cast<unsigned int>(t));
+                std::swap(*it, *(end - 1));
+                remaining[v]--;
+            }
+
+            // the triangle's vertices move to the front of the cache
+            new_cache.assign(triangle, triangle + 3);
+            for (unsigned int v : cache)
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    new_cache.push_back(v);
+            for (size_t i = 0; i < new_cache.size(); i++) {
+                const unsigned int v = new_cache[i];
+                cache_position[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+                vertex_score[v]   = vertexScore(cache_position[v], remaining[v]);
+            }
+            if (new_cache.size() > FORSYTH_CACHE_SIZE)
+                new_cache.resize(FORSYTH_CACHE_SIZE);
+            cache.swap(new_cache);
+
+            // the next triangle is the best one touching the cache
+            best_triangle = -1;
+            best_score    = -1.0f;
+            for (unsigned int v : cache) {
+                for (unsigned int i = 0; i < remaining[v]; i++) {
+                    const unsigned int candidate = adjacency[offsets[v] + i];
+                    float score = triangle_score(candidate);
+                    if (score > best_score) {
+                        best_score    = score;
+                        best_triangle = candidate;
+                    }
+                }
+            }
+        }
+
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold) {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count < 2)
+            return;
+
+        const VertexCacheStatistics input = analyzeVertexCache(indices, vertices.size());
+
+        // hard boundaries: the cache optimizer restarted from a cold cache
+        std::vector<size_t> hard_boundaries;
+        {
+            FifoCache cache(vertices.size(), VERTEX_CACHE_SIZE);
+            for (size_t t = 0; t < triangle_count; t++)
+                if (triangleMisses(cache, &indices[t * 3]) == 3 || t == 0)
+                    hard_boundaries.push_back(t);
+            hard_boundaries.push_back(triangle_count);
+        }
+
+        // soft boundaries: cut a hard cluster wherever restarting the cache keeps its ACMR under the threshold
+        std::vector<size_t> clusters;
+        for (size_t h = 0; h + 1 < hard_boundaries.size(); h++) {
+            const size_t begin = hard_boundaries[h];
+            const size_t end   = hard_boundaries[h + 1];
+
+            FifoCache cache(vertices.size(), VERTEX_CACHE_SIZE);
+            size_t cluster_misses = 0;
+            for (size_t t = begin; t < end; t++)
+                cluster_misses += triangleMisses(cache, &indices[t * 3]);
+            const float cluster_threshold = threshold * static_cast<float>(cluster_misses) / (end - begin);
+
+            cache.reset();
+            size_t start  = begin;
+            size_t misses = 0;
+            clusters.push_back(begin);
+            for (size_t t = begin; t < end; t++) {
+                misses += triangleMisses(cache, &indices[t * 3]);
+                if (t + 1 < end && static_cast<float>(misses) / (t + 1 - start) <= cluster_threshold) {
+                    clusters.push_back(t + 1);
+                    start  = t + 1;
+                    misses = 0;
+                    cache.reset();
+                }
+            }
+        }
+        clusters.push_back(triangle_count);
+
+        // clusters facing away from the mesh centre are likely occluders, draw them first
+        glm::vec3 mesh_centroid(0.0f);
+        for (const Vertex& vertex : vertices)
+            mesh_centroid += vertex.position_;
+        mesh_centroid /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+        const size_t cluster_count = clusters.size() - 1;
+        std::vector<float> sort_keys(cluster_count, 0.0f);
+        for (size_t c = 0; c < cluster_count; c++) {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+                const glm::vec3& p0 = vertices[indices[t * 3    ]].position_;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position_;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position_;
+                glm::vec3 face_normal = glm::cross(p1 - p0, p2 - p0);
+                float face_area = glm::length(face_normal);
+                centroid += (p0 + p1 + p2) * (face_area / 3.0f);
+                normal   += face_normal;
+                area     += face_area;
+            }
+            if (area > 0.0f && glm::length(normal) > 0.0f)
+                sort_keys[c] = glm::dot(centroid / area - mesh_centroid, glm::normalize(normal));
+        }
+
+        std::vector<size_t> order(cluster_count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sort_keys](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+        std::vector<unsigned int> output;
+        output.reserve(triangle_count * 3);
+        for (size_t c : order)
+            output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+        // keep the cache friendly order if sorting cost more than allowed
+        if (analyzeVertexCache(output, vertices.size()).acmr_ <= input.acmr_ * threshold)
+            std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+        constexpr unsigned int unused = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), unused);
+        std::vector<Vertex> output;
+        output.reserve(vertices.size());
+
+        for (unsigned int& index : indices) {
+            if (remap[index] == unused) {
+                remap[index] = static_cast<unsigned int>(output.size());
+                output.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(output);
+    }
+
+    /// @brief grow meshlets over triangle adjacency and reorder the index buffer so each one is a contiguous range
+    /// @param vertices vertex buffer
+    /// @param indices triangle list, meshlets are seeded in its current order so earlier triangles stay early
+    /// @return meshlets covering every triangle in order
+    std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+        std::vector<Meshlet> meshlets;
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+            return meshlets;
+
+        // triangles adjacent to each vertex
+        std::vector<unsigned int> offsets(vertices.size() + 1, 0);
+        for (size_t i = 0; i < triangle_count * 3; i++)
+            offsets[indices[i] + 1]++;
+        for (size_t v = 0; v < vertices.size(); v++)
+            offsets[v + 1] += offsets[v];
+        std::vector<unsigned int> adjacency(triangle_count * 3);
+        {
+            std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t t = 0; t < triangle_count; t++)
+                for (size_t k = 0; k < 3; k++)
+                    adjacency[cursor[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+        }
+
+        std::vector<bool>         emitted(triangle_count, false);
+        // vertex -> 1 + index of the last meshlet that used it
+        std::vector<uint32_t>     last_meshlet(vertices.size(), 0);
+        std::vector<unsigned int> meshlet_vertices;
+        std::vector<unsigned int> meshlet_triangles;
+        std::vector<unsigned int> output;
+        output.reserve(indices.size());
+        meshlet_vertices.reserve(MESHLET_MAX_VERTICES);
+        meshlet_triangles.reserve(MESHLET_MAX_TRIANGLES);
+
+        auto centroid = [&vertices, &indices](size_t t) {
+            return (vertices[indices[t * 3]].position_ + vertices[indices[t * 3 + 1]].position_ + 
+                    vertices[indices[t * 3 + 2]].position_) / 3.0f;
+        };
+
+        size_t next_seed = 0;
+        while (true) {
+            while (next_seed < triangle_count && emitted[next_seed])
+                next_seed++;
+            if (next_seed == triangle_count)
+                break;
+
+            const uint32_t stamp = static_cast<uint32_t>(meshlets.size() + 1);
+            auto new_vertex_count = [&indices, &last_meshlet, stamp](size_t t) {
+                return (last_meshlet[indices[t * 3]] != stamp) + (last_meshlet[indices[t * 3 + 1]] != stamp) + 
+                       (last_meshlet[indices[t * 3 + 2]] != stamp);
+            };
+
+            glm::vec3 centroid_sum(0.0f);
+            long long candidate = static_cast<long long>(next_seed);
+            while (candidate >= 0) {
+                const size_t t = static_cast<size_t>(candidate);
+                emitted[t] = true;
+                meshlet_triangles.push_back(static_cast<unsigned int>(t));
+                centroid_sum += centroid(t);
+                for (size_t k = 0; k < 3; k++) {
+                    const unsigned int v = indices[t * 3 + k];
+                    if (last_meshlet[v] != stamp) {
+                        last_meshlet[v] = stamp;
+                        meshlet_vertices.push_back(v);
+                    }
+                }
+                if (meshlet_triangles.size() == MESHLET_MAX_TRIANGLES)
+                    break;
+
+                // the adjacent triangle adding the fewest vertices, closest to the meshlet on ties
+                const glm::vec3 meshlet_centroid = centroid_sum / static_cast<float>(meshlet_triangles.size());
+                candidate = -1;
+                int   best_new_vertices = 4;
+                float best_distance     = std::numeric_limits<float>::max();
+                for (unsigned int v : meshlet_vertices) {
+                    for (unsigned int i = offsets[v]; i < offsets[v + 1]; i++) {
+                        const unsigned int neighbour = adjacency[i];
+                        if (emitted[neighbour])
+                            continue;
+                        const int new_vertices = new_vertex_count(neighbour);
+                        if (meshlet_vertices.size() + new_vertices > MESHLET_MAX_VERTICES || new_vertices > best_new_vertices)
+                            continue;
+                        const glm::vec3 offset = centroid(neighbour) - meshlet_centroid;
+                        const float distance = glm::dot(offset, offset);
+                        if (new_vertices < best_new_vertices || distance < best_distance) {
+                            best_new_vertices = new_vertices;
+                            best_distance     = distance;
+                            candidate         = neighbour;
+                        }
+                    }
+                }
+            }
+
+            Meshlet meshlet = computeMeshletBounds(vertices, indices, meshlet_vertices, meshlet_triangles);
+            meshlet.index_offset_ = static_cast<uint32_t>(output.size());
+            meshlet.index_count_  = static_cast<uint32_t>(meshlet_triangles.size() * 3);
+
+            // growth order isn't cache order, re-run the cache optimizer on the meshlet's local vertices
+            std::vector<unsigned int> local_indices;
+            local_indices.reserve(meshlet.index_count_);
+            for (unsigned int t : meshlet_triangles)
+                for (size_t k = 0; k < 3; k++) {
+                    const unsigned int v = indices[t * 3 + k];
+                    local_indices.push_back(static_cast<unsigned int>(
+                        std::find(meshlet_vertices.begin(), meshlet_vertices.end(), v) - meshlet_vertices.begin()));
+                }
+            optimizeVertexCache(local_indices, meshlet_vertices.size());
+            for (unsigned int local_index : local_indices)
+                output.push_back(meshlet_vertices[local_index]);
+            meshlets.push_back(meshlet);
+            meshlet_vertices.clear();
+            meshlet_triangles.clear();
+        }
+
+        indices.swap(output);
+        return meshlets;
+    }
+
+    void optimizeMesh(MeshData& mesh_data, const std::vector<float>& lod_ratios, float weld_epsilon) {
+        if (mesh_data.indices_.size() < 3)
+            return;
+
+        mesh_data.report_.cache_before_ = analyzeVertexCache(mesh_data.indices_, mesh_data.vertices_.size());
+        mesh_data.report_.vertices_removed_ = weldVertices(mesh_data.vertices_, mesh_data.indices_, weld_epsilon);
+        optimizeVertexCache(mesh_data.indices_, mesh_data.vertices_.size());
+        optimizeOverdraw(mesh_data.indices_, mesh_data.vertices_);
+        mesh_data.meshlets_ = buildMeshlets(mesh_data.vertices_, mesh_data.indices_);
+        mesh_data.report_.cache_after_ = analyzeVertexCache(mesh_data.indices_, mesh_data.vertices_.size());
+        // levels only use vertices of level 0, so fetch order stays driven by it
+        generateLods(mesh_data, lod_ratios);
+        optimizeVertexFetch(mesh_data.vertices_, mesh_data.indices_);
+    }
+}
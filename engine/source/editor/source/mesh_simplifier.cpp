@@ -0,0 +1,278 @@
+#include "editor/include/mesh_simplifier.h"
+#include "editor/include/hash.h"
+#include "editor/include/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace Hd2d {
+    namespace {
+        // symmetric 4x4 plane quadric (Garland/Heckbert), weight_ is the accumulated triangle area
+        struct Quadric {
+            double a00_ = 0.0, a01_ = 0.0, a02_ = 0.0, a11_ = 0.0, a12_ = 0.0, a22_ = 0.0;
+            double b0_  = 0.0, b1_  = 0.0, b2_  = 0.0;
+            double c_   = 0.0;
+            double weight_ = 0.0;
+
+            void addPlane(const glm::dvec3& normal, double distance, double weight) {
+                a00_ += weight * normal.x * normal.x;
+                a01_ += weight * normal.x * normal.y;
+                a02_ += weight * normal.x * normal.z;
+                a11_ += weight * normal.y * normal.y;
+                a12_ += weight * normal.y * normal.z;
+                a22_ += weight * normal.z * normal.z;
+                b0_  += weight * normal.x * distance;
+                b1_  += weight * normal.y * distance;
+                b2_  += weight * normal.z * distance;
+                c_   += weight * distance * distance;
+                weight_ += weight;
+            }
+
+            void add(const Quadric& other) {
+                a00_ += other.a00_; a01_ += other.a01_; a02_ += other.a02_;
+                a11_ += other.a11_; a12_ += other.a12_; a22_ += other.a22_;
+                b0_  += other.b0_;  b1_  += other.b1_;  b2_  += other.b2_;
+                c_   += other.c_;
+                weight_ += other.weight_;
+            }
+
+            // area weighted sum of squared distances from p to the planes
+            double evaluate(const glm::dvec3& p) const {
+                double error = a00_ * p.x * p.x + a11_ * p.y * p.y + a22_ * p.z * p.z +
+                               2.0 * (a01_ * p.x * p.y + a02_ * p.x * p.z + a12_ * p.y * p.z) +
+                               2.0 * (b0_ * p.x + b1_ * p.y + b2_ * p.z) + c_;
+                return std::max(error, 0.0);
+            }
+        };
+
+        struct Collapse {
+            unsigned int from_;
+            unsigned int to_;
+            double       cost_;
+        };
+
+        // every vertex mapped to the first vertex with the same position
+        std::vector<unsigned int> buildPositionRemap(const std::vector<Vertex>& vertices) {
+            size_t table_size = 1;
+            while (table_size < vertices.size() * 2)
+                table_size <<= 1;
+            constexpr unsigned int empty = ~0u;
+            std::vector<unsigned int> table(table_size, empty);
+            std::vector<unsigned int> remap(vertices.size());
+
+            for (size_t i = 0; i < vertices.size(); i++) {
+                const glm::vec3& position = vertices[i].position_;
+                size_t slot = fnv1a64(&position, sizeof(position)) & (table_size - 1);
+                while (table[slot] != empty && std::memcmp(&vertices[table[slot]].position_, &position, sizeof(position)) != 0)
+                    slot = (slot + 1) & (table_size - 1);
+                if (table[slot] == empty)
+                    table[slot] = static_cast<unsigned int>(i);
+                remap[i] = table[slot];
+            }
+            return remap;
+        }
+
+        uint64_t edgeKey(unsigned int a, unsigned int b) {
+            return (static_cast<uint64_t>(a) << 32) | b;
+        }
+    }
+
+    /// @brief simplify a triangle list down to target_index_count indices by collapsing edges
+    /// @param vertices vertex buffer, shared by the result
+    /// @param indices triangle list to simplify
+    /// @param target_index_count index count to stop at, may not be reached when too many vertices are locked
+    /// @param result_error largest collapse error as a model space distance
+    /// @return simplified triangle list
+    std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                           size_t target_index_count, float& result_error) {
+        result_error = 0.0f;
+        std::vector<unsigned int> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+        if (result.size() <= target_index_count || vertices.empty())
+            return result;
+
+        const size_t vertex_count = vertices.size();
+        const std::vector<unsigned int> position_remap = buildPositionRemap(vertices);
+        auto position = [&vertices](unsigned int v) { return glm::dvec3(vertices[v].position_); };
+
+        // attribute seams share a position between several vertices, moving one would tear the mesh
+        std::vector<bool> locked(vertex_count, false);
+        for (size_t v = 0; v < vertex_count; v++)
+            if (position_remap[v] != v)
+                locked[v] = locked[position_remap[v]] = true;
+
+        // border edges have no opposite half edge, their vertices keep the silhouette in place
+        {
+            std::vector<uint64_t> edges;
+            edges.reserve(result.size());
+            for (size_t i = 0; i < result.size(); i += 3)
+                for (size_t k = 0; k < 3; k++)
+                    edges.push_back(edgeKey(position_remap[result[i + k]], position_remap[result[i + (k + 1) % 3]]));
+            std::sort(edges.begin(), edges.end());
+            for (uint64_t edge : edges) {
+                const unsigned int a = static_cast<unsigned int>(edge >> 32);
+                const unsigned int b = static_cast<unsigned int>(edge & 0xFFFFFFFFu);
+                if (!std::binary_search(edges.begin(), edges.end(), edgeKey(b, a)))
+                    locked[a] = locked[b] = true;
+            }
+        }
+        auto is_locked = [&locked, &position_remap](unsigned int v) { return locked[position_remap[v]]; };
+
+        std::vector<Quadric> quadrics(vertex_count);
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const glm::dvec3 p0 = position(result[i]);
+            glm::dvec3 normal = glm::cross(position(result[i + 1]) - p0, position(result[i + 2]) - p0);
+            const double double_area = glm::length(normal);
+            if (double_area <= 0.0)
+                continue;
+            normal /= double_area;
+            for (size_t k = 0; k < 3; k++)
+                quadrics[position_remap[result[i + k]]].addPlane(normal, -glm::dot(normal, p0), double_area * 0.5);
+        }
+
+        std::vector<unsigned int> collapse_remap(vertex_count);
+        std::vector<bool>         touched(vertex_count);
+        std::vector<unsigned int> offsets(vertex_count + 1);
+        std::vector<unsigned int> adjacency;
+        std::vector<Collapse>     collapses;
+        double max_error = 0.0;
+
+        // a pass picks the cheapest independent collapses, so fans around a moving vertex stay valid
+        while (result.size() > target_index_count) {
+            const size_t triangle_count = result.size() / 3;
+
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (unsigned int v : result)
+                offsets[v + 1]++;
+            for (size_t v = 0; v < vertex_count; v++)
+                offsets[v + 1] += offsets[v];
+            adjacency.resize(result.size());
+            {
+                std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < result.size(); i++)
+                    adjacency[cursor[result[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (size_t k = 0; k < 3; k++) {
+                    const unsigned int a = result[i + k];
+                    const unsigned int b = result[i + (k + 1) % 3];
+                    if (position_remap[a] == position_remap[b])
+                        continue;
+                    if (!is_locked(a))
+                        collapses.push_back(Collapse{a, b, quadrics[position_remap[a]].evaluate(position(b))});
+                    if (!is_locked(b))
+                        collapses.push_back(Collapse{b, a, quadrics[position_remap[b]].evaluate(position(a))});
+                }
+            }
+            if (collapses.empty())
+                break;
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.cost_ < r.cost_; });
+
+            // moving from onto to must not turn any surviving triangle of its fan over
+            auto flips = [&](unsigned int from, unsigned int to) {
+                const glm::dvec3 target = position(to);
+                for (unsigned int i = offsets[from]; i < offsets[from + 1]; i++) {
+                    const unsigned int* triangle = &result[adjacency[i] * 3];
+                    glm::dvec3 before[3];
+                    bool degenerates = false;
+                    for (size_t k = 0; k < 3; k++) {
+                        degenerates |= position_remap[triangle[k]] == position_remap[to];
+                        before[k] = position(triangle[k]);
+                    }
+                    if (degenerates)
+                        continue;
+                    glm::dvec3 after[3] = {before[0], before[1], before[2]};
+                    for (size_t k = 0; k < 3; k++)
+                        if (triangle[k] == from)
+                            after[k] = target;
+                    const glm::dvec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    const glm::dvec3 normal_after  = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    if (glm::dot(normal_before, normal_after) <= 0.0)
+                        return true;
+                }
+                return false;
+            };
+
+            std::iota(collapse_remap.begin(), collapse_remap.end(), 0u);
+            std::fill(touched.begin(), touched.end(), false);
+            const size_t triangles_to_remove = triangle_count - target_index_count / 3;
+            size_t triangles_removed = 0;
+            size_t collapse_count    = 0;
+            for (const Collapse& collapse : collapses) {
+                if (triangles_removed >= triangles_to_remove)
+                    break;
+                if (touched[collapse.from_] || touched[collapse.to_] || flips(collapse.from_, collapse.to_))
+                    continue;
+
+                const Quadric& from_quadric = quadrics[position_remap[collapse.from_]];
+                max_error = std::max(max_error, collapse.cost_ / std::max(from_quadric.weight_, 1e-12));
+                quadrics[position_remap[collapse.to_]].add(from_quadric);
+                collapse_remap[collapse.from_] = collapse.to_;
+                collapse_count++;
+
+                touched[collapse.to_] = true;
+                for (unsigned int i = offsets[collapse.from_]; i < offsets[collapse.from_ + 1]; i++) {
+                    const unsigned int* triangle = &result[adjacency[i] * 3];
+                    bool degenerates = false;
+                    for (size_t k = 0; k < 3; k++) {
+                        touched[triangle[k]] = true;
+                        degenerates |= position_remap[triangle[k]] == position_remap[collapse.to_];
+                    }
+                    triangles_removed += degenerates;
+                }
+            }
+            if (collapse_count == 0)
+                break;
+
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                const unsigned int a = collapse_remap[result[i]];
+                const unsigned int b = collapse_remap[result[i + 1]];
+                const unsigned int c = collapse_remap[result[i + 2]];
+                if (position_remap[a] == position_remap[b] || position_remap[b] == position_remap[c] ||
+                    position_remap[a] == position_remap[c])
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        result_error = static_cast<float>(std::sqrt(max_error));
+        return result;
+    }
+
+    void generateLods(MeshData& mesh_data, const std::vector<float>& lod_ratios) {
+        std::vector<unsigned int>& indices = mesh_data.indices_;
+        mesh_data.lods_.clear();
+        mesh_data.lods_.push_back(MeshLod{0, static_cast<uint32_t>(indices.size()), 0.0f});
+
+        const size_t base_triangle_count = indices.size() / 3;
+        std::vector<unsigned int> previous(indices);
+        float error = 0.0f;
+        for (float ratio : lod_ratios) {
+            if (ratio >= 1.0f)
+                continue;
+            const size_t target_index_count = static_cast<size_t>(base_triangle_count * ratio) * 3;
+            if (target_index_count == 0)
+                break;
+
+            // each level starts from the previous one, the errors add up to a bound against the full mesh
+            float level_error = 0.0f;
+            std::vector<unsigned int> level = simplifyMesh(mesh_data.vertices_, previous, target_index_count, level_error);
+            if (level.empty() || level.size() * 10 > previous.size() * 9)
+                break;
+            optimizeVertexCache(level, mesh_data.vertices_.size());
+            error += level_error;
+
+            mesh_data.lods_.push_back(MeshLod{static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(level.size()), error});
+            indices.insert(indices.end(), level.begin(), level.end());
+            previous.swap(level);
+        }
+    }
+}
@@ -1,55 +1,332 @@
 #include "editor/include/model.h"
+#include "editor/include/animation_compression.h"
+#include "editor/include/asset_database.h"
+#include "editor/include/hash.h"
+#include "editor/include/mesh_optimizer.h"
+#include "editor/include/texture_cache.h"
+#include "editor/include/texture_cook.h"
+#include "editor/include/texture_streamer.h"
+#include "editor/include/thread_pool.h"
+#include "editor/include/vertex_format.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <utility>
+
+#include <glm/gtc/type_ptr.hpp>
 
 namespace Hd2d {
-    Model::Model(std::string_view path) {
+    static constexpr UniformId MODEL_UNIFORM{"model"};
+    static constexpr UniformId NORMAL_MATRIX_UNIFORM{"normalMatrix"};
+
+    /// @brief every file Assimp reads for a model: the model itself and, for obj, its material libraries
+    /// @param path model file path
+    /// @return dependencies for the asset database, the model first
+    static std::vector<std::string> getModelDependencies(std::string_view path) {
+        std::vector<std::string> dependencies = {std::string{path}};
+        const std::filesystem::path model_path{path};
+        if (model_path.extension() != ".obj")
+            return dependencies;
+        std::ifstream model_file(model_path);
+        std::string   line;
+        while (std::getline(model_file, line))
+            if (line.compare(0, 7, "mtllib ") == 0) {
+                const size_t end = line.find_last_not_of(" \t\r");
+                dependencies.push_back((model_path.parent_path() / line.substr(7, end - 6)).generic_string());
+            }
+        return dependencies;
+    }
+
+    Model::Model(std::string_view path, VertexLayout layout, MeshResidency residency, std::vector<float> lod_ratios,
+                 std::shared_ptr<GeometryBuffer> geometry) : 
+                 geometry_{std::move(geometry)}, layout_{layout}, residency_{residency}, lod_ratios_{std::move(lod_ratios)} {
+        if (geometry_ != nullptr && geometry_->getLayout() != layout_) {
+            std::cout << "Error::Model::Geometry_Layout_Mismatch " << path << std::endl;
+            geometry_.reset();
+        }
+        if (geometry_ == nullptr)
+            geometry_ = GeometryBuffer::create(layout_);
         loadModel(path);
     }
 
+    size_t Model::getCpuBytes() const noexcept {
+        size_t cpu_bytes = nodes_.capacity() * sizeof(ModelNode) + import_reports_.capacity() * sizeof(MeshImportReport);
+        for(const Mesh& mesh : meshes_)
+            cpu_bytes += mesh.getCpuBytes();
+        return cpu_bytes;
+    }
+
+    std::vector<std::string> Model::getShaderDefines() const {
+        std::vector<std::string> defines = Hd2d::getShaderDefines(layout_);
+        if (skeleton_ != nullptr)
+            defines.push_back("HD2D_SKINNED");
+        return defines;
+    }
+
     void Model::loadModel(std::string_view path) {
+        // retrieve the directory path of the filepath
+        directory_ = std::string{path.substr(0, path.find_last_of('/'))};
+
+        // a cooked file made from the same source content skips Assimp entirely. the asset database hashes the
+        // source only when it was touched and also tracks the material libraries, which the cooked header can't
+        AssetDatabase&    asset_database = AssetDatabase::getInstance();
+        const std::string cooked_path    = std::string{path} + std::string{COOKED_MODEL_EXTENSION};
+        const uint64_t    source_hash    = asset_database.getSourceHash(path);
+        const bool        recorded       = asset_database.isRecorded(cooked_path);
+        if (!recorded || asset_database.isUpToDate(cooked_path, COOKED_MODEL_VERSION))
+        {
+            if (std::shared_ptr<CookedModel> cooked_model = CookedModel::open(cooked_path, source_hash, layout_, lod_ratios_))
+            {
+                // cooked before the database knew it, trust the header's source hash once
+                if (!recorded)
+                    asset_database.record(cooked_path, getModelDependencies(path), COOKED_MODEL_VERSION, 0);
+                loadCookedModel(*cooked_model);
+                return;
+            }
+        }
+        importModel(path, cooked_path, source_hash);
+    }
+
+    void Model::loadCookedModel(const CookedModel& cooked_model) {
+        nodes_    = cooked_model.getNodes();
+        skeleton_ = cooked_model.getSkeleton();
+        clips_    = cooked_model.getClips();
+
+        std::vector<CookedMeshView> mesh_views;
+        mesh_views.reserve(cooked_model.getMeshCount());
+        TextureDecodes decodes;
+        for(size_t i = 0; i < cooked_model.getMeshCount(); i++)
+        {
+            mesh_views.push_back(cooked_model.getMesh(i));
+            startTextureDecodes(mesh_views.back().textures_, decodes);
+        }
+        uploadTextures(decodes);
+
+        // vertex and index streams go to the GPU straight from the mapping
+        std::vector<VertexStreamView> vertex_streams;
+        std::vector<IndexStreamView>  index_streams;
+        for(const CookedMeshView& mesh_view : mesh_views)
+        {
+            vertex_streams.push_back(mesh_view.vertex_streams_);
+            index_streams.push_back(mesh_view.index_stream_);
+        }
+        reserveGeometry(vertex_streams, index_streams);
+
+        meshes_.reserve(meshes_.size() + mesh_views.size());
+        for(CookedMeshView& mesh_view : mesh_views)
+            meshes_.emplace_back(mesh_view.vertex_streams_, mesh_view.index_stream_, resolveTextures(mesh_view.textures_), 
+                                 residency_, std::move(mesh_view.meshlets_), std::move(mesh_view.lods_), geometry_,
+                                 &mesh_view.bounds_);
+        computeBounds();
+    }
+
+    void Model::importModel(std::string_view path, const std::string& cooked_path, uint64_t source_hash) {
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(std::string{path}, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(std::string{path}, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_LimitBoneWeights);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory_ = path.substr(0, path.find_last_of('/'));
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        // flatten ASSIMP's node tree, meshes keep the order of the recursive walk
+        std::vector<const aiMesh*> scene_meshes;
+        processNode(scene->mRootNode, scene, -1, scene_meshes);
+        // bones and clips refer to nodes by name, resolve them once the hierarchy is flat
+        std::vector<std::vector<int>> bone_ids;
+        processSkeleton(scene_meshes, bone_ids);
+        processAnimations(scene);
+
+        // texture references are cheap to gather, do it first so decoding overlaps the mesh work
+        std::vector<MeshData> mesh_datas(scene_meshes.size());
+        TextureDecodes decodes;
+        for(size_t i = 0; i < scene_meshes.size(); i++)
+        {
+            processMaterial(scene->mMaterials[scene_meshes[i]->mMaterialIndex], mesh_datas[i].textures_);
+            startTextureDecodes(mesh_datas[i].textures_, decodes);
+        }
+
+        // convert every aiMesh into vertex/index arrays on the worker pool
+        ThreadPool& pool = ThreadPool::getInstance();
+        const VertexLayout layout = layout_;
+        pool.parallelFor(scene_meshes.size(), [&scene_meshes, &bone_ids, &mesh_datas, layout, this](size_t i) {
+            processMesh(scene_meshes[i], bone_ids[i], mesh_datas[i]);
+            MeshData& mesh_data = mesh_datas[i];
+            optimizeMesh(mesh_data, lod_ratios_);
+            packVertexStreams(mesh_data, layout);
+            packIndexStream(mesh_data);
+            mesh_data.bounds_ = computeMeshBounds(mesh_data.getVertexStreams());
+            // indices_ has the coarser levels appended, those are bytes added, not saved
+            const size_t base_index_count = mesh_data.lods_.empty() ? mesh_data.indices_.size() : mesh_data.lods_[0].index_count_;
+            mesh_data.report_.bytes_saved_ = mesh_data.report_.vertices_removed_ * getVertexStride(layout) +
+                                             base_index_count * (sizeof(unsigned int) - getIndexSize(mesh_data.index_type_));
+        });
+        import_reports_.clear();
+        for(const MeshData& mesh_data : mesh_datas)
+            import_reports_.push_back(mesh_data.report_);
+
+        // cook in the background while the textures upload
+        std::future<bool> cooked = pool.submit([&cooked_path, source_hash, layout, &mesh_datas, this]() {
+            return CookedModel::write(cooked_path, source_hash, layout, lod_ratios_, mesh_datas, nodes_, skeleton_.get(), clips_);
+        });
+
+        uploadTextures(decodes);
+
+        // meshes take their data by move, so the writer has to be done reading it
+        pool.wait(cooked);
+        if (cooked.get())
+            AssetDatabase::getInstance().record(cooked_path, getModelDependencies(path), COOKED_MODEL_VERSION, 0);
+
+        std::vector<VertexStreamView> vertex_streams;
+        std::vector<IndexStreamView>  index_streams;
+        for(const MeshData& mesh_data : mesh_datas)
+        {
+            vertex_streams.push_back(mesh_data.getVertexStreams());
+            index_streams.push_back(mesh_data.getIndexStream());
+        }
+        reserveGeometry(vertex_streams, index_streams);
+
+        meshes_.reserve(meshes_.size() + mesh_datas.size());
+        for(MeshData& mesh_data : mesh_datas)
+        {
+            std::vector<Texture2D> textures = resolveTextures(mesh_data.textures_);
+            meshes_.emplace_back(std::move(mesh_data), std::move(textures), residency_, geometry_);
+        }
+        computeBounds();
     }
 
-    void Model::processNode(aiNode *node, const aiScene *scene) {
-        // process each mesh located at the current node
+    void Model::processNode(const aiNode *node, const aiScene *scene, int parent, std::vector<const aiMesh*>& scene_meshes) {
+        // keep the node so the hierarchy survives cooking, assimp matrices are row major
+        ModelNode model_node;
+        model_node.name_       = node->mName.C_Str();
+        model_node.transform_  = glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+        model_node.parent_     = parent;
+        model_node.first_mesh_ = static_cast<unsigned int>(scene_meshes.size());
+        model_node.mesh_count_ = node->mNumMeshes;
+        const int node_index   = static_cast<int>(nodes_.size());
+        nodes_.push_back(model_node);
+
+        // collect each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            std::shared_ptr<Mesh> our_mesh = processMesh(mesh, scene);
-            meshes_.push_back(*our_mesh);
+            scene_meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+        // after we've collected all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, node_index, scene_meshes);
+        }
+    }
+
+    void Model::processSkeleton(const std::vector<const aiMesh*>& scene_meshes, std::vector<std::vector<int>>& bone_ids) {
+        std::unordered_map<std::string, uint32_t> node_indices;
+        for(size_t i = 0; i < nodes_.size(); i++)
+            node_indices.emplace(nodes_[i].name_, static_cast<uint32_t>(i));
+
+        // meshes skinned to the same node share its bone
+        std::unordered_map<std::string, int> bone_indices;
+        std::vector<uint32_t>  bone_nodes;
+        std::vector<glm::mat4> bone_offsets;
+        bone_ids.assign(scene_meshes.size(), {});
+        for(size_t i = 0; i < scene_meshes.size(); i++)
+        {
+            const aiMesh* mesh = scene_meshes[i];
+            bone_ids[i].assign(mesh->mNumBones, -1);
+            for(unsigned int b = 0; b < mesh->mNumBones; b++)
+            {
+                const aiBone* bone = mesh->mBones[b];
+                const std::string name = bone->mName.C_Str();
+                auto bone_it = bone_indices.find(name);
+                if (bone_it != bone_indices.end()) {
+                    bone_ids[i][b] = bone_it->second;
+                    continue;
+                }
+                auto node_it = node_indices.find(name);
+                if (node_it == node_indices.end()) {
+                    std::cout << "Error::Model::Bone_Without_Node " << name << std::endl;
+                    continue;
+                }
+                if (bone_nodes.size() >= MAX_SKELETON_BONES) {
+                    std::cout << "Error::Model::Too_Many_Bones " << name << std::endl;
+                    continue;
+                }
+                bone_ids[i][b] = static_cast<int>(bone_nodes.size());
+                bone_indices.emplace(name, bone_ids[i][b]);
+                bone_nodes.push_back(node_it->second);
+                // assimp matrices are row major
+                bone_offsets.push_back(glm::transpose(glm::make_mat4(&bone->mOffsetMatrix.a1)));
+            }
+        }
+        skeleton_ = Skeleton::create(nodes_, std::move(bone_nodes), std::move(bone_offsets));
+    }
+
+    void Model::processAnimations(const aiScene *scene) {
+        std::unordered_map<std::string, uint32_t> node_indices;
+        for(size_t i = 0; i < nodes_.size(); i++)
+            node_indices.emplace(nodes_[i].name_, static_cast<uint32_t>(i));
+
+        for(unsigned int a = 0; a < scene->mNumAnimations; a++)
+        {
+            const aiAnimation* animation = scene->mAnimations[a];
+            // keys are in ticks, converted to seconds once here
+            const double ticks_per_second = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+            auto seconds = [ticks_per_second](double ticks) { return static_cast<float>(ticks / ticks_per_second); };
+
+            std::vector<RawAnimationChannel> channels;
+            channels.reserve(animation->mNumChannels);
+            for(unsigned int c = 0; c < animation->mNumChannels; c++)
+            {
+                const aiNodeAnim* node_anim = animation->mChannels[c];
+                auto node_it = node_indices.find(node_anim->mNodeName.C_Str());
+                if (node_it == node_indices.end())
+                    continue;
+
+                RawAnimationChannel channel;
+                channel.node_ = node_it->second;
+                for(unsigned int k = 0; k < node_anim->mNumPositionKeys; k++)
+                {
+                    const aiVectorKey& key = node_anim->mPositionKeys[k];
+                    channel.position_times_.push_back(seconds(key.mTime));
+                    channel.positions_.emplace_back(key.mValue.x, key.mValue.y, key.mValue.z);
+                }
+                for(unsigned int k = 0; k < node_anim->mNumRotationKeys; k++)
+                {
+                    const aiQuatKey& key = node_anim->mRotationKeys[k];
+                    channel.rotation_times_.push_back(seconds(key.mTime));
+                    channel.rotations_.emplace_back(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z);
+                }
+                for(unsigned int k = 0; k < node_anim->mNumScalingKeys; k++)
+                {
+                    const aiVectorKey& key = node_anim->mScalingKeys[k];
+                    channel.scale_times_.push_back(seconds(key.mTime));
+                    channel.scales_.emplace_back(key.mValue.x, key.mValue.y, key.mValue.z);
+                }
+                channels.push_back(std::move(channel));
+            }
+
+            std::shared_ptr<AnimationClip> clip = compressAnimationClip(animation->mName.C_Str(), seconds(animation->mDuration), channels);
+            clips_.push_back(std::move(clip));
         }
     }
 
-    std::shared_ptr<Mesh> Model::processMesh(aiMesh *mesh, const aiScene *scene) {
+    void Model::processMesh(const aiMesh *mesh, const std::vector<int>& bone_ids, MeshData& mesh_data) {
         // data to fill
-        std::shared_ptr<std::vector<Vertex>>       vertices     = std::make_shared<std::vector<Vertex>>();
-        std::shared_ptr<std::vector<unsigned int>> indices      = std::make_shared<std::vector<unsigned int>>();
-        std::shared_ptr<std::vector<Texture2D>>    all_textures = std::make_shared<std::vector<Texture2D>>();;
+        std::vector<Vertex>&       vertices = mesh_data.vertices_;
+        std::vector<unsigned int>& indices  = mesh_data.indices_;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex{};
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -87,18 +364,56 @@ namespace Hd2d {
             else
                 vertex.texCoords_ = glm::vec2(0.0f, 0.0f);
 
-            vertices->push_back(vertex);
+            vertices.push_back(vertex);
+        }
+        // keep the MAX_BONE_INFLUENCE strongest influences of every vertex, strongest first
+        for(unsigned int b = 0; b < mesh->mNumBones; b++)
+        {
+            if (bone_ids[b] < 0)
+                continue;
+            const aiBone* bone = mesh->mBones[b];
+            for(unsigned int w = 0; w < bone->mNumWeights; w++)
+            {
+                const aiVertexWeight& weight = bone->mWeights[w];
+                if (weight.mVertexId >= vertices.size() || weight.mWeight <= 0.0f)
+                    continue;
+                Vertex& vertex = vertices[weight.mVertexId];
+                int slot = MAX_BONE_INFLUENCE;
+                while (slot > 0 && vertex.weights_[slot - 1] < weight.mWeight)
+                    slot--;
+                if (slot == MAX_BONE_INFLUENCE)
+                    continue;
+                for(int k = MAX_BONE_INFLUENCE - 1; k > slot; k--)
+                {
+                    vertex.boneIDs_[k] = vertex.boneIDs_[k - 1];
+                    vertex.weights_[k] = vertex.weights_[k - 1];
+                }
+                vertex.boneIDs_[slot] = bone_ids[b];
+                vertex.weights_[slot] = weight.mWeight;
+            }
         }
+        if (mesh->mNumBones > 0)
+            for(Vertex& vertex : vertices)
+            {
+                float total = 0.0f;
+                for(float weight : vertex.weights_)
+                    total += weight;
+                if (total > 0.0f)
+                    for(float& weight : vertex.weights_)
+                        weight /= total;
+            }
+
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices->push_back(face.mIndices[j]);        
+                indices.push_back(face.mIndices[j]);        
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
+    }
+
+    void Model::processMaterial(const aiMaterial *material, std::vector<TextureRef>& textures) {
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
         // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
         // Same applies to other texture as the following list summarizes:
@@ -107,62 +422,320 @@ namespace Hd2d {
         // normal: texture_normalN
 
         // 1. diffuse maps
-        std::shared_ptr<std::vector<Texture2D>> diffuseMaps = 
-        loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        all_textures->insert(all_textures->end(), diffuseMaps->begin(), diffuseMaps->end());
+        loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
         // 2. specular maps
-        std::shared_ptr<std::vector<Texture2D>> specularMaps =
-        loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        all_textures->insert(all_textures->end(), specularMaps->begin(), specularMaps->end());
+        loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
         // 3. normal maps
-        std::shared_ptr<std::vector<Texture2D>> normalMaps =
-        loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        all_textures->insert(all_textures->end(), normalMaps->begin(), normalMaps->end());
+        loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
         // 4. height maps
-        std::shared_ptr<std::vector<Texture2D>> heightMaps =
-        loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        all_textures->insert(all_textures->end(), heightMaps->begin(), heightMaps->end());  
-        // return a mesh object created from the extracted mesh data
-        return std::make_shared<Mesh>(*vertices, *indices, *all_textures);
+        loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
     }
 
-    std::shared_ptr<std::vector<Texture2D>> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName) {
-        std::shared_ptr<std::vector<Texture2D>> textures = std::make_shared<std::vector<Texture2D>>();
+    void Model::loadMaterialTextures(const aiMaterial *mat, aiTextureType type, std::string typeName, std::vector<TextureRef>& textures) {
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded_.size(); j++)
-            {
-                if(std::strcmp(textures_loaded_[j].getPath().data(), str.C_Str()) == 0)
-                {
-                    textures->push_back(textures_loaded_[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
+            textures.push_back(TextureRef{typeName, str.C_Str()});
+        }
+    }
+
+    void Model::startTextureDecodes(const std::vector<TextureRef>& texture_refs, TextureDecodes& decodes) const {
+        for(const TextureRef& texture_ref : texture_refs)
+        {
+            // each file is loaded once per model
+            if(textures_loaded_.count(texture_ref.path_) != 0 || decodes.count(texture_ref.path_) != 0)
+                continue;
+            std::string texture_path = directory_ + "/" + texture_ref.path_;
+            // only diffuse maps hold colors, normal, height and specular maps are filtered as plain data
+            const bool srgb = texture_ref.type_ == "texture_diffuse";
+            decodes.emplace(texture_ref.path_, ThreadPool::getInstance().submit([texture_path, srgb]() {
+                TextureLoad load;
+                load.normalized_path_ = TextureCache::normalizePath(texture_path);
+                load.srgb_ = srgb;
+                load.cached_ = TextureCache::getInstance().findByPath(load.normalized_path_);
+                if (load.cached_)
+                    return load;
+                // cooked by Hd2dTexCook from this very content, its mips stream in on demand and nothing needs decoding.
+                // a stale one, or one filtered for the other color space, is left for the next cook and the source decoded instead
+                std::string cooked_path = getCookedTexturePath(load.normalized_path_);
+                if (AssetDatabase::getInstance().isUpToDate(cooked_path, TEXTURE_COOKER_VERSION) &&
+                    Texture2D::isCptFileExist(cooked_path, srgb)) {
+                    load.cooked_path_ = std::move(cooked_path);
+                    return load;
+                }
+                decodeTextureSource(load);
+                return load;
+            }));
+        }
+    }
+
+    void Model::decodeTextureSource(TextureLoad& load) {
+        TextureCache& texture_cache = TextureCache::getInstance();
+        std::shared_ptr<MappedFile> file = MappedFile::open(load.normalized_path_);
+        if (!file) {
+            std::cout << "Error::Texture::IMAGE_File_Not_Successfully_Read " << load.normalized_path_ << std::endl;
+            return;
+        }
+        // same pixels under another path, e.g. an atlas shared by several props
+        load.content_hash_ = fnv1a64(file->getData(), file->getSize());
+        load.cached_ = texture_cache.findByHash(load.content_hash_);
+        if (load.cached_) {
+            texture_cache.alias(load.normalized_path_, load.cached_);
+            return;
+        }
+        load.image_ = Texture2D::decodeImage(file->getData(), file->getSize());
+        Texture2D::prepareImage(load.image_, load.srgb_);
+    }
+
+    void Model::uploadTextures(TextureDecodes& decodes) {
+        TextureCache& texture_cache = TextureCache::getInstance();
+        ThreadPool&   pool          = ThreadPool::getInstance();
+        std::vector<std::string>              texture_paths;
+        std::vector<std::future<TextureLoad>> loads;
+        texture_paths.reserve(decodes.size());
+        loads.reserve(decodes.size());
+        for(auto& [texture_path, decode] : decodes)
+        {
+            texture_paths.push_back(texture_path);
+            loads.push_back(std::move(decode));
+        }
+        decodes.clear();
+
+        // upload in completion order, the GL thread works while the rest are still decoding
+        for(size_t i = pool.waitAny(loads); i < loads.size(); i = pool.waitAny(loads))
+        {
+            const std::string& texture_path = texture_paths[i];
+            TextureLoad load = loads[i].get();
+
+            // another model may have uploaded the same content while this one was decoding
+            std::shared_ptr<Texture2D> texture = load.cached_;
+            if (!texture && load.content_hash_ != 0) {
+                texture = texture_cache.findByHash(load.content_hash_);
+                if (texture)
+                    texture_cache.alias(load.normalized_path_, texture);
+            }
+            if (!texture && !load.cooked_path_.empty()) {
+                texture = TextureStreamer::getInstance().load(load.cooked_path_);
+                if (texture)
+                    texture_cache.alias(load.normalized_path_, texture);
+                else {
+                    // e.g. a block format this context can't sample, the source is decoded here instead
+                    decodeTextureSource(load);
+                    texture = load.cached_;
                 }
             }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                std::string texture_path = std::string{directory_} + "/" + str.C_Str();
-                std::shared_ptr<Texture2D> texture = Texture2D::loadFromFile(texture_path);
-                texture->setTextureType(typeName);
-                texture->setPath(str.C_Str());
-                textures->push_back(*texture);
-                textures_loaded_.push_back(*texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+            if (!texture) {
+                texture = Texture2D::uploadImage(load.image_);
+                if (load.image_.isValid())
+                    texture = texture_cache.insert(load.normalized_path_, load.content_hash_, texture);
             }
+            textures_loaded_[texture_path] = texture;
         }
-        return textures; 
     }
 
-    void Model::draw(ShaderProgram& shader_program) {
-        for(unsigned int i = 0; i < meshes_.size(); i++)
-            meshes_[i].draw(shader_program);
+    std::vector<Texture2D> Model::resolveTextures(const std::vector<TextureRef>& texture_refs) {
+        std::vector<Texture2D> textures;
+        textures.reserve(texture_refs.size());
+        for(const TextureRef& texture_ref : texture_refs)
+        {
+            auto it = textures_loaded_.find(texture_ref.path_);
+            if(it == textures_loaded_.end())
+                continue;
+            textures.push_back(*it->second);
+            textures.back().setTextureType(texture_ref.type_);
+        }
+        return textures;
+    }
+
+    void Model::reserveGeometry(const std::vector<VertexStreamView>& vertex_streams, const std::vector<IndexStreamView>& index_streams) {
+        size_t vertex_count = geometry_->getVertexCount();
+        size_t index_bytes  = geometry_->getIndexBytes();
+        for(size_t i = 0; i < vertex_streams.size(); i++)
+        {
+            vertex_count += vertex_streams[i].vertex_count_;
+            // plus the padding aligning each range to its index size
+            index_bytes  += index_streams[i].index_count_ * getIndexSize(index_streams[i].type_) + sizeof(uint32_t);
+        }
+        geometry_->reserve(vertex_count, index_bytes);
+    }
+
+    void Model::computeBounds() {
+        // rest transform of every node, nodes_ is a pre-order walk
+        std::vector<glm::mat4> node_transforms(nodes_.size());
+        for(size_t i = 0; i < nodes_.size(); i++)
+            node_transforms[i] = nodes_[i].parent_ >= 0 ? node_transforms[nodes_[i].parent_] * nodes_[i].transform_ 
+                                                         : nodes_[i].transform_;
+
+        // skinned meshes are already in model space, like in draw
+        std::vector<glm::mat4>      mesh_transforms(meshes_.size(), glm::mat4(1.0f));
+        std::vector<Aabb>           boxes(meshes_.size());
+        std::vector<BoundingSphere> spheres(meshes_.size());
+        for(size_t i = 0; i < nodes_.size(); i++)
+            for(unsigned int mesh = nodes_[i].first_mesh_; mesh < nodes_[i].first_mesh_ + nodes_[i].mesh_count_; mesh++)
+                if (!meshes_[mesh].isSkinned())
+                    mesh_transforms[mesh] = node_transforms[i];
+        for(size_t mesh = 0; mesh < meshes_.size(); mesh++)
+        {
+            boxes[mesh]   = meshes_[mesh].getBounds().box_;
+            spheres[mesh] = meshes_[mesh].getBounds().sphere_;
+        }
+        transformAabbs(boxes.data(), mesh_transforms.data(), boxes.data(), boxes.size());
+        transformSpheres(spheres.data(), mesh_transforms.data(), spheres.data(), spheres.size());
+
+        bounds_ = MeshBounds{};
+        for(const Aabb& box : boxes)
+            bounds_.box_.merge(box);
+        if (bounds_.box_.isEmpty())
+            return;
+        // whichever is tighter: the box's corners or the farthest mesh sphere
+        bounds_.sphere_.center_ = bounds_.box_.getCenter();
+        float radius = 0.0f;
+        for(size_t mesh = 0; mesh < meshes_.size(); mesh++)
+            if (!boxes[mesh].isEmpty())
+                radius = std::max(radius, glm::length(spheres[mesh].center_ - bounds_.sphere_.center_) + spheres[mesh].radius_);
+        bounds_.sphere_.radius_ = std::min(radius, glm::length(bounds_.box_.getExtent()));
+    }
+
+    void Model::getWorldBounds(const SceneGraph& scene, size_t root_node, std::vector<Aabb>& mesh_boxes) const {
+        const int       parent_node    = scene.getParent(root_node);
+        const glm::mat4 skin_transform = parent_node != SceneGraph::NO_PARENT ? scene.getWorldTransform(parent_node) : glm::mat4(1.0f);
+
+        std::vector<glm::mat4> transforms(meshes_.size(), skin_transform);
+        std::vector<Aabb>      boxes(meshes_.size());
+        for(size_t i = 0; i < nodes_.size(); i++)
+            for(unsigned int mesh = nodes_[i].first_mesh_; mesh < nodes_[i].first_mesh_ + nodes_[i].mesh_count_; mesh++)
+                if (!meshes_[mesh].isSkinned())
+                    transforms[mesh] = scene.getWorldTransform(root_node + i);
+        for(size_t mesh = 0; mesh < meshes_.size(); mesh++)
+            boxes[mesh] = meshes_[mesh].getBounds().box_;
+
+        mesh_boxes.resize(meshes_.size());
+        transformAabbs(boxes.data(), transforms.data(), mesh_boxes.data(), mesh_boxes.size());
+    }
+
+    Aabb Model::getWorldBounds(const SceneGraph& scene, size_t root_node) const {
+        std::vector<Aabb> mesh_boxes;
+        getWorldBounds(scene, root_node, mesh_boxes);
+        Aabb world_box;
+        for(const Aabb& box : mesh_boxes)
+            world_box.merge(box);
+        return world_box;
+    }
+
+    /// @brief estimate each mesh's screen size from its world bounds and hand it to the streamer as texture demand
+    /// @param scene scene the model is attached to
+    /// @param root_node what attachTo returned
+    /// @param lod_selector world space camera, its projection_scale_ already accounts for zoom and the render resolution
+    /// @param cull_view world space view, meshes outside it are not requested and age out of the budget first
+    void Model::requestTextures(const SceneGraph& scene, size_t root_node, const LodSelector& lod_selector,
+                                const CullView* cull_view) const {
+        const int       parent_node    = scene.getParent(root_node);
+        const glm::mat4 skin_transform = parent_node != SceneGraph::NO_PARENT ? scene.getWorldTransform(parent_node) : glm::mat4(1.0f);
+
+        std::vector<glm::mat4>      transforms(meshes_.size(), skin_transform);
+        std::vector<BoundingSphere> spheres(meshes_.size());
+        for(size_t i = 0; i < nodes_.size(); i++)
+            for(unsigned int mesh = nodes_[i].first_mesh_; mesh < nodes_[i].first_mesh_ + nodes_[i].mesh_count_; mesh++)
+                if (!meshes_[mesh].isSkinned())
+                    transforms[mesh] = scene.getWorldTransform(root_node + i);
+        for(size_t mesh = 0; mesh < meshes_.size(); mesh++)
+            spheres[mesh] = meshes_[mesh].getBounds().sphere_;
+        transformSpheres(spheres.data(), transforms.data(), spheres.data(), spheres.size());
+
+        TextureStreamer& texture_streamer = TextureStreamer::getInstance();
+        for(size_t mesh = 0; mesh < meshes_.size(); mesh++)
+        {
+            const BoundingSphere& sphere = spheres[mesh];
+            if (cull_view != nullptr && !cull_view->frustum_.isSphereVisible(sphere.center_, sphere.radius_))
+                continue;
+            // the texture is assumed to span the mesh once, inside the bounds it wants every texel
+            const float distance      = glm::length(sphere.center_ - lod_selector.camera_position_) - sphere.radius_;
+            const float screen_pixels = distance > 0.0f ? 2.0f * sphere.radius_ * lod_selector.projection_scale_ / distance
+                                                        : std::numeric_limits<float>::max();
+            for(const Texture2D& texture : meshes_[mesh].getTextures())
+                texture_streamer.request(texture.getTextureId(), screen_pixels);
+        }
+    }
+
+    size_t Model::attachTo(SceneGraph& scene, int parent) {
+        // nodes_ is a pre-order walk, parents already come first
+        const size_t root_node = scene.getNodeCount();
+        for(const ModelNode& node : nodes_)
+            scene.addNode(node.parent_ == -1 ? parent : static_cast<int>(root_node) + node.parent_, node.transform_, node.name_);
+        if (nodes_.empty())
+            scene.addNode(parent);
+        return root_node;
+    }
+
+    void Model::draw(ShaderProgram& shader_program, const SceneGraph& scene, size_t root_node,
+                     const CullView* cull_view, const LodSelector* lod_selector) {
+        // every mesh lives in geometry_, one VAO bind covers them all
+        if (geometry_ == nullptr)
+            return;
+
+        // the bone palette already contains the model's hierarchy, skinned meshes only get the attachment's transform
+        const int       parent_node          = scene.getParent(root_node);
+        const glm::mat4 skin_transform       = parent_node != SceneGraph::NO_PARENT ? scene.getWorldTransform(parent_node) : glm::mat4(1.0f);
+        const glm::mat3 skin_normal_matrix   = parent_node != SceneGraph::NO_PARENT ? scene.getNormalMatrix(parent_node) : glm::mat3(1.0f);
+        LodSelector     skin_lod_selector;
+        if (lod_selector != nullptr)
+            skin_lod_selector = lod_selector->toLocalSpace(skin_transform, skin_normal_matrix);
+
+        geometry_->bind();
+        // textures may have been bound behind the materials' back since the last draw
+        Material::invalidateBinding();
+        for(size_t i = 0; i < nodes_.size(); i++)
+        {
+            const ModelNode& node = nodes_[i];
+            if (node.mesh_count_ == 0)
+                continue;
+            const glm::mat4& world_transform = scene.getWorldTransform(root_node + i);
+            const glm::mat3& normal_matrix   = scene.getNormalMatrix(root_node + i);
+
+            // meshlet bounds and LOD errors live in the node's space
+            CullView    node_cull_view;
+            LodSelector node_lod_selector;
+            if (cull_view != nullptr)
+                node_cull_view = cull_view->toLocalSpace(world_transform, normal_matrix);
+            if (lod_selector != nullptr)
+                node_lod_selector = lod_selector->toLocalSpace(world_transform, normal_matrix);
+
+            bool node_space = false;
+            for(unsigned int mesh = node.first_mesh_; mesh < node.first_mesh_ + node.mesh_count_; mesh++)
+            {
+                // posed vertices leave the rest pose meshlet bounds, so skinned meshes are never meshlet culled
+                const bool skinned = meshes_[mesh].isSkinned();
+                if (skinned || !node_space) {
+                    shader_program.setUniform(MODEL_UNIFORM, skinned ? skin_transform : world_transform);
+                    shader_program.setUniform(NORMAL_MATRIX_UNIFORM, skinned ? skin_normal_matrix : normal_matrix);
+                    node_space = !skinned;
+                }
+                if (skinned)
+                    meshes_[mesh].drawBound(shader_program, nullptr, lod_selector != nullptr ? &skin_lod_selector : nullptr);
+                else
+                    meshes_[mesh].drawBound(shader_program, cull_view != nullptr ? &node_cull_view : nullptr, 
+                                            lod_selector != nullptr ? &node_lod_selector : nullptr);
+            }
+        }
+        glBindVertexArray(0);
+    }
+
+    void Model::drawInstanced(ShaderProgram& shader_program, GLsizei instance_count, size_t lod) {
+        if (geometry_ == nullptr || instance_count <= 0)
+            return;
+        geometry_->bind();
+        Material::invalidateBinding();
+        for(Mesh& mesh : meshes_)
+            mesh.drawInstanced(shader_program, instance_count, lod);
+        glBindVertexArray(0);
     }
 
     void Model::deleteBuffer() {
         for(unsigned int i = 0; i < meshes_.size(); i++)
             meshes_[i].deleteBuffer();
+        geometry_.reset();
+        // drop the cache references while the GL context is still current
+        textures_loaded_.clear();
     }
-}
\ No newline at end of file
+}
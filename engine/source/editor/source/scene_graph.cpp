@@ -0,0 +1,57 @@
+#include "editor/include/scene_graph.h"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace Hd2d {
+    /// @brief append a node
+    /// @param parent index of an existing node or NO_PARENT
+    /// @param local_transform transform relative to the parent
+    /// @param name used by findNode, may be empty
+    /// @return index of the new node, stable for the graph's lifetime
+    size_t SceneGraph::addNode(int parent, const glm::mat4& local_transform, std::string_view name) {
+        const size_t node = parents_.size();
+        if (parent >= static_cast<int>(node)) {
+            std::cout << "Error::SceneGraph::Parent_After_Child " << name << std::endl;
+            parent = NO_PARENT;
+        }
+        parents_.push_back(parent);
+        local_transforms_.push_back(local_transform);
+        world_transforms_.push_back(glm::mat4(1.0f));
+        normal_matrices_.push_back(glm::mat3(1.0f));
+        dirty_.push_back(1);
+        changed_.push_back(0);
+        names_.emplace_back(name);
+        return node;
+    }
+
+    void SceneGraph::setLocalTransform(size_t node, const glm::mat4& local_transform) {
+        local_transforms_[node] = local_transform;
+        dirty_[node] = 1;
+    }
+
+    int SceneGraph::findNode(std::string_view name) const noexcept {
+        auto it = std::find(names_.begin(), names_.end(), name);
+        return it == names_.end() ? NO_PARENT : static_cast<int>(it - names_.begin());
+    }
+
+    size_t SceneGraph::update() {
+        // a parent is always resolved before its children, so its changed flag is final when they read it
+        size_t updated = 0;
+        for (size_t node = 0; node < parents_.size(); node++) {
+            const int parent = parents_[node];
+            changed_[node] = dirty_[node] | (parent != NO_PARENT ? changed_[parent] : uint8_t{0});
+            dirty_[node]   = 0;
+            if (!changed_[node])
+                continue;
+
+            world_transforms_[node] = parent != NO_PARENT ? world_transforms_[parent] * local_transforms_[node]
+                                                          : local_transforms_[node];
+            normal_matrices_[node]  = glm::inverseTranspose(glm::mat3(world_transforms_[node]));
+            updated++;
+        }
+        return updated;
+    }
+}
@@ -1,6 +1,8 @@
 #include "editor/include/shader.h"
 // #include "editor/include/texture2d.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <string>
 #include <string_view>
 
@@ -13,7 +15,54 @@
 
 #include <glad/glad.h>
 
-Shader::Shader(std::string_view file_path) : id_ { 0 } {
+namespace {
+    // an include including itself would never end
+    constexpr int MAX_INCLUDE_DEPTH = 8;
+
+    /// @brief replace every #include "file" line with the file, resolved relative to the including file
+    /// @param source shader source, expanded in place
+    /// @param directory directory of the file the source was read from
+    /// @param depth include nesting of the source
+    /// @return false if an included file can't be read
+    bool expandIncludes(std::string& source, const std::filesystem::path& directory, int depth) {
+        size_t line_start = 0;
+        while (line_start < source.size()) {
+            size_t line_end = source.find('\n', line_start);
+            if (line_end == std::string::npos)
+                line_end = source.size();
+            const size_t directive = source.find_first_not_of(" \t", line_start);
+            if (directive >= line_end || source.compare(directive, 8, "#include") != 0) {
+                line_start = line_end + 1;
+                continue;
+            }
+
+            const size_t open  = source.find('"', directive);
+            const size_t close = open < line_end ? source.find('"', open + 1) : std::string::npos;
+            if (close >= line_end || depth >= MAX_INCLUDE_DEPTH) {
+                std::cout << "Error::Shader::Include_Not_Resolved " << source.substr(line_start, line_end - line_start) << std::endl;
+                return false;
+            }
+            const std::filesystem::path include_path = directory / source.substr(open + 1, close - open - 1);
+            std::ifstream fs{include_path};
+            if (!fs) {
+                std::cout << "Error::Shader::Include_Not_Successfully_Read " << include_path.string() << std::endl;
+                return false;
+            }
+            std::stringstream ss{};
+            ss << fs.rdbuf();
+            std::string included = ss.str();
+            if (!expandIncludes(included, include_path.parent_path(), depth + 1))
+                return false;
+            if (included.empty() || included.back() != '\n')
+                included += '\n';
+            source.replace(line_start, std::min(line_end + 1, source.size()) - line_start, included);
+            line_start += included.size();
+        }
+        return true;
+    }
+}
+
+Shader::Shader(std::string_view file_path, const std::vector<std::string>& defines) : id_ { 0 } {
     std::ifstream fs{};
     fs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
@@ -27,6 +76,26 @@ Shader::Shader(std::string_view file_path) : id_ { 0 } {
     catch (std::ifstream::failure e) {
         std::cout << "Error::Shader::File_Not_Successfully_Read" << std::endl;
     }
+
+    // shared helpers live in shaders/include, spliced in before compiling since GLSL has no includes
+    expandIncludes(source_, std::filesystem::path{file_path}.parent_path(), 0);
+
+    // #version has to stay the first statement, so defines go right after it
+    if (!defines.empty()) {
+        std::string define_lines;
+        for (const std::string& define : defines)
+            define_lines += "#define " + define + "\n";
+        size_t insert_pos = 0;
+        if (source_.rfind("#version", 0) == 0) {
+            size_t version_end = source_.find('\n');
+            if (version_end == std::string::npos) {
+                source_ += '\n';
+                version_end = source_.size() - 1;
+            }
+            insert_pos = version_end + 1;
+        }
+        source_.insert(insert_pos, define_lines);
+    }
 }
 
 Shader::~Shader() {
@@ -34,8 +103,8 @@ Shader::~Shader() {
         glDeleteShader(id_);
 }
 
-VertexShader::VertexShader(std::string_view file_path)
-: Shader { file_path } {
+VertexShader::VertexShader(std::string_view file_path, const std::vector<std::string>& defines)
+: Shader { file_path, defines } {
     id_ = glCreateShader(GL_VERTEX_SHADER);
     auto source_str = source_.c_str();
     glShaderSource(id_, 1, &source_str, nullptr);
@@ -50,8 +119,8 @@ VertexShader::VertexShader(std::string_view file_path)
     }
 }
 
-FragmentShader::FragmentShader(std::string_view file_path)
-: Shader { file_path } {
+FragmentShader::FragmentShader(std::string_view file_path, const std::vector<std::string>& defines)
+: Shader { file_path, defines } {
     id_ = glCreateShader(GL_FRAGMENT_SHADER);
     auto source_str = source_.c_str();
     glShaderSource(id_, 1, &source_str, nullptr);
@@ -66,8 +135,8 @@ FragmentShader::FragmentShader(std::string_view file_path)
     }
 }
 
-GeometryShader::GeometryShader(std::string_view file_path) 
-: Shader { file_path } {
+GeometryShader::GeometryShader(std::string_view file_path, const std::vector<std::string>& defines)
+: Shader { file_path, defines } {
     id_ = glCreateShader(GL_GEOMETRY_SHADER);
     auto source_str = source_.c_str();
     glShaderSource(id_, 1, &source_str, nullptr);
@@ -83,10 +152,11 @@ GeometryShader::GeometryShader(std::string_view file_path)
 }
 
 ShaderProgram::ShaderProgram(std::string_view vertex_shader  , 
-                             std::string_view fragment_shader)
+                             std::string_view fragment_shader,
+                             const std::vector<std::string>& defines)
 : id_ { 0 } {
-    VertexShader vertex {vertex_shader};
-    FragmentShader fragment {fragment_shader};
+    VertexShader vertex {vertex_shader, defines};
+    FragmentShader fragment {fragment_shader, defines};
 
     id_ = glCreateProgram();
     glAttachShader(id_, vertex.getId());
@@ -100,15 +170,17 @@ ShaderProgram::ShaderProgram(std::string_view vertex_shader  ,
         glGetProgramInfoLog(id_, 512, nullptr, log_info);
         std::cout << "ERROR:SHADER::PROGRAM::LINK_FAILED\n" << log_info << std::endl;
     }
+    cacheUniformLocations();
 }
 
 ShaderProgram::ShaderProgram(std::string_view vertex_shader  , 
                              std::string_view geometry_shader,
-                             std::string_view fragment_shader)
+                             std::string_view fragment_shader,
+                             const std::vector<std::string>& defines)
 : id_ { 0 } {
-    VertexShader vertex {vertex_shader};
-    GeometryShader geometry {geometry_shader};
-    FragmentShader fragment {fragment_shader};
+    VertexShader vertex {vertex_shader, defines};
+    GeometryShader geometry {geometry_shader, defines};
+    FragmentShader fragment {fragment_shader, defines};
 
     id_ = glCreateProgram();
     glAttachShader(id_, vertex.getId());
@@ -124,6 +196,7 @@ ShaderProgram::ShaderProgram(std::string_view vertex_shader  ,
         glGetProgramInfoLog(id_, 512, nullptr, log_info);
         std::cout << "ERROR:SHADER::PROGRAM::LINK_FAILED\n" << log_info << std::endl;
     }
+    cacheUniformLocations();
 }
 
 ShaderProgram::~ShaderProgram() {
@@ -132,28 +205,146 @@ ShaderProgram::~ShaderProgram() {
     }
 }
 
+/// @brief hash every active uniform into the location table, so setting one never asks the driver by name
+void ShaderProgram::cacheUniformLocations() {
+    GLint uniform_count = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(id_, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    struct ActiveUniform {
+        std::string name_;
+        GLint       size_ = 1;
+    };
+    std::vector<ActiveUniform> active_uniforms;
+    active_uniforms.reserve(static_cast<size_t>(uniform_count));
+    // arrays take a slot for "name" and one for every "name[i]"
+    size_t name_count = 0;
+    std::string name(static_cast<size_t>(std::max(max_name_length, 1)), '\0');
+    for (GLint i = 0; i < uniform_count; i++) {
+        GLsizei name_length = 0;
+        GLint   size = 0;
+        GLenum  type = 0;
+        glGetActiveUniform(id_, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &name_length, &size, &type, name.data());
+        active_uniforms.push_back(ActiveUniform{name.substr(0, static_cast<size_t>(name_length)), std::max(size, 1)});
+        name_count += static_cast<size_t>(std::max(size, 1)) + 1;
+    }
+
+    // kept at most half full so probes stay short
+    size_t capacity = 16;
+    while (capacity < name_count * 2)
+        capacity *= 2;
+    uniform_slots_.assign(capacity, UniformSlot{});
+    uniform_mask_ = capacity - 1;
+
+    constexpr std::string_view ARRAY_SUFFIX = "[0]";
+    for (const ActiveUniform& active_uniform : active_uniforms) {
+        const std::string_view uniform_name{active_uniform.name_};
+        // members of uniform blocks have no location, they are set through their buffer
+        const GLint location = glGetUniformLocation(id_, active_uniform.name_.c_str());
+        if (location < 0)
+            continue;
+        insertUniformLocation(Hd2d::fnv1a64(uniform_name), location);
+        // arrays are reported once as "name[0]", every element gets its own entry so "name[i]" needs no GL call later
+        if (uniform_name.size() <= ARRAY_SUFFIX.size() || uniform_name.substr(uniform_name.size() - ARRAY_SUFFIX.size()) != ARRAY_SUFFIX)
+            continue;
+        const std::string base_name{uniform_name.substr(0, uniform_name.size() - ARRAY_SUFFIX.size())};
+        insertUniformLocation(Hd2d::fnv1a64(base_name), location);
+        for (GLint element = 1; element < active_uniform.size_; element++) {
+            const std::string element_name = base_name + "[" + std::to_string(element) + "]";
+            const GLint element_location = glGetUniformLocation(id_, element_name.c_str());
+            if (element_location >= 0)
+                insertUniformLocation(Hd2d::fnv1a64(element_name), element_location);
+        }
+    }
+}
+
+void ShaderProgram::insertUniformLocation(uint64_t hash, int location) {
+    for (uint64_t slot = hash & uniform_mask_; ; slot = (slot + 1) & uniform_mask_) {
+        UniformSlot& uniform_slot = uniform_slots_[slot];
+        if (uniform_slot.location_ < 0) {
+            uniform_slot = UniformSlot{hash, location};
+            return;
+        }
+        if (uniform_slot.hash_ == hash) {
+            if (uniform_slot.location_ != location)
+                std::cout << "Error::ShaderProgram::Uniform_Name_Hash_Collision " << hash << std::endl;
+            return;
+        }
+    }
+}
+
+int ShaderProgram::getUniformLocation(UniformId uniform) const noexcept {
+    if (uniform_slots_.empty())
+        return -1;
+    // at most half full, so probing always reaches a free slot
+    for (uint64_t slot = uniform.hash_ & uniform_mask_; ; slot = (slot + 1) & uniform_mask_) {
+        const UniformSlot& uniform_slot = uniform_slots_[slot];
+        if (uniform_slot.location_ < 0)
+            return -1;
+        if (uniform_slot.hash_ == uniform.hash_)
+            return uniform_slot.location_;
+    }
+}
+
+void ShaderProgram::setUniform(UniformId uniform, bool value) const noexcept {
+    glUniform1i(getUniformLocation(uniform), static_cast<int>(value));
+}
+
+void ShaderProgram::setUniform(UniformId uniform, int value) const noexcept {
+    glUniform1i(getUniformLocation(uniform), value);
+}
+
+void ShaderProgram::setUniform(UniformId uniform, unsigned int value) const noexcept {
+    glUniform1i(getUniformLocation(uniform), value);
+}
+
+void ShaderProgram::setUniform(UniformId uniform, float value) const noexcept {
+    glUniform1f(getUniformLocation(uniform), value);
+}
+
+void ShaderProgram::setUniform(UniformId uniform, const glm::vec3& value) const noexcept {
+    glUniform3fv(getUniformLocation(uniform), 1, &value[0]);
+}
+
+void ShaderProgram::setUniform(UniformId uniform, const glm::mat3& value) const noexcept {
+    glUniformMatrix3fv(getUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(UniformId uniform, const glm::mat4& value) const noexcept {
+    glUniformMatrix4fv(getUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(value));
+}
+
 void ShaderProgram::setUniform(const std::string_view name, bool value) const noexcept {
-    glUniform1i(glGetUniformLocation(id_, name.data()), static_cast<int>(value));
+    setUniform(UniformId{name}, value);
 }
 
 void ShaderProgram::setUniform(const std::string_view name, int value) const noexcept {
-    glUniform1i(glGetUniformLocation(id_, name.data()), value);
+    setUniform(UniformId{name}, value);
 }
 
 void ShaderProgram::setUniform(const std::string_view name, unsigned int value) const noexcept {
-    glUniform1i(glGetUniformLocation(id_, name.data()), value);
+    setUniform(UniformId{name}, value);
 }
 
 void ShaderProgram::setUniform(const std::string_view name, float value) const noexcept {
-    glUniform1f(glGetUniformLocation(id_, name.data()), value);
+    setUniform(UniformId{name}, value);
 }
 
 void ShaderProgram::setUniform(const std::string_view name, const glm::vec3& value) const noexcept {
-    glUniform3fv(glGetUniformLocation(id_, name.data()), 1, &value[0]);
+    setUniform(UniformId{name}, value);
+}
+
+void ShaderProgram::setUniform(const std::string_view name, const glm::mat3& value) const noexcept {
+    setUniform(UniformId{name}, value);
 }
 
 void ShaderProgram::setUniform(const std::string_view name, const glm::mat4& value) const noexcept {
-    glUniformMatrix4fv(glGetUniformLocation(id_, name.data()), 1, GL_FALSE, glm::value_ptr(value));
+    setUniform(UniformId{name}, value);
+}
+
+void ShaderProgram::setTexture(UniformId uniform, int value) const noexcept {
+    setUniform(uniform, value);
 }
 
 void ShaderProgram::setTexture(const std::string_view name, int value) const noexcept {
@@ -161,7 +352,10 @@ void ShaderProgram::setTexture(const std::string_view name, int value) const noe
 }
 
 void ShaderProgram::setUniformBlock(std::string_view name, int value) const noexcept {
-    unsigned int uniform_block = glGetUniformBlockIndex(id_, name.data());
+    unsigned int uniform_block = glGetUniformBlockIndex(id_, std::string{name}.c_str());
+    // blocks compiled out by a define are simply not there
+    if (uniform_block == GL_INVALID_INDEX)
+        return;
     glUniformBlockBinding(id_, uniform_block, value);
 }
 
@@ -0,0 +1,53 @@
+#include "editor/include/sprite_atlas.h"
+#include "editor/include/hash.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Hd2d {
+    /// @brief map a cooked atlas and upload its pages
+    /// @param atlas_path .hd2datlas written by hd2dTexCook --atlas
+    /// @return atlas, nullptr if the table is invalid or a page can't be loaded
+    std::shared_ptr<SpriteAtlas> SpriteAtlas::load(std::string_view atlas_path) {
+        std::shared_ptr<MappedFile> file = MappedFile::open(atlas_path);
+        const SpriteAtlasHeader* header = file ? validateSpriteAtlas(file->getData(), file->getSize()) : nullptr;
+        if (header == nullptr) {
+            std::cout << "Error::SpriteAtlas::Atlas_File_Not_Supported " << atlas_path << std::endl;
+            return nullptr;
+        }
+
+        auto atlas = std::make_shared<SpriteAtlas>();
+        atlas->file_    = file;
+        atlas->header_  = header;
+        atlas->sprites_ = reinterpret_cast<const SpriteAtlasSprite*>(
+            file->getData() + sizeof(SpriteAtlasHeader) + sizeof(SpriteAtlasPage) * header->page_count_);
+        atlas->pages_.reserve(header->page_count_);
+        for (uint32_t page = 0; page < header->page_count_; page++) {
+            std::shared_ptr<Texture2D> texture = Texture2D::loadFromCptFile(getSpriteAtlasPagePath(atlas_path, page));
+            if (texture->getTextureId() == 0) {
+                std::cout << "Error::SpriteAtlas::Page_Not_Loaded " << getSpriteAtlasPagePath(atlas_path, page) << std::endl;
+                return nullptr;
+            }
+            atlas->pages_.push_back(std::move(texture));
+        }
+        return atlas;
+    }
+
+    /// @brief look a frame up by name, a binary search over the hash sorted table
+    /// @param name frame name, the file stem of the source image
+    /// @return sprite index, -1 if the atlas has no such frame
+    int SpriteAtlas::find(std::string_view name) const noexcept {
+        const uint64_t name_hash = fnv1a64(name);
+        const SpriteAtlasSprite* end = sprites_ + header_->sprite_count_;
+        const SpriteAtlasSprite* it  = std::lower_bound(sprites_, end, name_hash,
+            [](const SpriteAtlasSprite& sprite, uint64_t hash) { return sprite.name_hash_ < hash; });
+        if (it == end || it->name_hash_ != name_hash)
+            return -1;
+        return static_cast<int>(it - sprites_);
+    }
+
+    void SpriteAtlas::bindPage(size_t index, GLenum texture_unit) const {
+        glActiveTexture(GL_TEXTURE0 + texture_unit);
+        glBindTexture(GL_TEXTURE_2D, pages_[sprites_[index].page_]->getTextureId());
+    }
+}
@@ -0,0 +1,333 @@
+#include "editor/include/sprite_atlas_cook.h"
+#include "editor/include/hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+namespace Hd2d {
+    namespace {
+        struct PackRect {
+            uint32_t x_      = 0;
+            uint32_t y_      = 0;
+            uint32_t width_  = 0;
+            uint32_t height_ = 0;
+
+            uint32_t getRight() const noexcept { return x_ + width_; }
+            uint32_t getBottom() const noexcept { return y_ + height_; }
+            bool contains(const PackRect& other) const noexcept {
+                return other.x_ >= x_ && other.y_ >= y_ && other.getRight() <= getRight() && other.getBottom() <= getBottom();
+            }
+            bool intersects(const PackRect& other) const noexcept {
+                return other.x_ < getRight() && other.getRight() > x_ && other.y_ < getBottom() && other.getBottom() > y_;
+            }
+        };
+
+        // MaxRects (Jylanki) with the best short side fit heuristic: free space is kept as maximal,
+        // possibly overlapping rects, each placement splits the ones it touches
+        class MaxRectsBin {
+        public:
+            MaxRectsBin(uint32_t width, uint32_t height) { free_rects_.push_back(PackRect{0, 0, width, height}); }
+
+            bool insert(uint32_t width, uint32_t height, PackRect& placed) {
+                uint32_t best_short = std::numeric_limits<uint32_t>::max();
+                uint32_t best_long  = std::numeric_limits<uint32_t>::max();
+                const PackRect* best = nullptr;
+                for (const PackRect& free_rect : free_rects_) {
+                    if (free_rect.width_ < width || free_rect.height_ < height)
+                        continue;
+                    const uint32_t left_x   = free_rect.width_ - width;
+                    const uint32_t left_y   = free_rect.height_ - height;
+                    const uint32_t short_fit = std::min(left_x, left_y);
+                    const uint32_t long_fit  = std::max(left_x, left_y);
+                    if (short_fit < best_short || (short_fit == best_short && long_fit < best_long)) {
+                        best_short = short_fit;
+                        best_long  = long_fit;
+                        best       = &free_rect;
+                    }
+                }
+                if (best == nullptr)
+                    return false;
+                placed = PackRect{best->x_, best->y_, width, height};
+                split(placed);
+                return true;
+            }
+
+        private:
+            std::vector<PackRect> free_rects_;
+
+            void split(const PackRect& used) {
+                std::vector<PackRect> next;
+                next.reserve(free_rects_.size() + 4);
+                for (const PackRect& free_rect : free_rects_) {
+                    if (!free_rect.intersects(used)) {
+                        next.push_back(free_rect);
+                        continue;
+                    }
+                    // up to four maximal rects around used
+                    if (used.x_ > free_rect.x_)
+                        next.push_back(PackRect{free_rect.x_, free_rect.y_, used.x_ - free_rect.x_, free_rect.height_});
+                    if (used.getRight() < free_rect.getRight())
+                        next.push_back(PackRect{used.getRight(), free_rect.y_, free_rect.getRight() - used.getRight(), free_rect.height_});
+                    if (used.y_ > free_rect.y_)
+                        next.push_back(PackRect{free_rect.x_, free_rect.y_, free_rect.width_, used.y_ - free_rect.y_});
+                    if (used.getBottom() < free_rect.getBottom())
+                        next.push_back(PackRect{free_rect.x_, used.getBottom(), free_rect.width_, free_rect.getBottom() - used.getBottom()});
+                }
+
+                // drop rects inside others, of two equal ones the first is kept
+                free_rects_.clear();
+                for (size_t i = 0; i < next.size(); i++) {
+                    bool redundant = false;
+                    for (size_t j = 0; j < next.size() && !redundant; j++)
+                        redundant = i != j && next[j].contains(next[i]) && (!next[i].contains(next[j]) || j < i);
+                    if (!redundant)
+                        free_rects_.push_back(next[i]);
+                }
+            }
+        };
+
+        // a frame after trimming, duplicates point at the same unique image
+        struct TrimmedFrame {
+            PackRect trim_;         // opaque texels inside the source frame
+            size_t   unique_ = 0;
+        };
+
+        struct UniqueImage {
+            size_t   frame_ = 0; // first frame with these texels
+            PackRect trim_;
+            uint32_t page_  = 0;
+            PackRect placed_;    // with padding
+        };
+
+        PackRect trimFrame(const SpriteFrame& frame, bool trim) {
+            PackRect full{0, 0, frame.width_, frame.height_};
+            if (!trim)
+                return full;
+            uint32_t min_x = frame.width_, min_y = frame.height_, max_x = 0, max_y = 0;
+            for (uint32_t y = 0; y < frame.height_; y++) {
+                const unsigned char* row = frame.rgba_ + size_t(y) * frame.width_ * 4;
+                for (uint32_t x = 0; x < frame.width_; x++) {
+                    if (row[x * 4 + 3] == 0)
+                        continue;
+                    min_x = std::min(min_x, x);
+                    max_x = std::max(max_x, x);
+                    min_y = std::min(min_y, y);
+                    max_y = std::max(max_y, y);
+                }
+            }
+            // nothing visible, keep one transparent texel so the sprite still has a rect
+            if (min_x > max_x)
+                return PackRect{0, 0, 1, 1};
+            return PackRect{min_x, min_y, max_x - min_x + 1, max_y - min_y + 1};
+        }
+
+        uint64_t hashTrimmed(const SpriteFrame& frame, const PackRect& trim) {
+            uint64_t hash = fnv1a64(&trim.width_, sizeof(trim.width_));
+            hash = fnv1a64(&trim.height_, sizeof(trim.height_), hash);
+            for (uint32_t y = trim.y_; y < trim.getBottom(); y++)
+                hash = fnv1a64(frame.rgba_ + (size_t(y) * frame.width_ + trim.x_) * 4, size_t(trim.width_) * 4, hash);
+            return hash;
+        }
+
+        bool isSameTrimmed(const SpriteFrame& a, const PackRect& trim_a, const SpriteFrame& b, const PackRect& trim_b) {
+            if (trim_a.width_ != trim_b.width_ || trim_a.height_ != trim_b.height_)
+                return false;
+            for (uint32_t y = 0; y < trim_a.height_; y++)
+                if (std::memcmp(a.rgba_ + (size_t(trim_a.y_ + y) * a.width_ + trim_a.x_) * 4,
+                                b.rgba_ + (size_t(trim_b.y_ + y) * b.width_ + trim_b.x_) * 4, size_t(trim_a.width_) * 4) != 0)
+                    return false;
+            return true;
+        }
+
+        /// @brief copy the trimmed texels into the page, repeating the edge texels over the padding
+        void blitExtruded(const SpriteFrame& frame, const UniqueImage& image, uint32_t padding,
+                          std::vector<uint8_t>& page_pixels, uint32_t page_width) {
+            for (uint32_t y = 0; y < image.placed_.height_; y++) {
+                const uint32_t source_y = image.trim_.y_ + std::min(uint32_t(std::max(int64_t(y) - padding, int64_t(0))), image.trim_.height_ - 1);
+                for (uint32_t x = 0; x < image.placed_.width_; x++) {
+                    const uint32_t source_x = image.trim_.x_ + std::min(uint32_t(std::max(int64_t(x) - padding, int64_t(0))), image.trim_.width_ - 1);
+                    std::memcpy(page_pixels.data() + (size_t(image.placed_.y_ + y) * page_width + image.placed_.x_ + x) * 4,
+                                frame.rgba_ + (size_t(source_y) * frame.width_ + source_x) * 4, 4);
+                }
+            }
+        }
+    }
+
+    /// @brief build an atlas from decoded frames
+    /// @param frames RGBA8 frames, names must be unique
+    /// @param settings page size, padding, trimming and dedupe
+    /// @return pages and the sprite table sorted by name hash, invalid if nothing could be packed
+    CookedSpriteAtlas cookSpriteAtlas(const std::vector<SpriteFrame>& frames, const SpriteAtlasCookSettings& settings) {
+        CookedSpriteAtlas atlas;
+        const uint32_t padding = settings.padding_;
+
+        // trim and find identical frames
+        std::vector<TrimmedFrame> trimmed(frames.size());
+        std::vector<UniqueImage>  uniques;
+        std::unordered_multimap<uint64_t, size_t> unique_by_hash;
+        for (size_t i = 0; i < frames.size(); i++) {
+            const SpriteFrame& frame = frames[i];
+            trimmed[i].trim_ = trimFrame(frame, settings.trim_);
+            const uint64_t hash = settings.dedupe_ ? hashTrimmed(frame, trimmed[i].trim_) : uint64_t(i);
+            bool found = false;
+            auto [first, last] = unique_by_hash.equal_range(hash);
+            for (auto it = first; it != last && settings.dedupe_ && !found; ++it) {
+                const UniqueImage& unique = uniques[it->second];
+                if (isSameTrimmed(frames[unique.frame_], unique.trim_, frame, trimmed[i].trim_)) {
+                    trimmed[i].unique_ = it->second;
+                    found = true;
+                }
+            }
+            if (found)
+                continue;
+            trimmed[i].unique_ = uniques.size();
+            unique_by_hash.emplace(hash, uniques.size());
+            UniqueImage unique;
+            unique.frame_ = i;
+            unique.trim_  = trimmed[i].trim_;
+            uniques.push_back(unique);
+        }
+        atlas.unique_frames_ = uniques.size();
+
+        // largest side first packs tightest, then fill every open page before starting another
+        std::vector<size_t> order(uniques.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&uniques](size_t a, size_t b) {
+            const PackRect& rect_a = uniques[a].trim_;
+            const PackRect& rect_b = uniques[b].trim_;
+            const uint32_t side_a = std::max(rect_a.width_, rect_a.height_), side_b = std::max(rect_b.width_, rect_b.height_);
+            if (side_a != side_b)
+                return side_a > side_b;
+            return rect_a.width_ * rect_a.height_ > rect_b.width_ * rect_b.height_;
+        });
+        std::vector<MaxRectsBin> bins;
+        std::vector<bool>        packed(uniques.size(), false);
+        for (size_t index : order) {
+            UniqueImage& unique = uniques[index];
+            const uint32_t width  = unique.trim_.width_ + 2 * padding;
+            const uint32_t height = unique.trim_.height_ + 2 * padding;
+            if (width > settings.max_page_size_ || height > settings.max_page_size_) {
+                std::cout << "Error::SpriteAtlas::Frame_Larger_Than_Page " << frames[unique.frame_].name_ << std::endl;
+                continue;
+            }
+            bool placed = false;
+            for (uint32_t page = 0; page < bins.size() && !placed; page++) {
+                if (bins[page].insert(width, height, unique.placed_)) {
+                    unique.page_ = page;
+                    placed       = true;
+                }
+            }
+            if (!placed) {
+                bins.emplace_back(settings.max_page_size_, settings.max_page_size_);
+                bins.back().insert(width, height, unique.placed_);
+                unique.page_ = uint32_t(bins.size() - 1);
+            }
+            packed[index] = true;
+        }
+        if (bins.empty())
+            return atlas;
+
+        // pages shrink to what they use, kept a multiple of the 4x4 compression block
+        atlas.pages_.resize(bins.size(), SpriteAtlasPage{4, 4});
+        for (size_t i = 0; i < uniques.size(); i++) {
+            if (!packed[i])
+                continue;
+            SpriteAtlasPage& page = atlas.pages_[uniques[i].page_];
+            page.width_  = std::max(page.width_, (uniques[i].placed_.getRight() + 3) & ~3u);
+            page.height_ = std::max(page.height_, (uniques[i].placed_.getBottom() + 3) & ~3u);
+        }
+        atlas.page_pixels_.resize(atlas.pages_.size());
+        for (size_t page = 0; page < atlas.pages_.size(); page++)
+            atlas.page_pixels_[page].assign(size_t(atlas.pages_[page].width_) * atlas.pages_[page].height_ * 4, 0);
+        for (size_t i = 0; i < uniques.size(); i++)
+            if (packed[i])
+                blitExtruded(frames[uniques[i].frame_], uniques[i], padding, atlas.page_pixels_[uniques[i].page_],
+                             atlas.pages_[uniques[i].page_].width_);
+
+        // one entry per frame, duplicates pointing at the rect of their unique image
+        atlas.sprites_.reserve(frames.size());
+        for (size_t i = 0; i < frames.size(); i++) {
+            const UniqueImage& unique = uniques[trimmed[i].unique_];
+            if (!packed[trimmed[i].unique_])
+                continue;
+            const SpriteFrame&     frame = frames[i];
+            const SpriteAtlasPage& page  = atlas.pages_[unique.page_];
+            const PackRect&        trim  = trimmed[i].trim_;
+            SpriteAtlasSprite sprite{};
+            sprite.name_hash_     = fnv1a64(std::string_view{frame.name_});
+            sprite.page_          = static_cast<uint16_t>(unique.page_);
+            sprite.x_             = static_cast<uint16_t>(unique.placed_.x_ + padding);
+            sprite.y_             = static_cast<uint16_t>(unique.placed_.y_ + padding);
+            sprite.width_         = static_cast<uint16_t>(trim.width_);
+            sprite.height_        = static_cast<uint16_t>(trim.height_);
+            sprite.source_width_  = static_cast<uint16_t>(frame.width_);
+            sprite.source_height_ = static_cast<uint16_t>(frame.height_);
+            sprite.uv_min_[0]     = float(sprite.x_) / page.width_;
+            sprite.uv_min_[1]     = float(sprite.y_) / page.height_;
+            sprite.uv_max_[0]     = float(sprite.x_ + sprite.width_) / page.width_;
+            sprite.uv_max_[1]     = float(sprite.y_ + sprite.height_) / page.height_;
+            sprite.pivot_[0]      = (frame.pivot_[0] * frame.width_ - trim.x_) / trim.width_;
+            sprite.pivot_[1]      = (frame.pivot_[1] * frame.height_ - trim.y_) / trim.height_;
+            atlas.sprites_.push_back(sprite);
+        }
+        std::stable_sort(atlas.sprites_.begin(), atlas.sprites_.end(), [](const SpriteAtlasSprite& a, const SpriteAtlasSprite& b) {
+            return a.name_hash_ < b.name_hash_;
+        });
+        auto duplicate = std::adjacent_find(atlas.sprites_.begin(), atlas.sprites_.end(), [](const SpriteAtlasSprite& a, const SpriteAtlasSprite& b) {
+            return a.name_hash_ == b.name_hash_;
+        });
+        if (duplicate != atlas.sprites_.end())
+            std::cout << "Error::SpriteAtlas::Duplicate_Frame_Name, only the first of each name can be found" << std::endl;
+        return atlas;
+    }
+
+    /// @brief write the sprite table and cook every page next to it
+    /// @param atlas_path .hd2datlas output
+    /// @param page_settings how pages are block compressed, atlases usually skip mips so neighbours never blend
+    /// @return true if every file was written
+    bool writeSpriteAtlas(std::string_view atlas_path, const CookedSpriteAtlas& atlas, const TextureCookSettings& page_settings) {
+        if (!atlas.isValid())
+            return false;
+
+        for (size_t page = 0; page < atlas.pages_.size(); page++) {
+            CookedTexture cooked = cookTexture(atlas.page_pixels_[page].data(), int(atlas.pages_[page].width_),
+                                               int(atlas.pages_[page].height_), 4, page_settings);
+            if (!writeCptFile(getSpriteAtlasPagePath(atlas_path, page), cooked))
+                return false;
+        }
+
+        SpriteAtlasHeader header{};
+        std::memcpy(header.magic_, SPRITE_ATLAS_MAGIC, sizeof(SPRITE_ATLAS_MAGIC));
+        header.version_      = SPRITE_ATLAS_VERSION;
+        header.endian_tag_   = SPRITE_ATLAS_ENDIAN_TAG;
+        header.page_count_   = static_cast<uint32_t>(atlas.pages_.size());
+        header.sprite_count_ = static_cast<uint32_t>(atlas.sprites_.size());
+
+        std::string temp_path = std::string{atlas_path} + ".tmp";
+        {
+            std::ofstream output_file_stream(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            output_file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            output_file_stream.write(reinterpret_cast<const char*>(atlas.pages_.data()), atlas.pages_.size() * sizeof(SpriteAtlasPage));
+            output_file_stream.write(reinterpret_cast<const char*>(atlas.sprites_.data()), atlas.sprites_.size() * sizeof(SpriteAtlasSprite));
+            if (!output_file_stream.good()) {
+                std::cout << "Error::SpriteAtlas::File_Not_Successfully_Written " << temp_path << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, std::string{atlas_path}, error);
+        if (error) {
+            std::cout << "Error::SpriteAtlas::File_Not_Successfully_Written " << atlas_path << std::endl;
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+        return true;
+    }
+}
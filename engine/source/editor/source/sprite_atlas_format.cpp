@@ -0,0 +1,43 @@
+#include "editor/include/sprite_atlas_format.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace Hd2d {
+    /// @brief check a mapped atlas before its table is indexed
+    /// @param bytes whole file
+    /// @param size file size
+    /// @return header at bytes, nullptr if the file can't be used as is
+    const SpriteAtlasHeader* validateSpriteAtlas(const unsigned char* bytes, size_t size) noexcept {
+        if (bytes == nullptr || size < sizeof(SpriteAtlasHeader))
+            return nullptr;
+        const SpriteAtlasHeader* header = reinterpret_cast<const SpriteAtlasHeader*>(bytes);
+        if (std::memcmp(header->magic_, SPRITE_ATLAS_MAGIC, sizeof(SPRITE_ATLAS_MAGIC)) != 0 ||
+            header->version_    != SPRITE_ATLAS_VERSION    ||
+            header->endian_tag_ != SPRITE_ATLAS_ENDIAN_TAG)
+            return nullptr;
+
+        const uint64_t table_size = sizeof(SpriteAtlasHeader) + uint64_t(header->page_count_) * sizeof(SpriteAtlasPage) +
+                                    uint64_t(header->sprite_count_) * sizeof(SpriteAtlasSprite);
+        if (table_size > size)
+            return nullptr;
+
+        const SpriteAtlasPage*   pages   = reinterpret_cast<const SpriteAtlasPage*>(header + 1);
+        const SpriteAtlasSprite* sprites = reinterpret_cast<const SpriteAtlasSprite*>(pages + header->page_count_);
+        for (uint32_t i = 0; i < header->sprite_count_; i++) {
+            const SpriteAtlasSprite& sprite = sprites[i];
+            if (sprite.page_ >= header->page_count_ ||
+                uint32_t(sprite.x_) + sprite.width_ > pages[sprite.page_].width_ ||
+                uint32_t(sprite.y_) + sprite.height_ > pages[sprite.page_].height_ ||
+                (i > 0 && sprites[i - 1].name_hash_ > sprite.name_hash_))
+                return nullptr;
+        }
+        return header;
+    }
+
+    std::string getSpriteAtlasPagePath(std::string_view atlas_path, size_t page) {
+        std::filesystem::path page_path{atlas_path};
+        page_path.replace_extension();
+        return page_path.generic_string() + "_" + std::to_string(page) + ".cpt";
+    }
+}
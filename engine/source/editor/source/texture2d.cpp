@@ -1,9 +1,14 @@
 #include "editor/include/texture2d.h"
+#include "editor/include/asset_database.h"
+#include "editor/include/image_kernels.h"
+#include "editor/include/mapped_file.h"
+#include "editor/include/texture_cook.h"
+#include "editor/include/thread_pool.h"
 
+#include <algorithm>
 #include <string>
 #include <string_view>
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <vector>
 
@@ -15,39 +20,110 @@ using std::ofstream;
 using std::ios;
 
 namespace Hd2d {
-    /// @brief load texture from image file to GPU
+    /// @brief decode image file into CPU memory, touches no GL state so it may run on worker threads
     /// @param image_file_path  texture file path
-    /// @return image info
-    std::shared_ptr<Texture2D> Texture2D::loadFromFile(std::string_view image_file_path) {
-        std::shared_ptr<Texture2D> texture2d = std::make_shared<Texture2D>();
+    /// @return decoded pixels, invalid if the file could not be read
+    Image Texture2D::decodeImage(std::string_view image_file_path) {
+        Image image;
 
         // don't flip the image for alignment in OpenGL
-        stbi_set_flip_vertically_on_load(false);
-        int channels_in_file;
+        stbi_set_flip_vertically_on_load_thread(false);
 
         unsigned char* data = stbi_load(
             std::string{image_file_path}.c_str(), 
-            &(texture2d->width_), 
-            &(texture2d->height_), 
-            &channels_in_file, 
+            &(image.width_), 
+            &(image.height_), 
+            &(image.channels_), 
+            0
+        );
+        if (data != nullptr)
+            image.pixels_ = std::shared_ptr<unsigned char>(data, stbi_image_free);
+        else
+            std::cout << "Error::Texture::IMAGE_File_Not_Successfully_Decoded " << image_file_path << std::endl;
+
+        return image;
+    }
+
+    /// @brief decode an image file already in memory (e.g. mapped), safe on worker threads
+    /// @param encoded file bytes
+    /// @param encoded_size byte count
+    /// @return decoded pixels, invalid if the bytes are not a supported image
+    Image Texture2D::decodeImage(const unsigned char* encoded, size_t encoded_size) {
+        Image image;
+
+        // don't flip the image for alignment in OpenGL
+        stbi_set_flip_vertically_on_load_thread(false);
+
+        unsigned char* data = stbi_load_from_memory(
+            encoded, 
+            static_cast<int>(encoded_size), 
+            &(image.width_), 
+            &(image.height_), 
+            &(image.channels_), 
             0
         );
+        if (data != nullptr)
+            image.pixels_ = std::shared_ptr<unsigned char>(data, stbi_image_free);
+        else
+            std::cout << "Error::Texture::IMAGE_Data_Not_Successfully_Decoded" << std::endl;
+
+        return image;
+    }
+
+    /// @brief get a decoded image ready for upload, touches no GL state so it may run on worker threads
+    /// @param image decoded pixels, RGB is replaced by RGBA since GL would widen it on the calling thread anyway
+    /// @param srgb average color channels in linear light when building mips
+    void Texture2D::prepareImage(Image& image, bool srgb) {
+        if (!image.isValid() || image.prepared_)
+            return;
+        const size_t texel_count = size_t(image.width_) * image.height_;
+        if (image.channels_ == 3) {
+            std::shared_ptr<unsigned char> rgba(new unsigned char[texel_count * 4], std::default_delete<unsigned char[]>());
+            expandRgbToRgba(image.pixels_.get(), rgba.get(), texel_count);
+            image.pixels_   = std::move(rgba);
+            image.channels_ = 4;
+            image.opaque_   = true;
+        }
+        image.mips_     = buildMipChain(image.pixels_.get(), uint32_t(image.width_), uint32_t(image.height_), uint32_t(image.channels_), srgb);
+        image.prepared_ = true;
+    }
+
+    /// @brief upload decoded image and its mips to GPU, must run on the thread owning the GL context
+    /// @param image decoded pixels, prepared here when no worker did it
+    /// @return image info
+    std::shared_ptr<Texture2D> Texture2D::uploadImage(const Image& image) {
+        if (image.isValid() && !image.prepared_) {
+            Image prepared = image;
+            prepareImage(prepared);
+            return uploadImage(prepared);
+        }
+
+        std::shared_ptr<Texture2D> texture2d = std::make_shared<Texture2D>();
+        texture2d->width_  = image.width_;
+        texture2d->height_ = image.height_;
 
         int image_data_format = GL_RGB;
-        if (data!= nullptr)
+        // one and two channel images were gray and gray alpha, not red and red green
+        GLint swizzle[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+        if (image.isValid())
         {
             //decide color type according to nums of channel
-            switch (channels_in_file) {
+            switch (image.channels_) {
                 case 1:
-                    image_data_format = GL_ALPHA;
+                    image_data_format = GL_RED;
+                    texture2d->gl_texture_format_ = GL_R8;
+                    swizzle[1] = swizzle[2] = GL_RED;
+                    swizzle[3] = GL_ONE;
                     break;
-                case 3:
-                    image_data_format = GL_RGB;
-                    texture2d->gl_texture_format_=GL_COMPRESSED_RGB;
+                case 2:
+                    image_data_format = GL_RG;
+                    texture2d->gl_texture_format_ = GL_RG8;
+                    swizzle[1] = swizzle[2] = GL_RED;
+                    swizzle[3] = GL_GREEN;
                     break;
                 case 4:
                     image_data_format = GL_RGBA;
-                    texture2d->gl_texture_format_=GL_COMPRESSED_RGBA;
+                    texture2d->gl_texture_format_ = image.opaque_ ? GL_COMPRESSED_RGB : GL_COMPRESSED_RGBA;
                     break;
             }
         }
@@ -55,145 +131,248 @@ namespace Hd2d {
         glGenTextures(1, &(texture2d->gl_texture_id_));
         glBindTexture(GL_TEXTURE_2D, texture2d->gl_texture_id_);
 
+        // rows of one and two channel images aren't 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         // upload normal texture
-        glTexImage2D(GL_TEXTURE_2D, texture2d->mipmap_level_, 
+        glTexImage2D(GL_TEXTURE_2D, 0, 
                     texture2d->gl_texture_format_, texture2d->width_, texture2d->height_, 0, 
-                    image_data_format, GL_UNSIGNED_BYTE, data);
+                    image_data_format, GL_UNSIGNED_BYTE, image.pixels_.get());
+        for (size_t i = 0; i < image.mips_.size(); i++) {
+            const int level = static_cast<int>(i) + 1;
+            glTexImage2D(GL_TEXTURE_2D, level, 
+                        texture2d->gl_texture_format_, std::max(1, image.width_ >> level), std::max(1, image.height_ >> level), 0, 
+                        image_data_format, GL_UNSIGNED_BYTE, image.mips_[i].data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        texture2d->mipmap_level_ = static_cast<int>(image.mips_.size());
 
         configTexture();
-
-        stbi_image_free(data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture2d->mipmap_level_);
+        if (texture2d->mipmap_level_ > 0)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        if (image.channels_ == 1 || image.channels_ == 2)
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
 
         return texture2d;
     }
 
-    /// @brief load texture from compressed image file to GPU
-    /// @param image_file_path compressed texture file path
+    /// @brief load texture from image file to GPU
+    /// @param image_file_path  texture file path
+    /// @param srgb color map whose mips are filtered in linear light, false for data maps
     /// @return image info
-    std::shared_ptr<Texture2D> Texture2D::loadFromCptFile(std::string_view image_file_path) {
-        std::shared_ptr<Texture2D> texture2d = std::make_shared<Texture2D>();
+    std::shared_ptr<Texture2D> Texture2D::loadFromFile(std::string_view image_file_path, bool srgb) {
+        Image image = decodeImage(image_file_path);
+        prepareImage(image, srgb);
+        return uploadImage(image);
+    }
+
+    /// @brief GL enum of a cooked block format, glad only exposes the core RGTC ones
+    /// @return 0 for formats the runtime can't sample
+    static GLenum getGlCompressedFormat(CptFormat format) {
+        constexpr GLenum COMPRESSED_RGB_S3TC_DXT1  = 0x83F0;
+        constexpr GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+        constexpr GLenum COMPRESSED_RGBA_BPTC      = 0x8E8C;
+        switch (format) {
+            case CptFormat::BC1: return COMPRESSED_RGB_S3TC_DXT1;
+            case CptFormat::BC3: return COMPRESSED_RGBA_S3TC_DXT5;
+            case CptFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+            case CptFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+            case CptFormat::BC7: return COMPRESSED_RGBA_BPTC;
+            default:             return 0;
+        }
+    }
 
-        std::ifstream fs{};
-        fs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    /// @brief if the current context can sample a cooked block format, the extension list is read once
+    /// @param format cooked block format
+    /// @return false for formats that have to be decoded from the source image instead
+    bool Texture2D::isCptFormatSupported(CptFormat format) {
+        struct BlockFormatSupport {
+            bool s3tc_ = false;
+            bool bptc_ = false;
+        };
+        // glad here is generated without extension flags, so the context is asked directly
+        static const BlockFormatSupport support = []() {
+            BlockFormatSupport result;
+            GLint major_version = 0;
+            GLint minor_version = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+            glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+            // BPTC is core since 4.2
+            result.bptc_ = major_version > 4 || (major_version == 4 && minor_version >= 2);
+            GLint extension_count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+            for (GLint i = 0; i < extension_count; i++) {
+                const GLubyte* extension = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+                if (extension == nullptr)
+                    continue;
+                const std::string_view name{reinterpret_cast<const char*>(extension)};
+                if (name == "GL_EXT_texture_compression_s3tc")
+                    result.s3tc_ = true;
+                else if (name == "GL_ARB_texture_compression_bptc")
+                    result.bptc_ = true;
+            }
+            return result;
+        }();
+
+        switch (format) {
+            case CptFormat::BC1:
+            case CptFormat::BC3: return support.s3tc_;
+            case CptFormat::BC4:
+            case CptFormat::BC5: return true;
+            case CptFormat::BC7: return support.bptc_;
+            default:             return false;
+        }
+    }
 
-        try {
-            fs.open(std::string{image_file_path}, ios::in | ios::binary);
-            std::stringstream ss{};
-            ss << fs.rdbuf();
-            fs.close();
-            CptFileHead cpt_file_head;
-            ss.read((char*)&cpt_file_head, sizeof(CptFileHead));
-            unsigned char* data =(unsigned char*)malloc(cpt_file_head.compress_size_);
-            ss.read((char*)data, cpt_file_head.compress_size_);
+    /// @brief load texture from compressed image file to GPU, the file is mapped and every level's blocks
+    ///        go to GL straight from the mapping
+    /// @param image_file_path compressed texture file path
+    /// @return image info
+    std::shared_ptr<Texture2D> Texture2D::loadFromCptFile(std::string_view image_file_path) {
+        std::shared_ptr<MappedFile> file = MappedFile::open(image_file_path);
+        if (!file) {
+            std::cout << "Error::Texture::IMAGE_File_Not_Successfully_Read " << image_file_path << std::endl;
+            return std::make_shared<Texture2D>();
+        }
+        const CptFileHead* cpt_file_head = validateCptFile(file->getData(), file->getSize());
+        if (cpt_file_head == nullptr || !isCptFormatSupported(static_cast<CptFormat>(cpt_file_head->format_))) {
+            std::cout << "Error::Texture::CPT_File_Not_Supported " << image_file_path << std::endl;
+            return std::make_shared<Texture2D>();
+        }
+        return uploadCpt(cpt_file_head);
+    }
 
-            texture2d->gl_texture_format_ = cpt_file_head.gl_texture_format_;
-            texture2d->width_ = cpt_file_head.width_;
-            texture2d->height_ = cpt_file_head.height_;
+    /// @brief upload the levels of a validated .cpt in memory
+    /// @param cpt_file_head head of the whole file, see validateCptFile
+    /// @param first_level finest level uploaded, GL_TEXTURE_BASE_LEVEL starts there and finer ones stay empty
+    /// @return image info, width_ and height_ are those of level 0 either way
+    std::shared_ptr<Texture2D> Texture2D::uploadCpt(const CptFileHead* cpt_file_head, uint16_t first_level) {
+        std::shared_ptr<Texture2D> texture2d = std::make_shared<Texture2D>();
+        const CptFormat    format    = static_cast<CptFormat>(cpt_file_head->format_);
+        const GLenum       gl_format = getGlCompressedFormat(format);
+        const CptMipLevel* levels    = getCptLevels(cpt_file_head);
+        const unsigned char* bytes   = reinterpret_cast<const unsigned char*>(cpt_file_head);
+        first_level = std::min<uint16_t>(first_level, cpt_file_head->mip_count_ - 1);
 
-            glGenTextures(1, &(texture2d->gl_texture_id_));
-            glBindTexture(GL_TEXTURE_2D, texture2d->gl_texture_id_);
+        texture2d->gl_texture_format_ = gl_format;
+        texture2d->width_             = static_cast<int>(cpt_file_head->width_);
+        texture2d->height_            = static_cast<int>(cpt_file_head->height_);
+        texture2d->mipmap_level_      = cpt_file_head->mip_count_ - 1;
 
-            // Upload compressoed texture
-            glCompressedTexImage2D(GL_TEXTURE_2D, 0, texture2d->gl_texture_format_, 
-                                    texture2d->width_, texture2d->height_, 0, 
-                                    cpt_file_head.compress_size_, data);
+        glGenTextures(1, &(texture2d->gl_texture_id_));
+        glBindTexture(GL_TEXTURE_2D, texture2d->gl_texture_id_);
 
-            configTexture();
+        // upload the compressed levels, no mips are generated at runtime
+        for (uint16_t i = first_level; i < cpt_file_head->mip_count_; i++)
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, texture2d->gl_texture_format_, 
+                                    levels[i].width_, levels[i].height_, 0, 
+                                    static_cast<GLsizei>(levels[i].size_), bytes + levels[i].offset_);
 
-            delete (data);
-        }
-        catch (std::ifstream::failure e) {
-            std::cout << "Error::Texture::IMAGE_File_Not_Successfully_Read" << std::endl;
+        configTexture();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, first_level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture2d->mipmap_level_);
+        if (texture2d->mipmap_level_ > 0)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        // single channel images were gray, not red
+        if (format == CptFormat::BC4) {
+            GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
         }
 
         return texture2d;
     }
 
-    /// @brief to compress a texture and save it, 
-    ///        info comes from image_file,
-    ///        data comes from GPU, which ensures to be uploaded by LoadFromFile() 
+    /// @brief cook a texture on the CPU and save it, the same as running hd2dTexCook with default settings,
+    ///        no GL context is needed
     /// @param image_file_path normal texture file path
     /// @param save_image_file_path compressed texture saved file path
-    void Texture2D::compressImageFile(std::string_view image_file_path, std::string_view save_image_file_path) {
-        std::shared_ptr<Texture2D> texture2d = loadFromFile(image_file_path);
-
-        // get success or not
-        GLint compress_success=0;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compress_success);
-
-        // get compress size
-        GLint compress_size=0;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compress_size);
-
-        // get compress format
-        GLint compress_format=0;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &compress_format);
-
-        //4. download compressed texture
-        void* img = malloc(compress_size);
-        glGetCompressedTexImage(GL_TEXTURE_2D, 0, img);
-
-        //5. save compressed texture
-        ofstream output_file_stream(std::string{save_image_file_path}, ios::out | ios::binary);
+    /// @return if the compressed texture was written
+    bool Texture2D::compressImageFile(std::string_view image_file_path, std::string_view save_image_file_path) {
+        Image image = decodeImage(image_file_path);
+        if (!image.isValid())
+            return false;
+        CookedTexture cooked = cookTexture(image.pixels_.get(), image.width_, image.height_, image.channels_, TextureCookSettings{});
+        return cooked.isValid() && writeCptFile(save_image_file_path, cooked);
+    }
 
-        CptFileHead cpt_file_head;
-        cpt_file_head.type_[0]           = 'c';
-        cpt_file_head.type_[1]           = 'p';
-        cpt_file_head.type_[2]           = 't';
-        cpt_file_head.mipmap_level_      = texture2d->mipmap_level_;
-        cpt_file_head.width_             = texture2d->width_;
-        cpt_file_head.height_            = texture2d->height_;
-        cpt_file_head.gl_texture_format_ = compress_format;
-        cpt_file_head.compress_size_     = compress_size;
+    /// @brief differ if file exists and if it is a cpt this build can load, reads the head bytes only
+    /// @param image_file_path cpt file path
+    /// @return if true, cpt has generated and usable, files cooked by an older version are cooked again
+    bool Texture2D::isCptFileExist(std::string_view image_file_path) {
+        std::ifstream fs{std::string{image_file_path}, ios::in | ios::binary};
+        CptFileHead file_head{};
+        if (!fs.read(reinterpret_cast<char*>(&file_head), sizeof(file_head)))
+            return false;
+        return isCptHeadValid(file_head);
+    }
 
-        output_file_stream.write((char*)&cpt_file_head, sizeof(CptFileHead));
-        output_file_stream.write((char*)img, compress_size);
-        output_file_stream.close();
+    /// @brief differ if file exists, is a cpt this build can load and was cooked for the color space the caller samples it in
+    /// @param image_file_path cpt file path
+    /// @param srgb the map holds colors, false for normal, specular and other data maps
+    /// @return if true, the cpt can stand in for its source, a data map with gamma filtered mips can't
+    bool Texture2D::isCptFileExist(std::string_view image_file_path, bool srgb) {
+        std::ifstream fs{std::string{image_file_path}, ios::in | ios::binary};
+        CptFileHead file_head{};
+        if (!fs.read(reinterpret_cast<char*>(&file_head), sizeof(file_head)))
+            return false;
+        return isCptHeadValid(file_head) && isCptColorSpace(file_head, srgb);
+    }
 
-        free(img);
+    /// @brief decode image files on the thread pool, nothing here touches GL
+    /// @param image_file_paths texture file paths
+    /// @param prepare also build the mips on the worker, see prepareImage
+    /// @return one in-flight decode per path, in the same order
+    std::vector<std::future<Image>> Texture2D::decodeImages(const std::vector<std::string>& image_file_paths, bool prepare) {
+        std::vector<std::future<Image>> decodes;
+        decodes.reserve(image_file_paths.size());
+        for (const std::string& image_file_path : image_file_paths)
+            decodes.push_back(ThreadPool::getInstance().submit([image_file_path, prepare]() {
+                Image image = decodeImage(image_file_path);
+                if (prepare)
+                    prepareImage(image);
+                return image;
+            }));
+        return decodes;
     }
 
-    /// @brief differ if file exists and if it is cpt format
-    /// @param image_file_path cpt file path
-    /// @return if true, cpt has generated and usable
-    bool Texture2D::isCptFileExist(std::string_view image_file_path) {
-        bool isExist = false;
-        bool isCpt = false;
-        std::ifstream fs{};
-        fs.open(std::string{image_file_path}, ios::in | ios::binary);
-        isExist = fs.good();
-        if (isExist) {
-            std::stringstream ss{};
-            ss << fs.rdbuf();
-            char file_head[3];
-            ss.read(file_head, sizeof(file_head));
-            isCpt = CptFileHead::isCptFile(file_head);
-        }
-        fs.close();
-        return isExist && isCpt;
+    /// @brief load a batch of textures, decoded in parallel and uploaded on the calling (GL) thread
+    /// @param image_file_paths texture file paths
+    /// @return textures in the order of image_file_paths
+    std::vector<std::shared_ptr<Texture2D>> Texture2D::loadFromFiles(const std::vector<std::string>& image_file_paths) {
+        ThreadPool& pool = ThreadPool::getInstance();
+        std::vector<std::future<Image>> decodes = decodeImages(image_file_paths, true);
+        std::vector<std::shared_ptr<Texture2D>> textures(decodes.size());
+        // upload in completion order so one large file doesn't hold back the ones already decoded
+        for (size_t i = pool.waitAny(decodes); i < decodes.size(); i = pool.waitAny(decodes))
+            textures[i] = uploadImage(decodes[i].get());
+        return textures;
     }
 
+    /// @brief load six faces into a cube map, faces are decoded in parallel and uploaded as they finish
+    /// @param faces +x, -x, +y, -y, +z, -z face file paths
+    /// @return cube map texture
     std::shared_ptr<Texture2D> Texture2D::loadCubemap(std::vector<std::string>& faces) {
+        ThreadPool& pool = ThreadPool::getInstance();
+        std::vector<std::future<Image>> decodes = decodeImages(faces);
+
         std::shared_ptr<Texture2D> texture2d = std::make_shared<Texture2D>();
         glGenTextures(1, &(texture2d->gl_texture_id_));
         glBindTexture(GL_TEXTURE_CUBE_MAP, texture2d->gl_texture_id_);
 
-        // skybox normally has rgb without a
-        int channels_in_file;
-        for (unsigned int i = 0; i < faces.size(); i++)
+        for (size_t i = pool.waitAny(decodes); i < decodes.size(); i = pool.waitAny(decodes))
         {
-            unsigned char *data = stbi_load(faces[i].c_str(), 
-            &texture2d->width_, &texture2d->height_, &channels_in_file, 0);
-            if (data)
-            {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, texture2d->width_, texture2d->height_, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-                stbi_image_free(data);
-            }
-            else
+            Image image = decodes[i].get();
+            if (!image.isValid())
             {
                 std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-                stbi_image_free(data);
+                continue;
             }
+            texture2d->width_  = image.width_;
+            texture2d->height_ = image.height_;
+            // skybox normally has rgb without a
+            GLenum image_data_format = image.channels_ == 4 ? GL_RGBA : GL_RGB;
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), 0, GL_RGB, image.width_, image.height_, 0, 
+                         image_data_format, GL_UNSIGNED_BYTE, image.pixels_.get());
         }
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -206,13 +385,21 @@ namespace Hd2d {
 
     /// @brief Load texture from image file path
     /// @param cpt_path default load path
-    /// @param png_path if cpt path is invalid, load from png path
+    /// @param png_path if cpt path is missing or was cooked from other content or settings, it is cooked again from png path.
+    ///        a cpt this context can't sample is skipped and png path loaded instead
     /// @return texture description of image
     std::shared_ptr<Texture2D> Texture2D::loadTexture(std::string_view png_path, std::string_view cpt_path) {
-        if (!isCptFileExist(cpt_path)) {
-            compressImageFile(png_path, cpt_path);
+        AssetDatabase& asset_database = AssetDatabase::getInstance();
+        const std::vector<std::string> dependencies = {std::string{png_path}};
+        const uint64_t settings_hash = hashTextureCookSettings(TextureCookSettings{});
+        if (!asset_database.isUpToDate(cpt_path, dependencies, TEXTURE_COOKER_VERSION, settings_hash) || !isCptFileExist(cpt_path)) {
+            if (compressImageFile(png_path, cpt_path))
+                asset_database.record(cpt_path, dependencies, TEXTURE_COOKER_VERSION, settings_hash);
         }
-        return loadFromCptFile(cpt_path);    
+        std::shared_ptr<Texture2D> texture = loadFromCptFile(cpt_path);
+        if (texture->getTextureId() == 0)
+            texture = loadFromFile(png_path);
+        return texture;
     }
 
     /// @brief general config texture
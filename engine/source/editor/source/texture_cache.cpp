@@ -0,0 +1,97 @@
+#include "editor/include/texture_cache.h"
+#include "editor/include/hash.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace Hd2d {
+    TextureCache& TextureCache::getInstance() {
+        static TextureCache texture_cache;
+        return texture_cache;
+    }
+
+    /// @brief turn a texture path into its cache key
+    /// @param texture_path path as written by the model or the user
+    /// @return path with '.' and '..' resolved and '/' separators, lower case on Windows
+    std::string TextureCache::normalizePath(std::string_view texture_path) {
+        std::string normalized = std::filesystem::path{texture_path}.lexically_normal().generic_string();
+#ifdef _WIN32
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+        return normalized;
+    }
+
+    TextureCache::Shard<std::string>& TextureCache::getShard(const std::string& normalized_path) {
+        return path_shards_[fnv1a64(normalized_path) % SHARD_COUNT];
+    }
+
+    TextureCache::Shard<uint64_t>& TextureCache::getShard(uint64_t content_hash) {
+        return hash_shards_[content_hash % SHARD_COUNT];
+    }
+
+    std::shared_ptr<Texture2D> TextureCache::findByPath(const std::string& normalized_path) {
+        Shard<std::string>& shard = getShard(normalized_path);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        auto it = shard.entries_.find(normalized_path);
+        if (it == shard.entries_.end())
+            return nullptr;
+        std::shared_ptr<Texture2D> texture = it->second.lock();
+        if (!texture)
+            shard.entries_.erase(it);
+        return texture;
+    }
+
+    std::shared_ptr<Texture2D> TextureCache::findByHash(uint64_t content_hash) {
+        Shard<uint64_t>& shard = getShard(content_hash);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        auto it = shard.entries_.find(content_hash);
+        if (it == shard.entries_.end())
+            return nullptr;
+        std::shared_ptr<Texture2D> texture = it->second.lock();
+        if (!texture)
+            shard.entries_.erase(it);
+        return texture;
+    }
+
+    /// @brief publish an uploaded texture, must run on the thread owning the GL context
+    /// @param normalized_path key from normalizePath
+    /// @param content_hash FNV-1a of the texture file
+    /// @param texture freshly uploaded texture, its GL texture is deleted if it lost a race
+    /// @return the cached texture
+    std::shared_ptr<Texture2D> TextureCache::insert(const std::string& normalized_path, uint64_t content_hash,
+                                                    std::shared_ptr<Texture2D> texture) {
+        std::shared_ptr<Texture2D> cached;
+        {
+            Shard<uint64_t>& shard = getShard(content_hash);
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            std::weak_ptr<Texture2D>& entry = shard.entries_[content_hash];
+            cached = entry.lock();
+            if (!cached) {
+                // the last reference deletes the GL texture
+                cached = std::shared_ptr<Texture2D>(new Texture2D(*texture), [](Texture2D* cached_texture) {
+                    GLuint texture_id = cached_texture->getTextureId();
+                    glDeleteTextures(1, &texture_id);
+                    delete cached_texture;
+                });
+                cached->setPath(normalized_path);
+                entry   = cached;
+                texture = nullptr;
+            }
+        }
+
+        if (texture) {
+            GLuint texture_id = texture->getTextureId();
+            glDeleteTextures(1, &texture_id);
+        }
+        alias(normalized_path, cached);
+        return cached;
+    }
+
+    void TextureCache::alias(const std::string& normalized_path, const std::shared_ptr<Texture2D>& texture) {
+        Shard<std::string>& shard = getShard(normalized_path);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.entries_[normalized_path] = texture;
+    }
+}
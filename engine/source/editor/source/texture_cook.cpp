@@ -0,0 +1,207 @@
+#include "editor/include/texture_cook.h"
+#include "editor/include/bc_encoder.h"
+#include "editor/include/hash.h"
+#include "editor/include/image_kernels.h"
+#include "editor/include/thread_pool.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+
+namespace Hd2d {
+    namespace {
+        struct MipImage {
+            uint32_t             width_  = 0;
+            uint32_t             height_ = 0;
+            std::vector<uint8_t> rgba_;
+        };
+
+        /// @brief widen any channel count to RGBA8, gray goes to every color channel like GL luminance
+        std::vector<uint8_t> expandToRgba(const unsigned char* pixels, size_t texel_count, int channels) {
+            std::vector<uint8_t> rgba(texel_count * 4);
+            if (channels == 3) {
+                expandRgbToRgba(pixels, rgba.data(), texel_count);
+                return rgba;
+            }
+            for (size_t i = 0; i < texel_count; i++) {
+                const unsigned char* source = pixels + i * channels;
+                uint8_t* target = rgba.data() + i * 4;
+                switch (channels) {
+                    case 1:
+                        target[0] = target[1] = target[2] = source[0];
+                        target[3] = 255;
+                        break;
+                    case 2:
+                        target[0] = source[0];
+                        target[1] = source[1];
+                        target[2] = 0;
+                        target[3] = 255;
+                        break;
+                    default:
+                        std::copy(source, source + 4, target);
+                        break;
+                }
+            }
+            return rgba;
+        }
+
+        /// @brief compress one level, a task per block row
+        /// @param level mip pixels, partial edge blocks repeat the last row and column
+        /// @param blocks output, getCptLevelSize bytes
+        void encodeLevel(const MipImage& level, CptFormat format, unsigned char* blocks) {
+            const uint32_t block_columns = (level.width_ + 3) / 4;
+            const uint32_t block_rows    = (level.height_ + 3) / 4;
+            const uint32_t block_bytes   = getCptBlockBytes(format);
+
+            ThreadPool::getInstance().parallelFor(block_rows, [&](size_t block_row) {
+                uint8_t texels[64];
+                for (uint32_t block_column = 0; block_column < block_columns; block_column++) {
+                    for (uint32_t y = 0; y < 4; y++) {
+                        const uint32_t source_y = std::min(uint32_t(block_row) * 4 + y, level.height_ - 1);
+                        for (uint32_t x = 0; x < 4; x++) {
+                            const uint32_t source_x = std::min(block_column * 4 + x, level.width_ - 1);
+                            std::copy_n(level.rgba_.data() + (size_t(source_y) * level.width_ + source_x) * 4, 4, texels + (y * 4 + x) * 4);
+                        }
+                    }
+                    unsigned char* block = blocks + (block_row * block_columns + block_column) * block_bytes;
+                    switch (format) {
+                        case CptFormat::BC1: encodeBc1Block(texels, block); break;
+                        case CptFormat::BC3: encodeBc3Block(texels, block); break;
+                        case CptFormat::BC4: encodeBc4Block(texels, block); break;
+                        case CptFormat::BC5: encodeBc5Block(texels, block); break;
+                        default:             encodeBc7Block(texels, block); break;
+                    }
+                }
+            });
+        }
+    }
+
+    uint64_t hashTextureCookSettings(const TextureCookSettings& settings) noexcept {
+        // field by field, the struct's padding bytes are unspecified
+        const uint8_t fields[4] = {static_cast<uint8_t>(settings.format_), settings.srgb_, settings.mip_chain_, settings.premultiply_alpha_};
+        return fnv1a64(fields, sizeof(fields));
+    }
+
+    CptFormat chooseCptFormat(const unsigned char* pixels, int width, int height, int channels) noexcept {
+        switch (channels) {
+            case 1: return CptFormat::BC4;
+            case 2: return CptFormat::BC5;
+            case 3: return CptFormat::BC1;
+        }
+        const size_t texel_count = size_t(width) * height;
+        for (size_t i = 0; i < texel_count; i++)
+            if (pixels[i * 4 + 3] != 255)
+                return CptFormat::BC7;
+        return CptFormat::BC1;
+    }
+
+    /// @brief cook decoded pixels into a block compressed mip chain
+    /// @param pixels width * height texels of channels bytes, as stbi_load returns them
+    /// @param settings format, color space and whether to build mips
+    /// @return cooked texture, invalid if the input is empty
+    CookedTexture cookTexture(const unsigned char* pixels, int width, int height, int channels, const TextureCookSettings& settings) {
+        CookedTexture texture;
+        if (pixels == nullptr || width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+            std::cout << "Error::TextureCook::Invalid_Source_Image" << std::endl;
+            return texture;
+        }
+
+        const CptFormat format = settings.format_ != CptFormat::Unknown ? settings.format_ : chooseCptFormat(pixels, width, height, channels);
+        const bool      srgb   = settings.srgb_ && isCptColorFormat(format);
+
+        uint32_t mip_count = 1;
+        if (settings.mip_chain_)
+            while ((std::max(width, height) >> mip_count) > 0)
+                mip_count++;
+
+        // each level halves the one above it, filtering every level from level 0 costs a full pass over it per level
+        std::vector<MipImage> levels(mip_count);
+        levels[0].width_  = uint32_t(width);
+        levels[0].height_ = uint32_t(height);
+        levels[0].rgba_   = expandToRgba(pixels, size_t(width) * height, channels);
+        if (settings.premultiply_alpha_ && channels == 4)
+            premultiplyAlpha(levels[0].rgba_.data(), size_t(width) * height);
+        const int alpha_channel = channels == 4 ? 3 : STBIR_ALPHA_CHANNEL_NONE;
+        const int alpha_flags   = settings.premultiply_alpha_ ? STBIR_FLAG_ALPHA_PREMULTIPLIED : 0;
+        for (uint32_t i = 1; i < mip_count; i++) {
+            const MipImage& source = levels[i - 1];
+            MipImage&       level  = levels[i];
+            level.width_  = std::max(1u, source.width_ / 2);
+            level.height_ = std::max(1u, source.height_ / 2);
+            level.rgba_.resize(size_t(level.width_) * level.height_ * 4);
+            if (srgb)
+                stbir_resize_uint8_srgb(source.rgba_.data(), int(source.width_), int(source.height_), 0,
+                                        level.rgba_.data(), int(level.width_), int(level.height_), 0, 4, alpha_channel, alpha_flags);
+            else
+                stbir_resize_uint8(source.rgba_.data(), int(source.width_), int(source.height_), 0,
+                                   level.rgba_.data(), int(level.width_), int(level.height_), 0, 4);
+        }
+
+        uint64_t offset = sizeof(CptFileHead) + mip_count * sizeof(CptMipLevel);
+        texture.levels_.resize(mip_count);
+        for (uint32_t i = 0; i < mip_count; i++) {
+            CptMipLevel& level = texture.levels_[i];
+            level.width_  = levels[i].width_;
+            level.height_ = levels[i].height_;
+            level.offset_ = offset;
+            level.size_   = getCptLevelSize(format, level.width_, level.height_);
+            offset       += level.size_;
+        }
+        const uint64_t data_offset = texture.levels_[0].offset_;
+        texture.data_.resize(offset - data_offset);
+        for (uint32_t i = 0; i < mip_count; i++)
+            encodeLevel(levels[i], format, texture.data_.data() + (texture.levels_[i].offset_ - data_offset));
+
+        CptFileHead& head = texture.head_;
+        head.type_[0]    = 'c';
+        head.type_[1]    = 'p';
+        head.type_[2]    = 't';
+        head.version_    = CPT_VERSION;
+        head.endian_tag_ = CPT_ENDIAN_TAG;
+        head.format_     = static_cast<uint8_t>(format);
+        head.flags_      = srgb ? CPT_FLAG_SRGB : 0;
+        head.mip_count_  = static_cast<uint16_t>(mip_count);
+        head.width_      = uint32_t(width);
+        head.height_     = uint32_t(height);
+        head.data_size_  = texture.data_.size();
+        return texture;
+    }
+
+    /// @brief write a cooked texture, through a temporary file so a crash never leaves half a .cpt behind
+    /// @param cpt_path output path
+    /// @return true on success
+    bool writeCptFile(std::string_view cpt_path, const CookedTexture& texture) {
+        if (!texture.isValid())
+            return false;
+
+        std::string temp_path = std::string{cpt_path} + ".tmp";
+        {
+            std::ofstream output_file_stream(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            output_file_stream.write(reinterpret_cast<const char*>(&texture.head_), sizeof(CptFileHead));
+            output_file_stream.write(reinterpret_cast<const char*>(texture.levels_.data()), texture.levels_.size() * sizeof(CptMipLevel));
+            output_file_stream.write(reinterpret_cast<const char*>(texture.data_.data()), texture.data_.size());
+            if (!output_file_stream.good()) {
+                std::cout << "Error::TextureCook::File_Not_Successfully_Written " << temp_path << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, std::string{cpt_path}, error);
+        if (error) {
+            std::cout << "Error::TextureCook::File_Not_Successfully_Written " << cpt_path << std::endl;
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+        return true;
+    }
+
+    std::string getCookedTexturePath(std::string_view image_path) {
+        return std::filesystem::path{image_path}.replace_extension(".cpt").generic_string();
+    }
+}
@@ -0,0 +1,191 @@
+#include "editor/include/texture_streamer.h"
+#include "editor/include/texture_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace Hd2d {
+    TextureStreamer& TextureStreamer::getInstance() {
+        static TextureStreamer texture_streamer;
+        return texture_streamer;
+    }
+
+    /// @brief map a cooked texture and upload the levels that are never streamed out
+    /// @param cpt_path .cpt file, e.g. getCookedTexturePath of a model texture
+    /// @return streamed texture, nullptr if the file can't be loaded
+    std::shared_ptr<Texture2D> TextureStreamer::load(std::string_view cpt_path) {
+        std::string normalized_path = TextureCache::normalizePath(cpt_path);
+        auto path_it = paths_.find(normalized_path);
+        if (path_it != paths_.end()) {
+            if (std::shared_ptr<Texture2D> texture = path_it->second.lock())
+                return texture;
+            paths_.erase(path_it);
+        }
+
+        std::shared_ptr<MappedFile> file = MappedFile::open(normalized_path);
+        const CptFileHead* head = file ? validateCptFile(file->getData(), file->getSize()) : nullptr;
+        if (head == nullptr || !Texture2D::isCptFormatSupported(static_cast<CptFormat>(head->format_))) {
+            std::cout << "Error::TextureStreamer::CPT_File_Not_Supported " << cpt_path << std::endl;
+            return nullptr;
+        }
+
+        Entry entry;
+        entry.file_        = file;
+        entry.head_        = head;
+        entry.floor_level_ = head->mip_count_ - 1;
+        const CptMipLevel* levels = getCptLevels(head);
+        for (uint16_t level = 0; level < head->mip_count_; level++) {
+            if (std::max(levels[level].width_, levels[level].height_) <= STREAMING_RESIDENT_SIZE) {
+                entry.floor_level_ = level;
+                break;
+            }
+        }
+        entry.resident_level_ = entry.floor_level_;
+        entry.wanted_level_   = entry.floor_level_;
+        for (uint16_t level = entry.floor_level_; level < head->mip_count_; level++)
+            entry.resident_bytes_ += getLevelSize(entry, level);
+        makeRoom(entry.resident_bytes_);
+
+        std::shared_ptr<Texture2D> uploaded = Texture2D::uploadCpt(head, entry.floor_level_);
+        const GLuint texture_id = uploaded->getTextureId();
+        entry.gl_format_ = uploaded->getTextureFormat();
+        // the last reference deletes the GL texture and stops its streaming
+        std::shared_ptr<Texture2D> texture(new Texture2D(*uploaded), [this](Texture2D* streamed_texture) {
+            GLuint streamed_id = streamed_texture->getTextureId();
+            auto it = entries_.find(streamed_id);
+            if (it != entries_.end()) {
+                resident_bytes_ -= it->second.resident_bytes_;
+                entries_.erase(it);
+            }
+            glDeleteTextures(1, &streamed_id);
+            delete streamed_texture;
+        });
+        texture->setPath(normalized_path);
+        entry.texture_ = texture;
+
+        resident_bytes_ += entry.resident_bytes_;
+        entries_[texture_id]     = std::move(entry);
+        paths_[normalized_path]  = texture;
+        return texture;
+    }
+
+    void TextureStreamer::request(GLuint texture_id, float screen_pixels) noexcept {
+        auto it = entries_.find(texture_id);
+        if (it == entries_.end())
+            return;
+        Entry& entry = it->second;
+        if (entry.last_needed_frame_ != frame_)
+            entry.demand_pixels_ = 0.0f;
+        entry.demand_pixels_     = std::max(entry.demand_pixels_, screen_pixels);
+        entry.last_needed_frame_ = frame_;
+    }
+
+    /// @brief level whose texels match the demanded pixels, never finer than needed nor coarser than the floor
+    uint16_t TextureStreamer::getWantedLevel(const Entry& entry) {
+        if (entry.demand_pixels_ <= 0.0f)
+            return entry.floor_level_;
+        const float size  = static_cast<float>(std::max(entry.head_->width_, entry.head_->height_));
+        const float level = std::floor(std::log2(size / entry.demand_pixels_));
+        if (level <= 0.0f)
+            return 0;
+        return static_cast<uint16_t>(std::min(level, static_cast<float>(entry.floor_level_)));
+    }
+
+    size_t TextureStreamer::getLevelSize(const Entry& entry, uint16_t level) {
+        return static_cast<size_t>(getCptLevels(entry.head_)[level].size_);
+    }
+
+    /// @brief upload the next finer level straight from the mapping and start sampling from it
+    void TextureStreamer::uploadLevel(GLuint texture_id, Entry& entry) {
+        const uint16_t     level      = entry.resident_level_ - 1;
+        const CptMipLevel& level_info = getCptLevels(entry.head_)[level];
+        glBindTexture(GL_TEXTURE_2D, texture_id);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, entry.gl_format_, level_info.width_, level_info.height_, 0,
+                               static_cast<GLsizei>(level_info.size_), entry.file_->getData() + level_info.offset_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+        entry.resident_level_  = level;
+        entry.resident_bytes_ += level_info.size_;
+        resident_bytes_       += level_info.size_;
+    }
+
+    /// @brief stop sampling the finest level and free it, drivers release the storage of a level respecified as 0x0
+    void TextureStreamer::evictLevel(GLuint texture_id, Entry& entry) {
+        const uint16_t level = entry.resident_level_;
+        const size_t   bytes = getLevelSize(entry, level);
+        glBindTexture(GL_TEXTURE_2D, texture_id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, entry.gl_format_, 0, 0, 0, 0, nullptr);
+
+        entry.resident_level_  = level + 1;
+        entry.resident_bytes_ -= bytes;
+        resident_bytes_       -= bytes;
+    }
+
+    /// @brief evict until bytes more fit the budget, only levels finer than what their texture wants are candidates
+    /// @param bytes about to be uploaded
+    /// @return false if the budget is spent on levels wanted this frame
+    bool TextureStreamer::makeRoom(size_t bytes) {
+        while (resident_bytes_ + bytes > budget_) {
+            auto victim = entries_.end();
+            for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                const Entry& entry = it->second;
+                const uint16_t keep_level = entry.last_needed_frame_ == frame_ ? entry.wanted_level_ : entry.floor_level_;
+                if (entry.resident_level_ >= keep_level)
+                    continue;
+                // least recently needed first, then whichever frees the most
+                if (victim == entries_.end() || entry.last_needed_frame_ < victim->second.last_needed_frame_ ||
+                    (entry.last_needed_frame_ == victim->second.last_needed_frame_ &&
+                     getLevelSize(entry, entry.resident_level_) > getLevelSize(victim->second, victim->second.resident_level_)))
+                    victim = it;
+            }
+            if (victim == entries_.end())
+                return false;
+            evictLevel(victim->first, victim->second);
+        }
+        return true;
+    }
+
+    void TextureStreamer::update() {
+        std::vector<GLuint> pending;
+        for (auto& [texture_id, entry] : entries_) {
+            if (entry.last_needed_frame_ == frame_)
+                entry.wanted_level_ = getWantedLevel(entry);
+            if (entry.resident_level_ > entry.wanted_level_ && entry.last_needed_frame_ == frame_)
+                pending.push_back(texture_id);
+        }
+        // a lowered budget is honoured even when nothing new is wanted
+        makeRoom(0);
+
+        // furthest from their wanted level first, then one level per texture per pass so all sharpen together
+        std::sort(pending.begin(), pending.end(), [this](GLuint a, GLuint b) {
+            const Entry& entry_a = entries_.at(a);
+            const Entry& entry_b = entries_.at(b);
+            return entry_a.resident_level_ - entry_a.wanted_level_ > entry_b.resident_level_ - entry_b.wanted_level_;
+        });
+        size_t uploaded = 0;
+        bool   progress = true;
+        while (progress) {
+            progress = false;
+            for (GLuint texture_id : pending) {
+                Entry& entry = entries_.at(texture_id);
+                if (entry.resident_level_ <= entry.wanted_level_)
+                    continue;
+                const size_t bytes = getLevelSize(entry, entry.resident_level_ - 1);
+                if (uploaded > 0 && uploaded + bytes > upload_limit_) {
+                    progress = false;
+                    break;
+                }
+                if (!makeRoom(bytes))
+                    continue;
+                uploadLevel(texture_id, entry);
+                uploaded += bytes;
+                progress  = true;
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        frame_++;
+    }
+}
@@ -0,0 +1,104 @@
+#include "editor/include/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace Hd2d {
+    ThreadPool::ThreadPool(unsigned int thread_count) : stopping_{false} {
+        thread_count = std::max(1u, thread_count);
+        workers_.reserve(thread_count);
+        for (unsigned int i = 0; i < thread_count; i++)
+            workers_.emplace_back([this]() { workerLoop(); });
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        for (std::thread& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPool& ThreadPool::getInstance() {
+        // keep one core for the thread owning the GL context
+        unsigned int cores = std::thread::hardware_concurrency();
+        static ThreadPool instance(cores > 1 ? cores - 1 : 1);
+        return instance;
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+        if (count == 0)
+            return;
+
+        std::atomic<size_t> next{0};
+        auto drain = [&next, count, &body]() {
+            try {
+                for (size_t i = next++; i < count; i = next++)
+                    body(i);
+            }
+            catch (...) {
+                // the other threads stop at their next index
+                next = count;
+                throw;
+            }
+        };
+
+        size_t helpers = std::min(count - 1, workers_.size());
+        std::vector<std::future<void>> futures;
+        futures.reserve(helpers);
+        for (size_t i = 0; i < helpers; i++)
+            futures.push_back(submit(drain));
+
+        // helpers hold references to next and body, every one has to finish before this frame unwinds
+        std::exception_ptr error;
+        try {
+            drain();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        for (std::future<void>& future : futures) {
+            wait(future);
+            try {
+                future.get();
+            }
+            catch (...) {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void ThreadPool::workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    bool ThreadPool::runPendingTask() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (tasks_.empty())
+                return false;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+        return true;
+    }
+}
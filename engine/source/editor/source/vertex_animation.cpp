@@ -0,0 +1,280 @@
+#include "editor/include/vertex_animation.h"
+#include "editor/include/geometry_buffer.h"
+#include "editor/include/thread_pool.h"
+#include "editor/include/vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace Hd2d {
+    namespace {
+        // set for every draw, see vertex_animation.vs
+        constexpr UniformId VAT_POSITIONS_UNIFORM{"vatPositions"};
+        constexpr UniformId VAT_NORMALS_UNIFORM{"vatNormals"};
+        constexpr UniformId VAT_FIRST_VERTEX_UNIFORM{"vatFirstVertex"};
+        constexpr UniformId VAT_VERTEX_COUNT_UNIFORM{"vatVertexCount"};
+        constexpr UniformId VAT_FRAME_COUNT_UNIFORM{"vatFrameCount"};
+        constexpr UniformId VAT_FRAME_RATE_UNIFORM{"vatFrameRate"};
+        constexpr UniformId TIME_UNIFORM{"time"};
+
+        // rest pose of a vertex with what it takes to pose it
+        struct RestVertex {
+            glm::vec3  position_ = glm::vec3(0.0f);
+            glm::vec3  normal_   = glm::vec3(0.0f, 0.0f, 1.0f);
+            glm::uvec4 bone_ids_ = glm::uvec4(0u);
+            glm::vec4  weights_  = glm::vec4(0.0f);
+            uint32_t   node_     = 0;  // static vertices follow their node
+            bool       skinned_  = false;
+        };
+
+        void decodeVertices(const Mesh& mesh, uint32_t node, RestVertex* rest_vertices) {
+            const GeometryBuffer& geometry = *mesh.getGeometry();
+            const VertexLayout    layout   = geometry.getLayout();
+            const size_t          stride   = getVertexStride(layout);
+            std::vector<unsigned char> vertices;
+            std::vector<SkinVertex>    skin;
+            geometry.read(mesh.getGeometryRange(), vertices, skin);
+
+            const size_t vertex_count = mesh.getGeometryRange().vertex_count_;
+            for (size_t i = 0; i < vertex_count; i++) {
+                const unsigned char* packed = vertices.data() + i * stride;
+                RestVertex& rest = rest_vertices[i];
+                rest.node_ = node;
+                if (layout == VertexLayout::Full) {
+                    Vertex vertex;
+                    std::memcpy(&vertex, packed, sizeof(vertex));
+                    rest.position_ = vertex.position_;
+                    rest.normal_   = vertex.normal_;
+                    for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+                        rest.bone_ids_[k] = static_cast<unsigned int>(std::max(vertex.boneIDs_[k], 0));
+                        rest.weights_[k]  = vertex.weights_[k];
+                    }
+                } else {
+                    std::memcpy(&rest.position_, packed, sizeof(rest.position_));
+                    if (layout == VertexLayout::Compact) {
+                        CompactVertex vertex;
+                        std::memcpy(&vertex, packed, sizeof(vertex));
+                        rest.normal_ = unpackOctNormal(vertex.normal_);
+                    } else {
+                        CompactTangentFrameVertex vertex;
+                        std::memcpy(&vertex, packed, sizeof(vertex));
+                        uint64_t tangent_frame;
+                        std::memcpy(&tangent_frame, vertex.tangentFrame_, sizeof(tangent_frame));
+                        rest.normal_ = unpackTangentFrameNormal(tangent_frame);
+                    }
+                    if (!skin.empty())
+                        for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+                            rest.bone_ids_[k] = skin[i].boneIDs_[k];
+                            rest.weights_[k]  = skin[i].weights_[k] / 255.0f;
+                        }
+                }
+                // same rule as skinMatrix() in the shaders
+                rest.skinned_ = mesh.isSkinned() && rest.weights_.x + rest.weights_.y + rest.weights_.z + rest.weights_.w > 0.0f;
+            }
+        }
+    }
+
+    /// @brief bake a looping clip into vertex animation frames
+    /// @param model skinned model, its meshes must be the only ones in their part of the geometry buffer
+    /// @param clip one of the model's clips
+    /// @param frame_rate frames per second to sample at, rounded so the frames span the clip exactly
+    /// @return bake, invalid for static models
+    VertexAnimationBake bakeVertexAnimation(const Model& model, const AnimationClip& clip, float frame_rate) {
+        VertexAnimationBake bake;
+        const std::shared_ptr<Skeleton>& skeleton = model.getSkeleton();
+        const std::vector<Mesh>&         meshes   = model.getMeshes();
+        if (model.getGeometry() == nullptr || skeleton == nullptr || meshes.empty() || frame_rate <= 0.0f) {
+            std::cout << "Error::VertexAnimation::Model_Not_Skinned " << clip.name_ << std::endl;
+            return bake;
+        }
+
+        // a model's meshes are allocated back to back
+        size_t first_vertex = std::numeric_limits<size_t>::max();
+        size_t end_vertex   = 0;
+        for (const Mesh& mesh : meshes) {
+            const GeometryRange& range = mesh.getGeometryRange();
+            first_vertex = std::min(first_vertex, static_cast<size_t>(range.base_vertex_));
+            end_vertex   = std::max(end_vertex, range.base_vertex_ + range.vertex_count_);
+        }
+        if (end_vertex <= first_vertex)
+            return bake;
+
+        std::vector<RestVertex> rest_vertices(end_vertex - first_vertex);
+        const std::vector<ModelNode>& nodes = model.getNodes();
+        for (size_t node = 0; node < nodes.size(); node++)
+            for (unsigned int mesh = nodes[node].first_mesh_; mesh < nodes[node].first_mesh_ + nodes[node].mesh_count_; mesh++)
+                decodeVertices(meshes[mesh], static_cast<uint32_t>(node),
+                               &rest_vertices[meshes[mesh].getGeometryRange().base_vertex_ - first_vertex]);
+
+        bake.first_vertex_ = static_cast<uint32_t>(first_vertex);
+        bake.vertex_count_ = static_cast<uint32_t>(rest_vertices.size());
+        bake.frame_count_  = static_cast<uint32_t>(std::max(1l, std::lround(clip.duration_ * frame_rate)));
+        bake.frame_rate_   = clip.duration_ > 0.0f ? bake.frame_count_ / clip.duration_ : frame_rate;
+        const size_t texel_count = static_cast<size_t>(bake.vertex_count_) * bake.frame_count_;
+        bake.width_  = static_cast<uint32_t>(std::min<size_t>(texel_count, VAT_TEXTURE_WIDTH));
+        bake.height_ = static_cast<uint32_t>((texel_count + bake.width_ - 1) / bake.width_);
+        bake.positions_.assign(static_cast<size_t>(bake.width_) * bake.height_, glm::vec3(0.0f));
+        bake.normals_.assign(bake.positions_.size(), glm::vec3(0.0f, 0.0f, 1.0f));
+
+        // frames are independent, each worker poses its own
+        ThreadPool::getInstance().parallelFor(bake.frame_count_, [&](size_t frame) {
+            std::vector<glm::mat4> local_transforms(skeleton->bind_transforms_);
+            std::vector<glm::mat4> global_transforms;
+            clip.sample(frame / bake.frame_rate_, local_transforms);
+            skeleton->computeGlobalTransforms(local_transforms, global_transforms);
+
+            const size_t bone_count = std::min<size_t>(skeleton->getBoneCount(), MAX_SKELETON_BONES);
+            std::vector<glm::mat4> palette(bone_count);
+            for (size_t bone = 0; bone < bone_count; bone++)
+                palette[bone] = global_transforms[skeleton->bone_nodes_[bone]] * skeleton->bone_offsets_[bone];
+
+            glm::vec3* positions = &bake.positions_[frame * bake.vertex_count_];
+            glm::vec3* normals   = &bake.normals_[frame * bake.vertex_count_];
+            for (size_t i = 0; i < rest_vertices.size(); i++) {
+                const RestVertex& rest = rest_vertices[i];
+                glm::mat4 transform(0.0f);
+                if (rest.skinned_) {
+                    for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                        if (rest.bone_ids_[k] < bone_count)
+                            transform += palette[rest.bone_ids_[k]] * rest.weights_[k];
+                } else {
+                    transform = global_transforms[rest.node_];
+                }
+                positions[i] = glm::vec3(transform * glm::vec4(rest.position_, 1.0f));
+                const glm::vec3 normal = glm::mat3(transform) * rest.normal_;
+                normals[i] = glm::length(normal) > 0.0f ? glm::normalize(normal) : rest.normal_;
+            }
+        });
+        return bake;
+    }
+
+    VertexAnimationTexture::~VertexAnimationTexture() {
+        deleteTexture();
+    }
+
+    std::shared_ptr<VertexAnimationTexture> VertexAnimationTexture::create(const VertexAnimationBake& bake) {
+        if (!bake.isValid())
+            return nullptr;
+        GLint max_texture_size = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+        if (bake.height_ > static_cast<uint32_t>(max_texture_size)) {
+            std::cout << "Error::VertexAnimationTexture::Too_Many_Frames " << bake.frame_count_ << std::endl;
+            return nullptr;
+        }
+
+        std::shared_ptr<VertexAnimationTexture> texture = std::make_shared<VertexAnimationTexture>();
+        texture->first_vertex_ = bake.first_vertex_;
+        texture->vertex_count_ = bake.vertex_count_;
+        texture->frame_count_  = bake.frame_count_;
+        texture->frame_rate_   = bake.frame_rate_;
+        auto upload = [&bake](GLuint& texture_id, GLint internal_format, const std::vector<glm::vec3>& texels) {
+            glGenTextures(1, &texture_id);
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, bake.width_, bake.height_, 0, GL_RGB, GL_FLOAT, texels.data());
+            // read with texelFetch only, no filtering and no mipmaps
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        };
+        // positions need full precision at model scale, normals are fine as halves
+        upload(texture->position_texture_id_, GL_RGB32F, bake.positions_);
+        upload(texture->normal_texture_id_, GL_RGB16F, bake.normals_);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+
+    void VertexAnimationTexture::bind(ShaderProgram& shader_program) const {
+        glActiveTexture(GL_TEXTURE0 + VAT_POSITION_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, position_texture_id_);
+        glActiveTexture(GL_TEXTURE0 + VAT_NORMAL_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, normal_texture_id_);
+        glActiveTexture(GL_TEXTURE0);
+        shader_program.setTexture(VAT_POSITIONS_UNIFORM, VAT_POSITION_TEXTURE_UNIT);
+        shader_program.setTexture(VAT_NORMALS_UNIFORM, VAT_NORMAL_TEXTURE_UNIT);
+        shader_program.setUniform(VAT_FIRST_VERTEX_UNIFORM, static_cast<int>(first_vertex_));
+        shader_program.setUniform(VAT_VERTEX_COUNT_UNIFORM, static_cast<int>(vertex_count_));
+        shader_program.setUniform(VAT_FRAME_COUNT_UNIFORM, static_cast<int>(frame_count_));
+        shader_program.setUniform(VAT_FRAME_RATE_UNIFORM, frame_rate_);
+    }
+
+    void VertexAnimationTexture::deleteTexture() {
+        if (position_texture_id_ != 0)
+            glDeleteTextures(1, &position_texture_id_);
+        if (normal_texture_id_ != 0)
+            glDeleteTextures(1, &normal_texture_id_);
+        position_texture_id_ = normal_texture_id_ = 0;
+    }
+
+    VertexAnimationCrowd::~VertexAnimationCrowd() {
+        deleteBuffer();
+    }
+
+    /// @brief add a copy of the model
+    /// @param transform world transform of the space the model is skinned in
+    /// @param time_offset seconds into the clip, different offsets keep a crowd from moving in lockstep
+    /// @param speed playback rate
+    /// @return instance index
+    size_t VertexAnimationCrowd::addInstance(const glm::mat4& transform, float time_offset, float speed) {
+        instances_.push_back(Instance{transform, glm::vec2(time_offset, speed)});
+        dirty_ = true;
+        return instances_.size() - 1;
+    }
+
+    void VertexAnimationCrowd::setTransform(size_t instance, const glm::mat4& transform) {
+        instances_[instance].transform_ = transform;
+        dirty_ = true;
+    }
+
+    void VertexAnimationCrowd::draw(ShaderProgram& shader_program, Model& model, float time, size_t lod) {
+        if (instances_.empty() || model.getGeometry() == nullptr)
+            return;
+        if (dirty_)
+            upload();
+
+        // the instance stream is attached to the model's VAO for the draw, other draws of the model never read it
+        model.getGeometry()->bind();
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        // mat4 takes four vec4 locations
+        for (GLuint column = 0; column < 4; column++) {
+            glEnableVertexAttribArray(VAT_INSTANCE_ATTRIBUTE + column);
+            glVertexAttribPointer(VAT_INSTANCE_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  (void*)(offsetof(Instance, transform_) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(VAT_INSTANCE_ATTRIBUTE + column, 1);
+        }
+        glEnableVertexAttribArray(VAT_INSTANCE_ATTRIBUTE + 4);
+        glVertexAttribPointer(VAT_INSTANCE_ATTRIBUTE + 4, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, time_));
+        glVertexAttribDivisor(VAT_INSTANCE_ATTRIBUTE + 4, 1);
+
+        shader_program.setUniform(TIME_UNIFORM, time);
+        model.drawInstanced(shader_program, static_cast<GLsizei>(instances_.size()), lod);
+
+        model.getGeometry()->bind();
+        for (GLuint location = VAT_INSTANCE_ATTRIBUTE; location <= VAT_INSTANCE_ATTRIBUTE + 4; location++)
+            glDisableVertexAttribArray(location);
+        glBindVertexArray(0);
+    }
+
+    void VertexAnimationCrowd::upload() {
+        if (InstanceVBO == 0)
+            glGenBuffers(1, &InstanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        if (instances_.size() > vbo_capacity_) {
+            vbo_capacity_ = instances_.size();
+            glBufferData(GL_ARRAY_BUFFER, vbo_capacity_ * sizeof(Instance), instances_.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, instances_.size() * sizeof(Instance), instances_.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        dirty_ = false;
+    }
+
+    void VertexAnimationCrowd::deleteBuffer() {
+        if (InstanceVBO != 0)
+            glDeleteBuffers(1, &InstanceVBO);
+        InstanceVBO   = 0;
+        vbo_capacity_ = 0;
+        dirty_        = true;
+    }
+}
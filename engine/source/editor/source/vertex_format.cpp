@@ -0,0 +1,214 @@
+#include "editor/include/vertex_format.h"
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Hd2d {
+    static_assert(sizeof(CompactVertex) == 20, "CompactVertex must stay tightly packed");
+    static_assert(sizeof(CompactTangentFrameVertex) == 24, "CompactTangentFrameVertex must stay tightly packed");
+    static_assert(sizeof(SkinVertex) == 8, "SkinVertex must stay tightly packed");
+
+    size_t getVertexStride(VertexLayout layout) noexcept {
+        switch (layout) {
+            case VertexLayout::Compact:
+                return sizeof(CompactVertex);
+            case VertexLayout::CompactTangentFrame:
+                return sizeof(CompactTangentFrameVertex);
+            case VertexLayout::Full:
+            default:
+                return sizeof(Vertex);
+        }
+    }
+
+    size_t getIndexSize(IndexType type) noexcept {
+        return type == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    IndexType selectIndexType(size_t vertex_count) noexcept {
+        // index 0xFFFF is still a valid vertex, primitive restart is never enabled
+        return vertex_count <= 0x10000 ? IndexType::UInt16 : IndexType::UInt32;
+    }
+
+    std::vector<std::string> getShaderDefines(VertexLayout layout) {
+        switch (layout) {
+            case VertexLayout::Compact:
+                return {"HD2D_OCT_NORMAL"};
+            case VertexLayout::CompactTangentFrame:
+                return {"HD2D_QTANGENT"};
+            case VertexLayout::Full:
+            default:
+                return {};
+        }
+    }
+
+    /// @brief octahedral encoding of a unit vector
+    /// @param normal direction, need not be normalized
+    /// @return 2 x snorm16, x in the low half
+    uint32_t packOctNormal(const glm::vec3& normal) noexcept {
+        float l1_norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (l1_norm <= 0.0f)
+            return glm::packSnorm2x16(glm::vec2(0.0f, 0.0f));
+
+        glm::vec3 n = normal / l1_norm;
+        glm::vec2 encoded(n.x, n.y);
+        if (n.z < 0.0f) {
+            // fold the lower hemisphere over the diagonals
+            encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+            encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return glm::packSnorm2x16(encoded);
+    }
+
+    /// @brief encode a tangent frame as a single quaternion (qtangent)
+    /// @return 4 x snorm16 xyzw, w never zero and negative when the bitangent is mirrored
+    uint64_t packTangentFrame(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent) noexcept {
+        glm::vec3 n = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+        // Gram-Schmidt, falling back to any perpendicular for meshes without uvs
+        glm::vec3 t = tangent - n * glm::dot(n, tangent);
+        if (glm::length(t) < 1e-6f)
+            t = std::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+        t = glm::normalize(t);
+        glm::vec3 b = glm::cross(n, t);
+        float handedness = glm::dot(b, bitangent) < 0.0f ? -1.0f : 1.0f;
+
+        glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+        if (q.w < 0.0f)
+            q = -q;
+        // keep w away from zero so its sign survives snorm16 quantization
+        const float bias = 1.0f / 32767.0f;
+        if (q.w < bias) {
+            const float scale = std::sqrt(1.0f - bias * bias);
+            q = glm::quat(bias, q.x * scale, q.y * scale, q.z * scale);
+        }
+        if (handedness < 0.0f)
+            q = -q;
+        return glm::packSnorm4x16(glm::vec4(q.x, q.y, q.z, q.w));
+    }
+
+    /// @brief inverse of packOctNormal
+    /// @return unit vector
+    glm::vec3 unpackOctNormal(uint32_t packed) noexcept {
+        glm::vec2 encoded = glm::unpackSnorm2x16(packed);
+        glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+        if (n.z < 0.0f) {
+            n.x = (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f);
+            n.y = (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return glm::length(n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    glm::vec3 unpackTangentFrameNormal(uint64_t packed) noexcept {
+        glm::vec4 q = glm::unpackSnorm4x16(packed);
+        // the sign only carries the bitangent handedness, q and -q give the same basis
+        glm::quat frame = glm::normalize(glm::quat(q.w, q.x, q.y, q.z));
+        return glm::mat3_cast(frame)[2];
+    }
+
+    static SkinVertex packSkin(const Vertex& vertex) {
+        SkinVertex skin{};
+        int quantized_sum = 0;
+        int largest = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+            skin.boneIDs_[i] = static_cast<uint8_t>(std::clamp(vertex.boneIDs_[i], 0, 255));
+            int weight = static_cast<int>(std::lround(std::clamp(vertex.weights_[i], 0.0f, 1.0f) * 255.0f));
+            skin.weights_[i] = static_cast<uint8_t>(weight);
+            quantized_sum += weight;
+            if (weight > skin.weights_[largest])
+                largest = i;
+        }
+        // rounding must not change the total influence
+        if (quantized_sum > 0)
+            skin.weights_[largest] = static_cast<uint8_t>(std::clamp(skin.weights_[largest] + 255 - quantized_sum, 0, 255));
+        return skin;
+    }
+
+    void packVertexStreams(MeshData& mesh_data, VertexLayout layout) {
+        mesh_data.layout_ = layout;
+        mesh_data.packed_vertices_.clear();
+        mesh_data.skin_.clear();
+        if (layout == VertexLayout::Full)
+            return;
+
+        const std::vector<Vertex>& vertices = mesh_data.vertices_;
+        mesh_data.packed_vertices_.resize(vertices.size() * getVertexStride(layout));
+        unsigned char* packed = mesh_data.packed_vertices_.data();
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vertex& vertex = vertices[i];
+            if (layout == VertexLayout::Compact) {
+                CompactVertex compact;
+                compact.position_  = vertex.position_;
+                compact.normal_    = packOctNormal(vertex.normal_);
+                compact.texCoords_ = glm::packHalf2x16(vertex.texCoords_);
+                std::memcpy(packed + i * sizeof(compact), &compact, sizeof(compact));
+            } else {
+                CompactTangentFrameVertex compact;
+                compact.position_     = vertex.position_;
+                uint64_t tangent_frame = packTangentFrame(vertex.normal_, vertex.tangent_, vertex.bitangent_);
+                std::memcpy(compact.tangentFrame_, &tangent_frame, sizeof(tangent_frame));
+                compact.texCoords_    = glm::packHalf2x16(vertex.texCoords_);
+                std::memcpy(packed + i * sizeof(compact), &compact, sizeof(compact));
+            }
+        }
+
+        // static meshes get no skin stream at all
+        auto is_skinned = [](const Vertex& vertex) {
+            return std::any_of(std::begin(vertex.weights_), std::end(vertex.weights_), [](float w) { return w > 0.0f; });
+        };
+        if (std::any_of(vertices.begin(), vertices.end(), is_skinned)) {
+            mesh_data.skin_.reserve(vertices.size());
+            for (const Vertex& vertex : vertices)
+                mesh_data.skin_.push_back(packSkin(vertex));
+        }
+    }
+
+    void packIndexStream(MeshData& mesh_data) {
+        mesh_data.index_type_ = selectIndexType(mesh_data.vertices_.size());
+        mesh_data.packed_indices_.clear();
+        if (mesh_data.index_type_ == IndexType::UInt16)
+            mesh_data.packed_indices_.assign(mesh_data.indices_.begin(), mesh_data.indices_.end());
+    }
+
+    /// @brief quantize a mesh's positions and copy its indices for CPU side queries
+    /// @param vertex_streams streams in any layout, every layout starts with an fp32 position
+    /// @param index_stream indices, kept in their packed type
+    /// @return compressed copy, about a quarter of the Full layout
+    CompressedMeshCopy compressMeshCopy(const VertexStreamView& vertex_streams, const IndexStreamView& index_stream) {
+        CompressedMeshCopy copy;
+        const size_t stride = getVertexStride(vertex_streams.layout_);
+        const unsigned char* vertices = static_cast<const unsigned char*>(vertex_streams.vertices_);
+        auto position = [vertices, stride](size_t i) {
+            glm::vec3 p;
+            std::memcpy(&p, vertices + i * stride, sizeof(p));
+            return p;
+        };
+
+        glm::vec3 bounds_min( std::numeric_limits<float>::max());
+        glm::vec3 bounds_max(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < vertex_streams.vertex_count_; i++) {
+            bounds_min = glm::min(bounds_min, position(i));
+            bounds_max = glm::max(bounds_max, position(i));
+        }
+        if (vertex_streams.vertex_count_ > 0) {
+            copy.bounds_min_   = bounds_min;
+            copy.bounds_scale_ = (bounds_max - bounds_min) / 65535.0f;
+        }
+
+        copy.positions_.resize(vertex_streams.vertex_count_ * 3);
+        for (size_t i = 0; i < vertex_streams.vertex_count_; i++) {
+            glm::vec3 normalized = (position(i) - copy.bounds_min_) / glm::max(copy.bounds_scale_, glm::vec3(1e-30f));
+            for (int k = 0; k < 3; k++)
+                copy.positions_[i * 3 + k] = static_cast<uint16_t>(glm::clamp(std::round(normalized[k]), 0.0f, 65535.0f));
+        }
+
+        copy.index_type_ = index_stream.type_;
+        const unsigned char* indices = static_cast<const unsigned char*>(index_stream.indices_);
+        copy.indices_.assign(indices, indices + index_stream.index_count_ * getIndexSize(index_stream.type_));
+        return copy;
+    }
+}
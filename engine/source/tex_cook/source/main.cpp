@@ -0,0 +1,402 @@
+#include "editor/include/asset_database.h"
+#include "editor/include/environment_bake.h"
+#include "editor/include/sprite_atlas_cook.h"
+#include "editor/include/texture_cook.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+using namespace Hd2d;
+
+namespace {
+    void printUsage() {
+        std::cout << "usage: Hd2dTexCook [--format auto|bc1|bc3|bc4|bc5|bc7] [--linear] [--no-mips] [--premultiply] <input image> [output.cpt]\n"
+                     "       Hd2dTexCook --atlas <output.hd2datlas> [--page-size N] [--padding N] [--no-trim] [--no-dedupe]\n"
+                     "                   [--format ...] [--linear] [--premultiply] <frame images...>\n"
+                     "       Hd2dTexCook --tree <directory> [--index <file>] [--format ...] [--linear] [--no-mips] [--premultiply]\n"
+                     "       Hd2dTexCook --environment [--index <file>] <+x> <-x> <+y> <-y> <+z> <-z>\n"
+                     "  --format   block format, auto picks from the channels and alpha of the input\n"
+                     "  --linear   filter mips without the sRGB curve, for normal, roughness and other data maps.\n"
+                     "             --tree decides per image without it, see below\n"
+                     "  --no-mips  write level 0 only\n"
+                     "  --premultiply  multiply color by alpha before filtering, draw with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)\n"
+                     "  output defaults to the input path with its extension replaced by .cpt\n"
+                     "  --atlas    pack the frames into pages written next to the atlas as <name>_<page>.cpt,\n"
+                     "             each frame is found at runtime by its file stem\n"
+                     "  --tree     cook every image under the directory next to itself, skipping those whose source, settings\n"
+                     "             and cooker are unchanged since the last cook. --index defaults to <directory>/asset_index.hd2ddb.\n"
+                     "             images a .mtl uses as map_Kd are color, as map_Ks, map_Bump or map_Ka data, like the\n"
+                     "             model loader samples them. others are data when named *_ddn, *_normal, *_spec, ... else color\n"
+                     "  --environment  bake SH ambient and prefiltered specular levels of a skybox next to its faces,\n"
+                     "             with --index only when the faces changed since the bake recorded there\n"
+                     "  --mips     with --atlas, give pages a mip chain, they have level 0 only by default" << std::endl;
+    }
+
+    bool parseCount(const char* text, uint32_t& count) {
+        char* end = nullptr;
+        const unsigned long value = std::strtoul(text, &end, 10);
+        if (end == text || *end != '\0' || value > 0xffffu)
+            return false;
+        count = static_cast<uint32_t>(value);
+        return true;
+    }
+
+    int cookAtlas(const std::string& atlas_path, const std::vector<std::string>& frame_paths,
+                  const SpriteAtlasCookSettings& atlas_settings, const TextureCookSettings& page_settings) {
+        using ImagePixels = std::unique_ptr<unsigned char, void (*)(void*)>;
+        std::vector<ImagePixels> pixels;
+        std::vector<SpriteFrame> frames;
+        pixels.reserve(frame_paths.size());
+        frames.reserve(frame_paths.size());
+        for (const std::string& frame_path : frame_paths) {
+            int width = 0, height = 0, channels = 0;
+            pixels.emplace_back(stbi_load(frame_path.c_str(), &width, &height, &channels, 4), stbi_image_free);
+            if (!pixels.back()) {
+                std::cout << "Error::TexCook::IMAGE_File_Not_Successfully_Decoded " << frame_path << std::endl;
+                return 1;
+            }
+            SpriteFrame frame;
+            frame.name_   = std::filesystem::path(frame_path).stem().string();
+            frame.width_  = static_cast<uint32_t>(width);
+            frame.height_ = static_cast<uint32_t>(height);
+            frame.rgba_   = pixels.back().get();
+            frames.push_back(std::move(frame));
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        CookedSpriteAtlas atlas = cookSpriteAtlas(frames, atlas_settings);
+        if (!atlas.isValid() || !writeSpriteAtlas(atlas_path, atlas, page_settings))
+            return 1;
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // duplicates share a rect, count every rect once
+        std::set<std::tuple<uint16_t, uint16_t, uint16_t>> rects;
+        size_t used = 0, total = 0;
+        for (const SpriteAtlasSprite& sprite : atlas.sprites_)
+            if (rects.emplace(sprite.page_, sprite.x_, sprite.y_).second)
+                used += size_t(sprite.width_) * sprite.height_;
+        for (const SpriteAtlasPage& page : atlas.pages_)
+            total += size_t(page.width_) * page.height_;
+        std::cout << frames.size() << " frames, " << atlas.unique_frames_ << " unique -> " << atlas_path << " "
+                  << atlas.pages_.size() << " pages";
+        for (const SpriteAtlasPage& page : atlas.pages_)
+            std::cout << " " << page.width_ << "x" << page.height_;
+        std::cout << ", " << (total > 0 ? 100.0 * double(used) / double(total) : 0.0) << "% covered in " << elapsed << " ms" << std::endl;
+        return 0;
+    }
+
+    std::string toLower(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    bool isImageFile(const std::filesystem::path& path) {
+        const std::string extension = toLower(path.extension().string());
+        return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+    }
+
+    // how the editor samples an image, only diffuse maps are filtered in linear light (see Model::startTextureDecodes)
+    enum class TextureUsage : uint8_t {
+        Unknown,
+        Color,
+        Data,
+    };
+
+    /// @brief the usage of every image an OBJ material refers to, mapped the way the model loader maps them:
+    ///        map_Kd is diffuse, map_Ks specular, map_Bump/bump normal and map_Ka height
+    /// @param mtl_path material library
+    /// @param usages image path, lexically normal, to usage. an image used both ways stays color
+    void readMaterialUsages(const std::filesystem::path& mtl_path, std::unordered_map<std::string, TextureUsage>& usages) {
+        std::ifstream mtl_file(mtl_path);
+        std::string   line;
+        while (std::getline(mtl_file, line)) {
+            std::istringstream tokens(line);
+            std::string key;
+            if (!(tokens >> key))
+                continue;
+            key = toLower(key);
+            TextureUsage usage = TextureUsage::Unknown;
+            if (key == "map_kd")
+                usage = TextureUsage::Color;
+            else if (key == "map_ks" || key == "map_bump" || key == "bump" || key == "map_ka")
+                usage = TextureUsage::Data;
+            else
+                continue;
+            // options such as -bm 1 come first, the file name is last
+            std::string image_name;
+            for (std::string token; tokens >> token;)
+                image_name = token;
+            if (image_name.empty())
+                continue;
+            const std::string image_path = (mtl_path.parent_path() / image_name).lexically_normal().generic_string();
+            TextureUsage& known = usages[image_path];
+            if (known != TextureUsage::Color)
+                known = usage;
+        }
+    }
+
+    // for images no material names, the usual suffixes of normal, specular and other data maps
+    bool isDataImageName(const std::filesystem::path& image_path) {
+        static const char* DATA_SUFFIXES[] = {
+            "_ddn", "_nrm", "_norm", "_normal", "_spec", "_specular", "_height", "_bump", "_disp",
+            "_rough", "_roughness", "_metal", "_metallic", "_ao", "_occlusion",
+        };
+        const std::string stem = toLower(image_path.stem().string());
+        for (const char* suffix : DATA_SUFFIXES) {
+            const size_t suffix_length = std::strlen(suffix);
+            if (stem.size() > suffix_length && stem.compare(stem.size() - suffix_length, suffix_length, suffix) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    /// @brief cook every image under tree_path next to itself, each with the color space it is sampled in
+    /// @param settings shared settings, srgb_ false forces every image linear, else it is chosen per image
+    int cookTree(const std::string& tree_path, std::string index_path, const TextureCookSettings& settings) {
+        if (index_path.empty())
+            index_path = (std::filesystem::path{tree_path} / ASSET_INDEX_FILE_NAME).generic_string();
+        AssetDatabase& asset_database = AssetDatabase::getInstance();
+        asset_database.open(index_path);
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::filesystem::path> image_paths;
+        std::unordered_map<std::string, TextureUsage> usages;
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(tree_path, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (!it->is_regular_file())
+                continue;
+            if (isImageFile(it->path()))
+                image_paths.push_back(it->path());
+            else if (toLower(it->path().extension().string()) == ".mtl")
+                readMaterialUsages(it->path(), usages);
+        }
+        if (error) {
+            std::cout << "Error::TexCook::Directory_Not_Successfully_Read " << tree_path << std::endl;
+            return 1;
+        }
+
+        std::vector<AssetCookJob> jobs;
+        jobs.reserve(image_paths.size());
+        for (const std::filesystem::path& path : image_paths) {
+            TextureCookSettings image_settings = settings;
+            if (settings.srgb_) {
+                auto usage = usages.find(path.lexically_normal().generic_string());
+                image_settings.srgb_ = usage != usages.end() ? usage->second != TextureUsage::Data : !isDataImageName(path);
+            }
+            AssetCookJob job;
+            const std::string image_path = path.generic_string();
+            job.artifact_path_  = getCookedTexturePath(image_path);
+            job.dependencies_   = {image_path};
+            job.cooker_version_ = TEXTURE_COOKER_VERSION;
+            // a color map turning into a data map is cooked again
+            job.settings_hash_  = hashTextureCookSettings(image_settings);
+            job.cook_ = [image_path, artifact_path = job.artifact_path_, settings = image_settings]() {
+                int width = 0, height = 0, channels = 0;
+                std::unique_ptr<unsigned char, void (*)(void*)> pixels(stbi_load(image_path.c_str(), &width, &height, &channels, 0), stbi_image_free);
+                if (!pixels) {
+                    std::cout << "Error::TexCook::IMAGE_File_Not_Successfully_Decoded " << image_path << std::endl;
+                    return false;
+                }
+                CookedTexture cooked = cookTexture(pixels.get(), width, height, channels, settings);
+                if (!cooked.isValid() || !writeCptFile(artifact_path, cooked))
+                    return false;
+                std::cout << image_path << " -> " << artifact_path << std::endl;
+                return true;
+            };
+            jobs.push_back(std::move(job));
+        }
+
+        size_t failed = 0;
+        const size_t cooked = asset_database.cookOutdated(jobs, failed);
+        const bool saved = asset_database.save();
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << jobs.size() << " images, " << cooked << " cooked, " << failed << " failed, "
+                  << jobs.size() - cooked - failed << " up to date in " << elapsed << " ms" << std::endl;
+        return failed == 0 && saved ? 0 : 1;
+    }
+
+    int bakeEnvironmentFaces(const std::vector<std::string>& face_paths, const std::string& index_path) {
+        AssetDatabase& asset_database = AssetDatabase::getInstance();
+        const EnvironmentBakeSettings settings;
+        const std::string environment_path = getEnvironmentPath(face_paths[0]);
+        const uint64_t    settings_hash    = hashEnvironmentBakeSettings(settings);
+        if (asset_database.open(index_path) &&
+            asset_database.isUpToDate(environment_path, face_paths, ENVIRONMENT_BAKE_VERSION, settings_hash)) {
+            std::cout << environment_path << " is up to date" << std::endl;
+            return 0;
+        }
+
+        std::vector<std::unique_ptr<unsigned char, void (*)(void*)>> pixels;
+        std::array<EnvironmentFace, 6> faces;
+        for (size_t i = 0; i < faces.size(); i++) {
+            EnvironmentFace& face = faces[i];
+            pixels.emplace_back(stbi_load(face_paths[i].c_str(), &face.width_, &face.height_, &face.channels_, 0), stbi_image_free);
+            if (!pixels.back()) {
+                std::cout << "Error::TexCook::IMAGE_File_Not_Successfully_Decoded " << face_paths[i] << std::endl;
+                return 1;
+            }
+            face.pixels_ = pixels.back().get();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        BakedEnvironment environment = bakeEnvironment(faces, settings);
+        if (!environment.isValid() || !writeEnvironmentFile(environment_path, environment))
+            return 1;
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!index_path.empty()) {
+            asset_database.record(environment_path, face_paths, ENVIRONMENT_BAKE_VERSION, settings_hash);
+            if (!asset_database.save())
+                return 1;
+        }
+        std::cout << face_paths[0] << " ... -> " << environment_path << " " << environment.header_.face_size_ << " texel faces, "
+                  << environment.header_.mip_count_ << " levels in " << elapsed << " ms" << std::endl;
+        return 0;
+    }
+
+    bool parseFormat(const char* name, CptFormat& format) {
+        static const struct { const char* name_; CptFormat format_; } FORMATS[] = {
+            {"auto", CptFormat::Unknown}, {"bc1", CptFormat::BC1}, {"bc3", CptFormat::BC3},
+            {"bc4", CptFormat::BC4},      {"bc5", CptFormat::BC5}, {"bc7", CptFormat::BC7},
+        };
+        for (const auto& entry : FORMATS) {
+            if (std::strcmp(name, entry.name_) == 0) {
+                format = entry.format_;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main(int argc, char** argv) {
+    TextureCookSettings settings;
+    std::string input_path;
+    std::string output_path;
+    std::string atlas_path;
+    std::string tree_path;
+    std::string index_path;
+    std::vector<std::string> frame_paths;
+    SpriteAtlasCookSettings atlas_settings;
+    bool page_mips = false;
+    bool environment = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!parseFormat(argv[++i], settings.format_)) {
+                std::cout << "Error::TexCook::Unknown_Format " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--linear") == 0)
+            settings.srgb_ = false;
+        else if (std::strcmp(argv[i], "--no-mips") == 0)
+            settings.mip_chain_ = false;
+        else if (std::strcmp(argv[i], "--premultiply") == 0)
+            settings.premultiply_alpha_ = true;
+        else if (std::strcmp(argv[i], "--atlas") == 0 && i + 1 < argc)
+            atlas_path = argv[++i];
+        else if (std::strcmp(argv[i], "--tree") == 0 && i + 1 < argc)
+            tree_path = argv[++i];
+        else if (std::strcmp(argv[i], "--environment") == 0)
+            environment = true;
+        else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+            index_path = argv[++i];
+        else if (std::strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) {
+            if (!parseCount(argv[++i], atlas_settings.max_page_size_) || atlas_settings.max_page_size_ < 4) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--padding") == 0 && i + 1 < argc) {
+            if (!parseCount(argv[++i], atlas_settings.padding_)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--no-trim") == 0)
+            atlas_settings.trim_ = false;
+        else if (std::strcmp(argv[i], "--no-dedupe") == 0)
+            atlas_settings.dedupe_ = false;
+        else if (std::strcmp(argv[i], "--mips") == 0)
+            page_mips = true;
+        else if (argv[i][0] == '-') {
+            printUsage();
+            return 1;
+        }
+        else if (!atlas_path.empty() || environment)
+            frame_paths.push_back(argv[i]);
+        else if (input_path.empty())
+            input_path = argv[i];
+        else if (output_path.empty())
+            output_path = argv[i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!tree_path.empty()) {
+        if (!input_path.empty() || !atlas_path.empty()) {
+            printUsage();
+            return 1;
+        }
+        return cookTree(tree_path, index_path, settings);
+    }
+    if (environment) {
+        if (!atlas_path.empty() || frame_paths.size() != 6) {
+            printUsage();
+            return 1;
+        }
+        return bakeEnvironmentFaces(frame_paths, index_path);
+    }
+    if (!atlas_path.empty()) {
+        if (!input_path.empty() || frame_paths.empty()) {
+            printUsage();
+            return 1;
+        }
+        // sprites are drawn near texel size, a mip chain only costs memory and bleeds neighbours at small levels
+        settings.mip_chain_ = page_mips;
+        return cookAtlas(atlas_path, frame_paths, atlas_settings, settings);
+    }
+    if (input_path.empty()) {
+        printUsage();
+        return 1;
+    }
+    if (output_path.empty())
+        output_path = getCookedTexturePath(input_path);
+
+    int width = 0, height = 0, channels = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels(stbi_load(input_path.c_str(), &width, &height, &channels, 0), stbi_image_free);
+    if (!pixels) {
+        std::cout << "Error::TexCook::IMAGE_File_Not_Successfully_Decoded " << input_path << std::endl;
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    CookedTexture cooked = cookTexture(pixels.get(), width, height, channels, settings);
+    if (!cooked.isValid() || !writeCptFile(output_path, cooked))
+        return 1;
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    static const char* FORMAT_NAMES[] = {"auto", "bc1", "bc3", "bc4", "bc5", "bc7"};
+    std::cout << input_path << " " << width << "x" << height << "x" << channels << " -> " << output_path << " "
+              << FORMAT_NAMES[cooked.head_.format_] << (cooked.head_.flags_ & CPT_FLAG_SRGB ? " srgb" : " linear") << ", "
+              << cooked.head_.mip_count_ << " mips, " << cooked.head_.data_size_ << " bytes in " << elapsed << " ms" << std::endl;
+    return 0;
+}